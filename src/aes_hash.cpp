@@ -26,8 +26,10 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include "aes_hash.hpp"
 #include "soft_aes.h"
 #include "cpu.hpp"
+#include "dispatch.hpp"
 #include <cassert>
 
 #ifdef __riscv
@@ -35,22 +37,21 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "aes_hash_rv64_vector.hpp"
 #endif
 
+//256-bit kernels selected for this CPU, all nullptr if the 128-bit code below should be used.
+//The VAES kernels are only used by virtual machines created with RANDOMX_FLAG_VAES.
+template<bool softAes>
+static const randomx::AesKernels& wideAes() {
+	static const randomx::AesKernels none{};
+	if (!softAes) {
+		return none;
+	}
+	return randomx::getSoftAesImpl() == randomx::SoftAesImpl::Vperm ? randomx::getDispatchTable().softAes : none;
+}
+
 //NOTE: The functions below were tuned for maximum performance
 //and are not cryptographically secure outside of the scope of RandomX.
 //It's not recommended to use them as general hash functions and PRNGs.
 
-//AesHash1R:
-//state0, state1, state2, state3 = Blake2b-512("RandomX AesHash1R state")
-//xkey0, xkey1 = Blake2b-256("RandomX AesHash1R xkeys")
-
-#define AES_HASH_1R_STATE0 0xd7983aad, 0xcc82db47, 0x9fa856de, 0x92b52c0d
-#define AES_HASH_1R_STATE1 0xace78057, 0xf59e125a, 0x15c7b798, 0x338d996e
-#define AES_HASH_1R_STATE2 0xe8a07ce4, 0x5079506b, 0xae62c7d0, 0x6a770017
-#define AES_HASH_1R_STATE3 0x7e994948, 0x79a10005, 0x07ad828d, 0x630a240c
-
-#define AES_HASH_1R_XKEY0 0x06890201, 0x90dc56bf, 0x8b24949f, 0xf6fa8389
-#define AES_HASH_1R_XKEY1 0xed18f99b, 0xee1043c6, 0x51f4e03c, 0x61b263d1
-
 /*
 	Calculate a 512-bit hash of 'input' using 4 lanes of AES.
 	The input is treated as a set of round keys for the encryption
@@ -64,21 +65,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 	Hashing throughput: >20 GiB/s per CPU core with hardware AES
 */
 template<bool softAes>
-void hashAes1Rx4(const void *input, size_t inputSize, void *hash) {
+void hashAes1Rx4Vec128(const void *input, size_t inputSize, void *hash) {
 	assert(inputSize % 64 == 0);
 
-#ifdef __riscv
-	if (!softAes) {
-		hashAes1Rx4_zvkned(input, inputSize, hash);
-		return;
-	}
-
-	if (randomx::cpu.hasRVV() && (randomx::cpu.getRVV_Length() >= 256)) {
-		hashAes1Rx4_RVV(input, inputSize, hash);
-		return;
-	}
-#endif
-
 	const uint8_t* inptr = (uint8_t*)input;
 	const uint8_t* inputEnd = inptr + inputSize;
 
@@ -127,16 +116,35 @@ void hashAes1Rx4(const void *input, size_t inputSize, void *hash) {
 	rx_store_vec_i128((rx_vec_i128*)hash + 3, state3);
 }
 
-template void hashAes1Rx4<false>(const void *input, size_t inputSize, void *hash);
-template void hashAes1Rx4<true>(const void *input, size_t inputSize, void *hash);
+template void hashAes1Rx4Vec128<false>(const void *input, size_t inputSize, void *hash);
+template void hashAes1Rx4Vec128<true>(const void *input, size_t inputSize, void *hash);
 
-//AesGenerator1R:
-//key0, key1, key2, key3 = Blake2b-512("RandomX AesGenerator1R keys")
+template<bool softAes>
+void hashAes1Rx4(const void *input, size_t inputSize, void *hash) {
+	assert(inputSize % 64 == 0);
 
-#define AES_GEN_1R_KEY0 0xb4f44917, 0xdbb5552b, 0x62716609, 0x6daca553
-#define AES_GEN_1R_KEY1 0x0da1dc4e, 0x1725d378, 0x846a710d, 0x6d7caf07
-#define AES_GEN_1R_KEY2 0x3e20e345, 0xf4c0794f, 0x9f947ec6, 0x3f1262f1
-#define AES_GEN_1R_KEY3 0x49169154, 0x16314c88, 0xb1ba317c, 0x6aef8135
+#ifdef __riscv
+	if (!softAes) {
+		hashAes1Rx4_zvkned(input, inputSize, hash);
+		return;
+	}
+
+	if (randomx::cpu.hasRVV() && (randomx::cpu.getRVV_Length() >= 256)) {
+		hashAes1Rx4_RVV(input, inputSize, hash);
+		return;
+	}
+#endif
+	auto wide = wideAes<softAes>().hashAes1Rx4;
+	if (wide != nullptr) {
+		wide(input, inputSize, hash);
+		return;
+	}
+
+	hashAes1Rx4Vec128<softAes>(input, inputSize, hash);
+}
+
+template void hashAes1Rx4<false>(const void *input, size_t inputSize, void *hash);
+template void hashAes1Rx4<true>(const void *input, size_t inputSize, void *hash);
 
 /*
 	Fill 'buffer' with pseudorandom data based on 512-bit 'state'.
@@ -149,21 +157,9 @@ template void hashAes1Rx4<true>(const void *input, size_t inputSize, void *hash)
 	calls to this function.
 */
 template<bool softAes>
-void fillAes1Rx4(void *state, size_t outputSize, void *buffer) {
+void fillAes1Rx4Vec128(void *state, size_t outputSize, void *buffer) {
 	assert(outputSize % 64 == 0);
 
-#ifdef __riscv
-	if (!softAes) {
-		fillAes1Rx4_zvkned(state, outputSize, buffer);
-		return;
-	}
-
-	if (randomx::cpu.hasRVV() && (randomx::cpu.getRVV_Length() >= 256)) {
-		fillAes1Rx4_RVV(state, outputSize, buffer);
-		return;
-	}
-#endif
-
 	const uint8_t* outptr = (uint8_t*)buffer;
 	const uint8_t* outputEnd = outptr + outputSize;
 
@@ -200,37 +196,39 @@ void fillAes1Rx4(void *state, size_t outputSize, void *buffer) {
 	rx_store_vec_i128((rx_vec_i128*)state + 3, state3);
 }
 
-template void fillAes1Rx4<true>(void *state, size_t outputSize, void *buffer);
-template void fillAes1Rx4<false>(void *state, size_t outputSize, void *buffer);
-
-//AesGenerator4R:
-//key0, key1, key2, key3 = Blake2b-512("RandomX AesGenerator4R keys 0-3")
-//key4, key5, key6, key7 = Blake2b-512("RandomX AesGenerator4R keys 4-7")
-
-#define AES_GEN_4R_KEY0 0x99e5d23f, 0x2f546d2b, 0xd1833ddb, 0x6421aadd
-#define AES_GEN_4R_KEY1 0xa5dfcde5, 0x06f79d53, 0xb6913f55, 0xb20e3450
-#define AES_GEN_4R_KEY2 0x171c02bf, 0x0aa4679f, 0x515e7baf, 0x5c3ed904
-#define AES_GEN_4R_KEY3 0xd8ded291, 0xcd673785, 0xe78f5d08, 0x85623763
-#define AES_GEN_4R_KEY4 0x229effb4, 0x3d518b6d, 0xe3d6a7a6, 0xb5826f73
-#define AES_GEN_4R_KEY5 0xb272b7d2, 0xe9024d4e, 0x9c10b3d9, 0xc7566bf3
-#define AES_GEN_4R_KEY6 0xf63befa7, 0x2ba9660a, 0xf765a38b, 0xf273c9e7
-#define AES_GEN_4R_KEY7 0xc0b0762d, 0x0c06d1fd, 0x915839de, 0x7a7cd609
+template void fillAes1Rx4Vec128<true>(void *state, size_t outputSize, void *buffer);
+template void fillAes1Rx4Vec128<false>(void *state, size_t outputSize, void *buffer);
 
 template<bool softAes>
-void fillAes4Rx4(void *state, size_t outputSize, void *buffer) {
+void fillAes1Rx4(void *state, size_t outputSize, void *buffer) {
 	assert(outputSize % 64 == 0);
 
 #ifdef __riscv
 	if (!softAes) {
-		fillAes4Rx4_zvkned(state, outputSize, buffer);
+		fillAes1Rx4_zvkned(state, outputSize, buffer);
 		return;
 	}
 
 	if (randomx::cpu.hasRVV() && (randomx::cpu.getRVV_Length() >= 256)) {
-		fillAes4Rx4_RVV(state, outputSize, buffer);
+		fillAes1Rx4_RVV(state, outputSize, buffer);
 		return;
 	}
 #endif
+	auto wide = wideAes<softAes>().fillAes1Rx4;
+	if (wide != nullptr) {
+		wide(state, outputSize, buffer);
+		return;
+	}
+
+	fillAes1Rx4Vec128<softAes>(state, outputSize, buffer);
+}
+
+template void fillAes1Rx4<true>(void *state, size_t outputSize, void *buffer);
+template void fillAes1Rx4<false>(void *state, size_t outputSize, void *buffer);
+
+template<bool softAes>
+void fillAes4Rx4Vec128(void *state, size_t outputSize, void *buffer) {
+	assert(outputSize % 64 == 0);
 
 	const uint8_t* outptr = (uint8_t*)buffer;
 	const uint8_t* outputEnd = outptr + outputSize;
@@ -282,23 +280,38 @@ void fillAes4Rx4(void *state, size_t outputSize, void *buffer) {
 	}
 }
 
-template void fillAes4Rx4<true>(void *state, size_t outputSize, void *buffer);
-template void fillAes4Rx4<false>(void *state, size_t outputSize, void *buffer);
+template void fillAes4Rx4Vec128<true>(void *state, size_t outputSize, void *buffer);
+template void fillAes4Rx4Vec128<false>(void *state, size_t outputSize, void *buffer);
 
 template<bool softAes>
-void hashAndFillAes1Rx4(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
+void fillAes4Rx4(void *state, size_t outputSize, void *buffer) {
+	assert(outputSize % 64 == 0);
+
 #ifdef __riscv
 	if (!softAes) {
-		hashAndFillAes1Rx4_zvkned(scratchpad, scratchpadSize, hash, fill_state);
+		fillAes4Rx4_zvkned(state, outputSize, buffer);
 		return;
 	}
 
 	if (randomx::cpu.hasRVV() && (randomx::cpu.getRVV_Length() >= 256)) {
-		hashAndFillAes1Rx4_RVV(scratchpad, scratchpadSize, hash, fill_state);
+		fillAes4Rx4_RVV(state, outputSize, buffer);
 		return;
 	}
 #endif
+	auto wide = wideAes<softAes>().fillAes4Rx4;
+	if (wide != nullptr) {
+		wide(state, outputSize, buffer);
+		return;
+	}
+
+	fillAes4Rx4Vec128<softAes>(state, outputSize, buffer);
+}
+
+template void fillAes4Rx4<true>(void *state, size_t outputSize, void *buffer);
+template void fillAes4Rx4<false>(void *state, size_t outputSize, void *buffer);
 
+template<bool softAes>
+void hashAndFillAes1Rx4Vec128(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
 	uint8_t* scratchpadPtr = (uint8_t*)scratchpad;
 	const uint8_t* scratchpadEnd = scratchpadPtr + scratchpadSize;
 
@@ -375,5 +388,30 @@ void hashAndFillAes1Rx4(void *scratchpad, size_t scratchpadSize, void *hash, voi
 	rx_store_vec_i128((rx_vec_i128*)hash + 3, hash_state3);
 }
 
+template void hashAndFillAes1Rx4Vec128<false>(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state);
+template void hashAndFillAes1Rx4Vec128<true>(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state);
+
+template<bool softAes>
+void hashAndFillAes1Rx4(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
+#ifdef __riscv
+	if (!softAes) {
+		hashAndFillAes1Rx4_zvkned(scratchpad, scratchpadSize, hash, fill_state);
+		return;
+	}
+
+	if (randomx::cpu.hasRVV() && (randomx::cpu.getRVV_Length() >= 256)) {
+		hashAndFillAes1Rx4_RVV(scratchpad, scratchpadSize, hash, fill_state);
+		return;
+	}
+#endif
+	auto wide = wideAes<softAes>().hashAndFillAes1Rx4;
+	if (wide != nullptr) {
+		wide(scratchpad, scratchpadSize, hash, fill_state);
+		return;
+	}
+
+	hashAndFillAes1Rx4Vec128<softAes>(scratchpad, scratchpadSize, hash, fill_state);
+}
+
 template void hashAndFillAes1Rx4<false>(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state);
 template void hashAndFillAes1Rx4<true>(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state);
@@ -0,0 +1,195 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "aes_hash.hpp"
+#include "intrin_portable.h"
+
+#include <immintrin.h>
+
+namespace randomx {
+
+	/*
+		The four AES columns alternate between encryption and decryption, so
+		columns 0 and 2 share one ymm register and columns 1 and 3 share the other.
+		This keeps the dependency chains free of blends; the 64-byte memory layout
+		(column 0, 1, 2, 3) is restored with vperm2i128 outside of the chains.
+
+		The rounds are supplied by the Aes class (static enc/dec working on two
+		128-bit lanes), so VAES and the AVX2 software AES share these kernels.
+		Must only be included by files compiled with AVX2.
+	*/
+
+	static FORCE_INLINE __m256i pair128(rx_vec_i128 lo, rx_vec_i128 hi) {
+		return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+	}
+
+	static FORCE_INLINE void load4x128(const void* ptr, __m256i& cols02, __m256i& cols13) {
+		__m256i cols01 = _mm256_loadu_si256((const __m256i*)ptr + 0);
+		__m256i cols23 = _mm256_loadu_si256((const __m256i*)ptr + 1);
+		cols02 = _mm256_permute2x128_si256(cols01, cols23, 0x20);
+		cols13 = _mm256_permute2x128_si256(cols01, cols23, 0x31);
+	}
+
+	static FORCE_INLINE void store4x128(void* ptr, __m256i cols02, __m256i cols13) {
+		_mm256_storeu_si256((__m256i*)ptr + 0, _mm256_permute2x128_si256(cols02, cols13, 0x20));
+		_mm256_storeu_si256((__m256i*)ptr + 1, _mm256_permute2x128_si256(cols02, cols13, 0x31));
+	}
+
+	template<class Aes>
+	static FORCE_INLINE void hashAes1Rx4Avx2(const void *input, size_t inputSize, void *hash) {
+		const uint8_t* inptr = (const uint8_t*)input;
+		const uint8_t* inputEnd = inptr + inputSize;
+
+		__m256i state02 = pair128(rx_set_int_vec_i128(AES_HASH_1R_STATE0), rx_set_int_vec_i128(AES_HASH_1R_STATE2));
+		__m256i state13 = pair128(rx_set_int_vec_i128(AES_HASH_1R_STATE1), rx_set_int_vec_i128(AES_HASH_1R_STATE3));
+		__m256i in02, in13;
+
+		while (inptr < inputEnd) {
+			load4x128(inptr, in02, in13);
+			state02 = Aes::enc(state02, in02);
+			state13 = Aes::dec(state13, in13);
+			inptr += 64;
+		}
+
+		const __m256i xkey0 = _mm256_broadcastsi128_si256(rx_set_int_vec_i128(AES_HASH_1R_XKEY0));
+		const __m256i xkey1 = _mm256_broadcastsi128_si256(rx_set_int_vec_i128(AES_HASH_1R_XKEY1));
+
+		state02 = Aes::enc(state02, xkey0);
+		state13 = Aes::dec(state13, xkey0);
+		state02 = Aes::enc(state02, xkey1);
+		state13 = Aes::dec(state13, xkey1);
+
+		store4x128(hash, state02, state13);
+	}
+
+	template<class Aes>
+	static FORCE_INLINE void fillAes1Rx4Avx2(void *state, size_t outputSize, void *buffer) {
+		uint8_t* outptr = (uint8_t*)buffer;
+		const uint8_t* outputEnd = outptr + outputSize;
+
+		const __m256i key02 = pair128(rx_set_int_vec_i128(AES_GEN_1R_KEY0), rx_set_int_vec_i128(AES_GEN_1R_KEY2));
+		const __m256i key13 = pair128(rx_set_int_vec_i128(AES_GEN_1R_KEY1), rx_set_int_vec_i128(AES_GEN_1R_KEY3));
+		__m256i state02, state13;
+
+		load4x128(state, state02, state13);
+
+		while (outptr < outputEnd) {
+			state02 = Aes::dec(state02, key02);
+			state13 = Aes::enc(state13, key13);
+			store4x128(outptr, state02, state13);
+			outptr += 64;
+		}
+
+		store4x128(state, state02, state13);
+	}
+
+	template<class Aes>
+	static FORCE_INLINE void fillAes4Rx4Avx2(void *state, size_t outputSize, void *buffer) {
+		uint8_t* outptr = (uint8_t*)buffer;
+		const uint8_t* outputEnd = outptr + outputSize;
+
+		//columns 0 and 1 use keys 0-3, columns 2 and 3 use keys 4-7
+		const __m256i key04 = pair128(rx_set_int_vec_i128(AES_GEN_4R_KEY0), rx_set_int_vec_i128(AES_GEN_4R_KEY4));
+		const __m256i key15 = pair128(rx_set_int_vec_i128(AES_GEN_4R_KEY1), rx_set_int_vec_i128(AES_GEN_4R_KEY5));
+		const __m256i key26 = pair128(rx_set_int_vec_i128(AES_GEN_4R_KEY2), rx_set_int_vec_i128(AES_GEN_4R_KEY6));
+		const __m256i key37 = pair128(rx_set_int_vec_i128(AES_GEN_4R_KEY3), rx_set_int_vec_i128(AES_GEN_4R_KEY7));
+		__m256i state02, state13;
+
+		load4x128(state, state02, state13);
+
+		while (outptr < outputEnd) {
+			state02 = Aes::dec(state02, key04);
+			state13 = Aes::enc(state13, key04);
+
+			state02 = Aes::dec(state02, key15);
+			state13 = Aes::enc(state13, key15);
+
+			state02 = Aes::dec(state02, key26);
+			state13 = Aes::enc(state13, key26);
+
+			state02 = Aes::dec(state02, key37);
+			state13 = Aes::enc(state13, key37);
+
+			store4x128(outptr, state02, state13);
+			outptr += 64;
+		}
+	}
+
+	template<class Aes>
+	static FORCE_INLINE void hashAndFillAes1Rx4Avx2(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
+		uint8_t* scratchpadPtr = (uint8_t*)scratchpad;
+		const uint8_t* scratchpadEnd = scratchpadPtr + scratchpadSize;
+
+		__m256i hash_state02 = pair128(rx_set_int_vec_i128(AES_HASH_1R_STATE0), rx_set_int_vec_i128(AES_HASH_1R_STATE2));
+		__m256i hash_state13 = pair128(rx_set_int_vec_i128(AES_HASH_1R_STATE1), rx_set_int_vec_i128(AES_HASH_1R_STATE3));
+
+		const __m256i key02 = pair128(rx_set_int_vec_i128(AES_GEN_1R_KEY0), rx_set_int_vec_i128(AES_GEN_1R_KEY2));
+		const __m256i key13 = pair128(rx_set_int_vec_i128(AES_GEN_1R_KEY1), rx_set_int_vec_i128(AES_GEN_1R_KEY3));
+
+		__m256i fill_state02, fill_state13, in02, in13;
+		load4x128(fill_state, fill_state02, fill_state13);
+
+		constexpr int PREFETCH_DISTANCE = 4096;
+		const char* prefetchPtr = ((const char*)scratchpad) + PREFETCH_DISTANCE;
+		scratchpadEnd -= PREFETCH_DISTANCE;
+
+		for (int i = 0; i < 2; ++i) {
+			while (scratchpadPtr < scratchpadEnd) {
+				load4x128(scratchpadPtr, in02, in13);
+				hash_state02 = Aes::enc(hash_state02, in02);
+				hash_state13 = Aes::dec(hash_state13, in13);
+
+				fill_state02 = Aes::dec(fill_state02, key02);
+				fill_state13 = Aes::enc(fill_state13, key13);
+
+				store4x128(scratchpadPtr, fill_state02, fill_state13);
+
+				rx_prefetch_t0(prefetchPtr);
+
+				scratchpadPtr += 64;
+				prefetchPtr += 64;
+			}
+			prefetchPtr = (const char*) scratchpad;
+			scratchpadEnd += PREFETCH_DISTANCE;
+		}
+
+		store4x128(fill_state, fill_state02, fill_state13);
+
+		const __m256i xkey0 = _mm256_broadcastsi128_si256(rx_set_int_vec_i128(AES_HASH_1R_XKEY0));
+		const __m256i xkey1 = _mm256_broadcastsi128_si256(rx_set_int_vec_i128(AES_HASH_1R_XKEY1));
+
+		hash_state02 = Aes::enc(hash_state02, xkey0);
+		hash_state13 = Aes::dec(hash_state13, xkey0);
+		hash_state02 = Aes::enc(hash_state02, xkey1);
+		hash_state13 = Aes::dec(hash_state13, xkey1);
+
+		store4x128(hash, hash_state02, hash_state13);
+	}
+}
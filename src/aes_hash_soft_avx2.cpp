@@ -0,0 +1,85 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "aes_hash.hpp"
+#include "aes_hash_vaes.hpp"
+#include "soft_aes.h"
+#include "intrin_portable.h"
+
+#if defined(__AVX2__)
+
+#include "aes_hash_avx2.hpp"
+#include "soft_aes_vperm.hpp"
+
+//constant-time software AES, two columns per ymm register
+struct VpermRound {
+	static FORCE_INLINE __m256i enc(__m256i state, __m256i key) {
+		return randomx::vpermAesEnc<__m256i>(state, key);
+	}
+	static FORCE_INLINE __m256i dec(__m256i state, __m256i key) {
+		return randomx::vpermAesDec<__m256i>(state, key);
+	}
+};
+
+void hashAes1Rx4_soft_avx2(const void *input, size_t inputSize, void *hash) {
+	randomx::hashAes1Rx4Avx2<VpermRound>(input, inputSize, hash);
+}
+
+void fillAes1Rx4_soft_avx2(void *state, size_t outputSize, void *buffer) {
+	randomx::fillAes1Rx4Avx2<VpermRound>(state, outputSize, buffer);
+}
+
+void fillAes4Rx4_soft_avx2(void *state, size_t outputSize, void *buffer) {
+	randomx::fillAes4Rx4Avx2<VpermRound>(state, outputSize, buffer);
+}
+
+void hashAndFillAes1Rx4_soft_avx2(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
+	randomx::hashAndFillAes1Rx4Avx2<VpermRound>(scratchpad, scratchpadSize, hash, fill_state);
+}
+
+#else
+
+//the compiler doesn't support AVX2, fall back to the 128-bit code
+
+void hashAes1Rx4_soft_avx2(const void *input, size_t inputSize, void *hash) {
+	hashAes1Rx4Vec128<true>(input, inputSize, hash);
+}
+
+void fillAes1Rx4_soft_avx2(void *state, size_t outputSize, void *buffer) {
+	fillAes1Rx4Vec128<true>(state, outputSize, buffer);
+}
+
+void fillAes4Rx4_soft_avx2(void *state, size_t outputSize, void *buffer) {
+	fillAes4Rx4Vec128<true>(state, outputSize, buffer);
+}
+
+void hashAndFillAes1Rx4_soft_avx2(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
+	hashAndFillAes1Rx4Vec128<true>(scratchpad, scratchpadSize, hash, fill_state);
+}
+
+#endif
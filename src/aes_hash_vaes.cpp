@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "aes_hash.hpp"
+#include "aes_hash_vaes.hpp"
+#include "intrin_portable.h"
+
+#if defined(__VAES__) && defined(__AVX2__) || defined(_MSC_VER)
+
+#include "aes_hash_avx2.hpp"
+
+struct VaesRound {
+	static FORCE_INLINE __m256i enc(__m256i state, __m256i key) {
+		return _mm256_aesenc_epi128(state, key);
+	}
+	static FORCE_INLINE __m256i dec(__m256i state, __m256i key) {
+		return _mm256_aesdec_epi128(state, key);
+	}
+};
+
+void hashAes1Rx4_vaes(const void *input, size_t inputSize, void *hash) {
+	randomx::hashAes1Rx4Avx2<VaesRound>(input, inputSize, hash);
+}
+
+void fillAes1Rx4_vaes(void *state, size_t outputSize, void *buffer) {
+	randomx::fillAes1Rx4Avx2<VaesRound>(state, outputSize, buffer);
+}
+
+void fillAes4Rx4_vaes(void *state, size_t outputSize, void *buffer) {
+	randomx::fillAes4Rx4Avx2<VaesRound>(state, outputSize, buffer);
+}
+
+void hashAndFillAes1Rx4_vaes(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
+	randomx::hashAndFillAes1Rx4Avx2<VaesRound>(scratchpad, scratchpadSize, hash, fill_state);
+}
+
+#else
+
+//the compiler doesn't support VAES, fall back to the 128-bit code
+
+void hashAes1Rx4_vaes(const void *input, size_t inputSize, void *hash) {
+	hashAes1Rx4Vec128<false>(input, inputSize, hash);
+}
+
+void fillAes1Rx4_vaes(void *state, size_t outputSize, void *buffer) {
+	fillAes1Rx4Vec128<false>(state, outputSize, buffer);
+}
+
+void fillAes4Rx4_vaes(void *state, size_t outputSize, void *buffer) {
+	fillAes4Rx4Vec128<false>(state, outputSize, buffer);
+}
+
+void hashAndFillAes1Rx4_vaes(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
+	hashAndFillAes1Rx4Vec128<false>(scratchpad, scratchpadSize, hash, fill_state);
+}
+
+#endif
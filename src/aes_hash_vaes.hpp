@@ -0,0 +1,47 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define RANDOMX_HAVE_VAES
+#endif
+
+//256-bit VAES implementations, columns 0+2 and 1+3 are processed in one ymm register each
+void hashAes1Rx4_vaes(const void *input, size_t inputSize, void *hash);
+void fillAes1Rx4_vaes(void *state, size_t outputSize, void *buffer);
+void fillAes4Rx4_vaes(void *state, size_t outputSize, void *buffer);
+void hashAndFillAes1Rx4_vaes(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state);
+
+//256-bit constant-time software AES (soft_aes_vperm.hpp) with the same layout, requires AVX2
+void hashAes1Rx4_soft_avx2(const void *input, size_t inputSize, void *hash);
+void fillAes1Rx4_soft_avx2(void *state, size_t outputSize, void *buffer);
+void fillAes4Rx4_soft_avx2(void *state, size_t outputSize, void *buffer);
+void hashAndFillAes1Rx4_soft_avx2(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state);
@@ -37,9 +37,12 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
     #include <mach/thread_policy.h>
   #endif
   #include <pthread.h>
+  #include <sched.h>
 #endif
 #include "affinity.hpp"
 
+namespace randomx {
+
 int
 set_thread_affinity(const unsigned &cpuid)
 {
@@ -77,22 +80,18 @@ set_thread_affinity(std::thread::native_handle_type thread,
 unsigned
 cpuid_from_mask(uint64_t mask, const unsigned &thread_index)
 {
-    static unsigned lookup[64];
-    static bool init = false;
-    if (init)
-        return lookup[thread_index];
     unsigned count_found = 0;
     for (unsigned i=0; i<64; i++)
     {
         if (1ULL & mask)
         {
-            lookup[count_found] = i;
+            if (count_found == thread_index)
+                return i;
             count_found++;
         }
         mask >>= 1;
     }
-    init = true;
-    return lookup[thread_index];
+    return 0;
 }
 
 std::string
@@ -115,3 +114,27 @@ mask_to_string(uint64_t mask)
     }
     return ss.str();
 }
+
+int
+set_thread_low_priority()
+{
+    int rc = -1;
+#if defined(_WIN32) || defined(__CYGWIN__)
+    rc = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE) ? 0 : -2;
+#elif defined(SCHED_IDLE)
+    struct sched_param param = {};
+    rc = pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#else
+    struct sched_param param = {};
+    int policy;
+    rc = pthread_getschedparam(pthread_self(), &policy, &param);
+    if (rc == 0)
+    {
+        param.sched_priority = sched_get_priority_min(policy);
+        rc = pthread_setschedparam(pthread_self(), policy, &param);
+    }
+#endif
+    return rc;
+}
+
+}
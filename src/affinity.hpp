@@ -29,11 +29,17 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <thread>
 #include <string>
 
+namespace randomx {
+
 int set_thread_affinity(const unsigned &cpuid);
 int set_thread_affinity(std::thread::native_handle_type thread,
         const unsigned &cpuid);
 unsigned cpuid_from_mask(uint64_t mask, const unsigned &thread_index);
 std::string mask_to_string(uint64_t mask);
+int set_thread_low_priority();
+
+}
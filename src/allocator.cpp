@@ -31,14 +31,17 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "intrin_portable.h"
 #include "virtual_memory.h"
 #include "common.hpp"
+#include "dataset_file.hpp"
 
 namespace randomx {
 
 	template<size_t alignment>
-	void* AlignedAllocator<alignment>::allocMemory(size_t count) {
+	void* AlignedAllocator<alignment>::allocMemory(size_t count, size_t* pageSize) {
 		void *mem = rx_aligned_alloc(count, alignment);
 		if (mem == nullptr)
 			throw std::bad_alloc();
+		if (pageSize != nullptr)
+			*pageSize = getPageSize();
 		return mem;
 	}
 
@@ -49,10 +52,13 @@ namespace randomx {
 
 	template struct AlignedAllocator<CacheLineSize>;
 
-	void* LargePageAllocator::allocMemory(size_t count) {
-		void *mem = allocLargePagesMemory(count);
+	void* LargePageAllocator::allocMemory(size_t count, size_t* pageSize) {
+		size_t size;
+		void *mem = allocLargePagesMemory(count, &size);
 		if (mem == nullptr)
 			throw std::bad_alloc();
+		if (pageSize != nullptr)
+			*pageSize = size;
 		return mem;
 	}
 
@@ -60,4 +66,50 @@ namespace randomx {
 		freePagedMemory(ptr, count);
 	};
 
+	void* PagedAllocator::allocMemory(size_t count, size_t* pageSize) {
+		void *mem = allocMemoryPages(count);
+		if (mem == nullptr)
+			throw std::bad_alloc();
+		if (pageSize != nullptr)
+			*pageSize = getPageSize();
+		return mem;
+	}
+
+	void PagedAllocator::freeMemory(void* ptr, size_t count) {
+		freePagedMemory(ptr, count);
+	}
+
+	void MappedFileAllocator::freeMemory(void* ptr, size_t count) {
+		unmapFileMemory(ptr, count);
+	}
+
+	void SharedMemoryAllocator::freeMemory(void* ptr, size_t count) {
+		releaseSharedSegment((uint8_t*)ptr - FileDataOffset, count);
+	}
+
+	void* UserAllocator::allocMemory(const randomx_allocator& allocator, size_t count, size_t alignment, randomx_memory_kind kind) {
+		void *mem = allocator.alloc(allocator.userData, count, alignment, kind);
+		if (mem == nullptr)
+			throw std::bad_alloc();
+		return mem;
+	}
+
+	void UserAllocator::freeMemory(const randomx_allocator& allocator, void* ptr, size_t count, randomx_memory_kind kind) {
+		if (ptr != nullptr)
+			allocator.free(allocator.userData, ptr, count, kind);
+	}
+
+	void* allocCodeMemory(const randomx_allocator& allocator, size_t size) {
+		if (allocator.alloc == nullptr)
+			return allocMemoryPages(size);
+		return allocator.alloc(allocator.userData, size, getPageSize(), RANDOMX_MEMORY_JIT);
+	}
+
+	void freeCodeMemory(const randomx_allocator& allocator, void* ptr, size_t size) {
+		if (allocator.alloc == nullptr)
+			freePagedMemory(ptr, size);
+		else if (ptr != nullptr)
+			allocator.free(allocator.userData, ptr, size, RANDOMX_MEMORY_JIT);
+	}
+
 }
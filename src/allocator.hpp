@@ -29,18 +29,50 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <cstddef>
+#include "randomx.h"
 
 namespace randomx {
 
+	//allocMemory stores the size of the pages backing the memory in 'pageSize' (if not null)
+
 	template<size_t alignment>
 	struct AlignedAllocator {
-		static void* allocMemory(size_t);
+		static void* allocMemory(size_t, size_t* pageSize = nullptr);
 		static void freeMemory(void*, size_t);
 	};
 
+	//the largest pages available, falls back to smaller pages (see allocLargePagesMemory)
 	struct LargePageAllocator {
-		static void* allocMemory(size_t);
+		static void* allocMemory(size_t, size_t* pageSize = nullptr);
+		static void freeMemory(void*, size_t);
+	};
+
+	//page-aligned memory from the OS, which can be bound to a NUMA node
+	struct PagedAllocator {
+		static void* allocMemory(size_t, size_t* pageSize = nullptr);
+		static void freeMemory(void*, size_t);
+	};
+
+	//memory mapped from a file; allocation is done by the file loading code
+	struct MappedFileAllocator {
 		static void freeMemory(void*, size_t);
 	};
 
+	//data of a shared memory segment, which starts after the segment header;
+	//allocation is done by the randomx_create_shared_* and randomx_attach_shared_* functions
+	struct SharedMemoryAllocator {
+		static void freeMemory(void*, size_t);
+	};
+
+	//memory from the callbacks passed to the *_ex API functions, which are stored by the owner
+	struct UserAllocator {
+		static void* allocMemory(const randomx_allocator&, size_t, size_t alignment, randomx_memory_kind);
+		static void freeMemory(const randomx_allocator&, void*, size_t, randomx_memory_kind);
+	};
+
+	//page-aligned memory for JIT code, from the user callbacks if allocator.alloc is set
+	//returns nullptr on failure
+	void* allocCodeMemory(const randomx_allocator& allocator, size_t size);
+	void freeCodeMemory(const randomx_allocator& allocator, void* ptr, size_t size);
+
 }
\ No newline at end of file
@@ -39,6 +39,18 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "endian.h"
 
+#define blake2b_IV          randomx_blake2b_IV
+#define blake2b_sigma       randomx_blake2b_sigma
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+	extern const uint64_t blake2b_IV[8];
+	extern const unsigned int blake2b_sigma[12][16];
+#if defined(__cplusplus)
+}
+#endif
+
 static FORCE_INLINE uint64_t load48(const void *src) {
 	const uint8_t *p = (const uint8_t *)src;
 	uint64_t w = *p++;
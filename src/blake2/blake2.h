@@ -92,6 +92,7 @@ extern "C" {
 #define blake2b_final       randomx_blake2b_final
 #define blake2b             randomx_blake2b
 #define blake2b_long        randomx_blake2b_long
+#define blake2b_4way        randomx_blake2b_4way
 
 	/* Streaming API */
 	int blake2b_init(blake2b_state *S, size_t outlen);
@@ -109,6 +110,26 @@ extern "C" {
 	int blake2b_long(void *out, size_t outlen, const void *in, size_t inlen);
 	/* Argon2 Team - End Code */
 
+	/* Hashes 4 unkeyed messages of equal length at once */
+	int blake2b_4way(void *const out[4], size_t outlen, const void *const in[4], size_t inlen);
+
+	/* SIMD compression functions, NULL if not supported by the compiler */
+	typedef void randomx_blake2b_compress_fn(blake2b_state *S, const uint8_t *block);
+
+	randomx_blake2b_compress_fn *randomx_blake2b_compress_sse41(void);
+	randomx_blake2b_compress_fn *randomx_blake2b_compress_avx2(void);
+
+	/* Multi-buffer hash functions, NULL if not supported by the compiler */
+	typedef void randomx_blake2b_4way_fn(void *const out[4], size_t outlen, const void *const in[4], size_t inlen);
+
+	randomx_blake2b_4way_fn *randomx_blake2b_4way_avx2(void);
+
+	/* The fastest compression function supported by the CPU, NULL selects the reference code */
+	randomx_blake2b_compress_fn *randomx_blake2b_select_compress(void);
+
+	/* The multi-buffer hash function supported by the CPU, NULL hashes the messages one by one */
+	randomx_blake2b_4way_fn *randomx_blake2b_select_4way(void);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -39,13 +39,13 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "blake2.h"
 #include "blake2-impl.h"
 
-static const uint64_t blake2b_IV[8] = {
+const uint64_t blake2b_IV[8] = {
 	UINT64_C(0x6a09e667f3bcc908), UINT64_C(0xbb67ae8584caa73b),
 	UINT64_C(0x3c6ef372fe94f82b), UINT64_C(0xa54ff53a5f1d36f1),
 	UINT64_C(0x510e527fade682d1), UINT64_C(0x9b05688c2b3e6c1f),
 	UINT64_C(0x1f83d9abfb41bd6b), UINT64_C(0x5be0cd19137e2179) };
 
-static const unsigned int blake2b_sigma[12][16] = {
+const unsigned int blake2b_sigma[12][16] = {
 	{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
 	{14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
 	{11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
@@ -179,7 +179,7 @@ int blake2b_init_key(blake2b_state *S, size_t outlen, const void *key, size_t ke
 	return 0;
 }
 
-static void blake2b_compress(blake2b_state *S, const uint8_t *block) {
+static void blake2b_compress_ref(blake2b_state *S, const uint8_t *block) {
 	uint64_t m[16];
 	uint64_t v[16];
 	unsigned int i, r;
@@ -237,6 +237,16 @@ static void blake2b_compress(blake2b_state *S, const uint8_t *block) {
 #undef ROUND
 }
 
+static FORCE_INLINE void blake2b_compress(blake2b_state *S, const uint8_t *block) {
+	randomx_blake2b_compress_fn *compress = randomx_blake2b_select_compress();
+	if (compress != NULL) {
+		compress(S, block);
+	}
+	else {
+		blake2b_compress_ref(S, block);
+	}
+}
+
 int blake2b_update(blake2b_state *S, const void *in, size_t inlen) {
 	const uint8_t *pin = (const uint8_t *)in;
 
@@ -346,6 +356,39 @@ fail:
 	return ret;
 }
 
+int blake2b_4way(void *const out[4], size_t outlen, const void *const in[4], size_t inlen) {
+	randomx_blake2b_4way_fn *hash4;
+	unsigned int i;
+
+	/* Verify parameters */
+	if (NULL == out || NULL == in) {
+		return -1;
+	}
+
+	if (outlen == 0 || outlen > BLAKE2B_OUTBYTES) {
+		return -1;
+	}
+
+	for (i = 0; i < 4; ++i) {
+		if (NULL == out[i] || (NULL == in[i] && inlen > 0)) {
+			return -1;
+		}
+	}
+
+	hash4 = randomx_blake2b_select_4way();
+	if (hash4 != NULL) {
+		hash4(out, outlen, in, inlen);
+		return 0;
+	}
+
+	for (i = 0; i < 4; ++i) {
+		if (blake2b(out[i], outlen, in[i], inlen, NULL, 0) < 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
 /* Argon2 Team - Begin Code */
 int blake2b_long(void *pout, size_t outlen, const void *in, size_t inlen) {
 	uint8_t *out = (uint8_t *)pout;
@@ -0,0 +1,218 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "blake2.h"
+
+void randomx_blake2b_compress_avx2_impl(blake2b_state *S, const uint8_t *block);
+void randomx_blake2b_4way_avx2_impl(void *const out[4], size_t outlen, const void *const in[4], size_t inlen);
+
+randomx_blake2b_compress_fn *randomx_blake2b_compress_avx2(void) {
+#if defined(__AVX2__)
+	return &randomx_blake2b_compress_avx2_impl;
+#endif
+	return NULL;
+}
+
+randomx_blake2b_4way_fn *randomx_blake2b_4way_avx2(void) {
+#if defined(__AVX2__)
+	return &randomx_blake2b_4way_avx2_impl;
+#endif
+	return NULL;
+}
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#include "blake2-impl.h"
+
+/* each row of the 4x4 state matrix is one vector, so one G_ROW step computes 4 G functions */
+
+#define ROTR32(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define ROTR24(x) _mm256_shuffle_epi8((x), r24)
+#define ROTR16(x) _mm256_shuffle_epi8((x), r16)
+#define ROTR63(x) _mm256_xor_si256(_mm256_srli_epi64((x), 63), _mm256_add_epi64((x), (x)))
+
+#define LOAD_MSG(i0, i1, i2, i3) _mm256_set_epi64x((int64_t)m[s[i3]], (int64_t)m[s[i2]], (int64_t)m[s[i1]], (int64_t)m[s[i0]])
+
+#define G_ROW(a, b, c, d, x, y)                                                \
+    do {                                                                       \
+        a = _mm256_add_epi64(_mm256_add_epi64(a, b), x);                       \
+        d = ROTR32(_mm256_xor_si256(d, a));                                    \
+        c = _mm256_add_epi64(c, d);                                            \
+        b = ROTR24(_mm256_xor_si256(b, c));                                    \
+        a = _mm256_add_epi64(_mm256_add_epi64(a, b), y);                       \
+        d = ROTR16(_mm256_xor_si256(d, a));                                    \
+        c = _mm256_add_epi64(c, d);                                            \
+        b = ROTR63(_mm256_xor_si256(b, c));                                    \
+    } while ((void)0, 0)
+
+void randomx_blake2b_compress_avx2_impl(blake2b_state *S, const uint8_t *block) {
+	const __m256i r16 = _mm256_setr_epi8(
+		2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+		2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+	const __m256i r24 = _mm256_setr_epi8(
+		3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+		3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+	uint64_t m[16];
+	__m256i a, b, c, d;
+	unsigned int r;
+
+	memcpy(m, block, sizeof(m));
+
+	a = _mm256_loadu_si256((const __m256i *)&S->h[0]);
+	b = _mm256_loadu_si256((const __m256i *)&S->h[4]);
+	c = _mm256_loadu_si256((const __m256i *)&blake2b_IV[0]);
+	/* t[2] and f[2] are adjacent in blake2b_state */
+	d = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&blake2b_IV[4]), _mm256_loadu_si256((const __m256i *)&S->t[0]));
+
+	for (r = 0; r < 12; ++r) {
+		const unsigned int *s = blake2b_sigma[r];
+
+		G_ROW(a, b, c, d, LOAD_MSG(0, 2, 4, 6), LOAD_MSG(1, 3, 5, 7));
+
+		b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 3, 2, 1));
+		c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2));
+		d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(2, 1, 0, 3));
+
+		G_ROW(a, b, c, d, LOAD_MSG(8, 10, 12, 14), LOAD_MSG(9, 11, 13, 15));
+
+		b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3));
+		c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2));
+		d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(0, 3, 2, 1));
+	}
+
+	a = _mm256_xor_si256(a, c);
+	b = _mm256_xor_si256(b, d);
+	_mm256_storeu_si256((__m256i *)&S->h[0], _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&S->h[0]), a));
+	_mm256_storeu_si256((__m256i *)&S->h[4], _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&S->h[4]), b));
+}
+
+/* 4 independent messages: vector i holds state word i of all 4 messages */
+
+#define G_LANES(a, b, c, d, x, y) G_ROW(v[a], v[b], v[c], v[d], m[s[x]], m[s[y]])
+
+static FORCE_INLINE void transpose4x4(__m256i *r0, __m256i *r1, __m256i *r2, __m256i *r3) {
+	__m256i t0 = _mm256_unpacklo_epi64(*r0, *r1);
+	__m256i t1 = _mm256_unpackhi_epi64(*r0, *r1);
+	__m256i t2 = _mm256_unpacklo_epi64(*r2, *r3);
+	__m256i t3 = _mm256_unpackhi_epi64(*r2, *r3);
+	*r0 = _mm256_permute2x128_si256(t0, t2, 0x20);
+	*r1 = _mm256_permute2x128_si256(t1, t3, 0x20);
+	*r2 = _mm256_permute2x128_si256(t0, t2, 0x31);
+	*r3 = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+static void blake2b_compress_4way(__m256i h[8], const uint8_t *const blocks[4], uint64_t t, uint64_t f) {
+	const __m256i r16 = _mm256_setr_epi8(
+		2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+		2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+	const __m256i r24 = _mm256_setr_epi8(
+		3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+		3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+	__m256i m[16];
+	__m256i v[16];
+	unsigned int i, r;
+
+	for (i = 0; i < 16; i += 4) {
+		m[i + 0] = _mm256_loadu_si256((const __m256i *)(blocks[0] + 8 * i));
+		m[i + 1] = _mm256_loadu_si256((const __m256i *)(blocks[1] + 8 * i));
+		m[i + 2] = _mm256_loadu_si256((const __m256i *)(blocks[2] + 8 * i));
+		m[i + 3] = _mm256_loadu_si256((const __m256i *)(blocks[3] + 8 * i));
+		transpose4x4(&m[i + 0], &m[i + 1], &m[i + 2], &m[i + 3]);
+	}
+
+	for (i = 0; i < 8; ++i) {
+		v[i] = h[i];
+		v[i + 8] = _mm256_set1_epi64x((int64_t)blake2b_IV[i]);
+	}
+	v[12] = _mm256_xor_si256(v[12], _mm256_set1_epi64x((int64_t)t));
+	v[14] = _mm256_xor_si256(v[14], _mm256_set1_epi64x((int64_t)f));
+
+	for (r = 0; r < 12; ++r) {
+		const unsigned int *s = blake2b_sigma[r];
+		G_LANES(0, 4, 8, 12, 0, 1);
+		G_LANES(1, 5, 9, 13, 2, 3);
+		G_LANES(2, 6, 10, 14, 4, 5);
+		G_LANES(3, 7, 11, 15, 6, 7);
+		G_LANES(0, 5, 10, 15, 8, 9);
+		G_LANES(1, 6, 11, 12, 10, 11);
+		G_LANES(2, 7, 8, 13, 12, 13);
+		G_LANES(3, 4, 9, 14, 14, 15);
+	}
+
+	for (i = 0; i < 8; ++i) {
+		h[i] = _mm256_xor_si256(h[i], _mm256_xor_si256(v[i], v[i + 8]));
+	}
+}
+
+void randomx_blake2b_4way_avx2_impl(void *const out[4], size_t outlen, const void *const in[4], size_t inlen) {
+	uint8_t last[4][BLAKE2B_BLOCKBYTES];
+	const uint8_t *blocks[4];
+	uint64_t hash[4][8];
+	__m256i h[8];
+	size_t offset = 0;
+	unsigned int i;
+
+	for (i = 0; i < 8; ++i) {
+		h[i] = _mm256_set1_epi64x((int64_t)blake2b_IV[i]);
+	}
+	/* parameter block of an unkeyed sequential hash */
+	h[0] = _mm256_xor_si256(h[0], _mm256_set1_epi64x((int64_t)(0x01010000 ^ outlen)));
+
+	/* the last block is always compressed with the final flag, even if it is full */
+	while (inlen - offset > BLAKE2B_BLOCKBYTES) {
+		for (i = 0; i < 4; ++i) {
+			blocks[i] = (const uint8_t *)in[i] + offset;
+		}
+		offset += BLAKE2B_BLOCKBYTES;
+		blake2b_compress_4way(h, blocks, offset, 0);
+	}
+
+	for (i = 0; i < 4; ++i) {
+		memset(last[i], 0, sizeof(last[i]));
+		if (inlen > offset) {
+			memcpy(last[i], (const uint8_t *)in[i] + offset, inlen - offset);
+		}
+		blocks[i] = last[i];
+	}
+	blake2b_compress_4way(h, blocks, inlen, (uint64_t)-1);
+
+	transpose4x4(&h[0], &h[1], &h[2], &h[3]);
+	transpose4x4(&h[4], &h[5], &h[6], &h[7]);
+	for (i = 0; i < 4; ++i) {
+		_mm256_storeu_si256((__m256i *)&hash[i][0], h[i]);
+		_mm256_storeu_si256((__m256i *)&hash[i][4], h[i + 4]);
+		memcpy(out[i], hash[i], outlen);
+	}
+}
+
+#endif
@@ -0,0 +1,148 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "blake2.h"
+
+#if defined(_MSC_VER) //MSVC doesn't define SSE4.1
+#define __SSE4_1__
+#endif
+
+void randomx_blake2b_compress_sse41_impl(blake2b_state *S, const uint8_t *block);
+
+randomx_blake2b_compress_fn *randomx_blake2b_compress_sse41(void) {
+#if defined(__SSE4_1__)
+	return &randomx_blake2b_compress_sse41_impl;
+#endif
+	return NULL;
+}
+
+#if defined(__SSE4_1__)
+
+#include <smmintrin.h>
+
+#include "blake2-impl.h"
+
+/* the 4x4 state matrix is kept as 8 vectors of 2 words: rows a-d, low and high halves */
+
+#define ROTR32(x) _mm_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define ROTR24(x) _mm_shuffle_epi8((x), r24)
+#define ROTR16(x) _mm_shuffle_epi8((x), r16)
+#define ROTR63(x) _mm_xor_si128(_mm_srli_epi64((x), 63), _mm_add_epi64((x), (x)))
+
+#define LOAD_MSG(i0, i1) _mm_set_epi64x((int64_t)m[s[i1]], (int64_t)m[s[i0]])
+
+#define G_HALF(al, ah, bl, bh, cl, ch, dl, dh, xl, xh, yl, yh)                \
+    do {                                                                       \
+        al = _mm_add_epi64(_mm_add_epi64(al, bl), xl);                         \
+        ah = _mm_add_epi64(_mm_add_epi64(ah, bh), xh);                         \
+        dl = ROTR32(_mm_xor_si128(dl, al));                                    \
+        dh = ROTR32(_mm_xor_si128(dh, ah));                                    \
+        cl = _mm_add_epi64(cl, dl);                                            \
+        ch = _mm_add_epi64(ch, dh);                                            \
+        bl = ROTR24(_mm_xor_si128(bl, cl));                                    \
+        bh = ROTR24(_mm_xor_si128(bh, ch));                                    \
+        al = _mm_add_epi64(_mm_add_epi64(al, bl), yl);                         \
+        ah = _mm_add_epi64(_mm_add_epi64(ah, bh), yh);                         \
+        dl = ROTR16(_mm_xor_si128(dl, al));                                    \
+        dh = ROTR16(_mm_xor_si128(dh, ah));                                    \
+        cl = _mm_add_epi64(cl, dl);                                            \
+        ch = _mm_add_epi64(ch, dh);                                            \
+        bl = ROTR63(_mm_xor_si128(bl, cl));                                    \
+        bh = ROTR63(_mm_xor_si128(bh, ch));                                    \
+    } while ((void)0, 0)
+
+void randomx_blake2b_compress_sse41_impl(blake2b_state *S, const uint8_t *block) {
+	const __m128i r16 = _mm_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+	const __m128i r24 = _mm_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+	uint64_t m[16];
+	__m128i al, ah, bl, bh, cl, ch, dl, dh, t0, t1;
+	unsigned int r;
+
+	memcpy(m, block, sizeof(m));
+
+	al = _mm_loadu_si128((const __m128i *)&S->h[0]);
+	ah = _mm_loadu_si128((const __m128i *)&S->h[2]);
+	bl = _mm_loadu_si128((const __m128i *)&S->h[4]);
+	bh = _mm_loadu_si128((const __m128i *)&S->h[6]);
+	cl = _mm_loadu_si128((const __m128i *)&blake2b_IV[0]);
+	ch = _mm_loadu_si128((const __m128i *)&blake2b_IV[2]);
+	dl = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&blake2b_IV[4]), _mm_loadu_si128((const __m128i *)&S->t[0]));
+	dh = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&blake2b_IV[6]), _mm_loadu_si128((const __m128i *)&S->f[0]));
+
+	for (r = 0; r < 12; ++r) {
+		const unsigned int *s = blake2b_sigma[r];
+
+		/* columns */
+		G_HALF(al, ah, bl, bh, cl, ch, dl, dh,
+			LOAD_MSG(0, 2), LOAD_MSG(4, 6), LOAD_MSG(1, 3), LOAD_MSG(5, 7));
+
+		/* diagonalize */
+		t0 = _mm_alignr_epi8(bh, bl, 8);
+		t1 = _mm_alignr_epi8(bl, bh, 8);
+		bl = t0;
+		bh = t1;
+		t0 = cl;
+		cl = ch;
+		ch = t0;
+		t0 = _mm_alignr_epi8(dl, dh, 8);
+		t1 = _mm_alignr_epi8(dh, dl, 8);
+		dl = t0;
+		dh = t1;
+
+		/* diagonals */
+		G_HALF(al, ah, bl, bh, cl, ch, dl, dh,
+			LOAD_MSG(8, 10), LOAD_MSG(12, 14), LOAD_MSG(9, 11), LOAD_MSG(13, 15));
+
+		/* undiagonalize */
+		t0 = _mm_alignr_epi8(bl, bh, 8);
+		t1 = _mm_alignr_epi8(bh, bl, 8);
+		bl = t0;
+		bh = t1;
+		t0 = cl;
+		cl = ch;
+		ch = t0;
+		t0 = _mm_alignr_epi8(dh, dl, 8);
+		t1 = _mm_alignr_epi8(dl, dh, 8);
+		dl = t0;
+		dh = t1;
+	}
+
+	al = _mm_xor_si128(al, cl);
+	ah = _mm_xor_si128(ah, ch);
+	bl = _mm_xor_si128(bl, dl);
+	bh = _mm_xor_si128(bh, dh);
+	_mm_storeu_si128((__m128i *)&S->h[0], _mm_xor_si128(_mm_loadu_si128((const __m128i *)&S->h[0]), al));
+	_mm_storeu_si128((__m128i *)&S->h[2], _mm_xor_si128(_mm_loadu_si128((const __m128i *)&S->h[2]), ah));
+	_mm_storeu_si128((__m128i *)&S->h[4], _mm_xor_si128(_mm_loadu_si128((const __m128i *)&S->h[4]), bl));
+	_mm_storeu_si128((__m128i *)&S->h[6], _mm_xor_si128(_mm_loadu_si128((const __m128i *)&S->h[6]), bh));
+}
+
+#endif
@@ -78,6 +78,320 @@ namespace randomx {
 		}
 	}
 
+#ifdef RANDOMX_THREADED_BYTECODE
+
+	/*
+		Operand forms of the specialized handlers. compileInstruction encodes
+		an immediate source as a pointer to ibc.imm and a constant (src == dst)
+		address as a pointer to 'zero', so the generic handlers always load
+		through isrc. The specialized handlers read ibc.imm directly.
+	*/
+
+	struct SourceRegister {
+		static FORCE_INLINE int_reg_t get(const InstructionByteCode& ibc) {
+			return *ibc.isrc;
+		}
+	};
+
+	struct SourceImmediate {
+		static FORCE_INLINE int_reg_t get(const InstructionByteCode& ibc) {
+			return ibc.imm;
+		}
+	};
+
+	struct AddressRegister {
+		static FORCE_INLINE void* get(const InstructionByteCode& ibc, uint8_t* scratchpad) {
+			return scratchpad + ((*ibc.isrc + ibc.imm) & ibc.memMask);
+		}
+	};
+
+	//ibc.imm is pre-masked when the handler is selected
+	struct AddressConstant {
+		static FORCE_INLINE void* get(const InstructionByteCode& ibc, uint8_t* scratchpad) {
+			return scratchpad + ibc.imm;
+		}
+	};
+
+	template<class Src>
+	static FORCE_INLINE void exeIsub(InstructionByteCode& ibc) {
+		*ibc.idst -= Src::get(ibc);
+	}
+
+	template<class Src>
+	static FORCE_INLINE void exeImul(InstructionByteCode& ibc) {
+		*ibc.idst *= Src::get(ibc);
+	}
+
+	template<class Src>
+	static FORCE_INLINE void exeIxor(InstructionByteCode& ibc) {
+		*ibc.idst ^= Src::get(ibc);
+	}
+
+	template<class Src>
+	static FORCE_INLINE void exeIror(InstructionByteCode& ibc) {
+		*ibc.idst = rotr(*ibc.idst, Src::get(ibc) & 63);
+	}
+
+	template<class Src>
+	static FORCE_INLINE void exeIrol(InstructionByteCode& ibc) {
+		*ibc.idst = rotl(*ibc.idst, Src::get(ibc) & 63);
+	}
+
+	template<class Addr>
+	static FORCE_INLINE void exeIaddM(InstructionByteCode& ibc, uint8_t* scratchpad) {
+		*ibc.idst += load64(Addr::get(ibc, scratchpad));
+	}
+
+	template<class Addr>
+	static FORCE_INLINE void exeIsubM(InstructionByteCode& ibc, uint8_t* scratchpad) {
+		*ibc.idst -= load64(Addr::get(ibc, scratchpad));
+	}
+
+	template<class Addr>
+	static FORCE_INLINE void exeImulM(InstructionByteCode& ibc, uint8_t* scratchpad) {
+		*ibc.idst *= load64(Addr::get(ibc, scratchpad));
+	}
+
+	template<class Addr>
+	static FORCE_INLINE void exeImulhM(InstructionByteCode& ibc, uint8_t* scratchpad) {
+		*ibc.idst = mulh(*ibc.idst, load64(Addr::get(ibc, scratchpad)));
+	}
+
+	template<class Addr>
+	static FORCE_INLINE void exeIsmulhM(InstructionByteCode& ibc, uint8_t* scratchpad) {
+		*ibc.idst = smulh(unsigned64ToSigned2sCompl(*ibc.idst), unsigned64ToSigned2sCompl(load64(Addr::get(ibc, scratchpad))));
+	}
+
+	template<class Addr>
+	static FORCE_INLINE void exeIxorM(InstructionByteCode& ibc, uint8_t* scratchpad) {
+		*ibc.idst ^= load64(Addr::get(ibc, scratchpad));
+	}
+
+	/*
+		Superinstructions: the most frequent register-register instructions
+		(about 45% of a program) are fused with the next one if it is also
+		from this set. Only the first slot of a pair changes its handler,
+		so a branch that lands on the second slot still executes it alone.
+	*/
+
+	static int fusedIndex(InstructionType type) {
+		switch (type) {
+		case InstructionType::IADD_RS:
+			return 0;
+		case InstructionType::IMUL_R:
+			return 1;
+		case InstructionType::IXOR_R:
+			return 2;
+		case InstructionType::FADD_R:
+			return 3;
+		case InstructionType::FSUB_R:
+			return 4;
+		case InstructionType::FMUL_R:
+			return 5;
+		default:
+			return -1;
+		}
+	}
+
+#define FUSED_ROW(X, a) \
+	X(a, IADD_RS) \
+	X(a, IMUL_R) \
+	X(a, IXOR_R) \
+	X(a, FADD_R) \
+	X(a, FSUB_R) \
+	X(a, FMUL_R)
+
+#define FUSED_PAIRS(X) \
+	FUSED_ROW(X, IADD_RS) \
+	FUSED_ROW(X, IMUL_R) \
+	FUSED_ROW(X, IXOR_R) \
+	FUSED_ROW(X, FADD_R) \
+	FUSED_ROW(X, FSUB_R) \
+	FUSED_ROW(X, FMUL_R)
+
+#define INSTR_LABEL(x) &&op_ ## x,
+
+#define FUSED_LABEL(a, b) &&op_ ## a ## _ ## b,
+
+#define INSTR_DISPATCH \
+	if (++pc == n) \
+		return; \
+	ibc = &bytecode[pc]; \
+	goto *ibc->handler;
+
+#define INSTR_HANDLER(x) op_ ## x: \
+	exe_ ## x(*ibc, pc, scratchpad, *config, flags); \
+	INSTR_DISPATCH
+
+#define INSTR_HANDLER_SRC(x, exe) \
+	op_ ## x: \
+	exe<SourceRegister>(*ibc); \
+	INSTR_DISPATCH \
+	op_ ## x ## _IMM: \
+	exe<SourceImmediate>(*ibc); \
+	INSTR_DISPATCH
+
+#define INSTR_HANDLER_MEM(x, exe) \
+	op_ ## x: \
+	exe<AddressRegister>(*ibc, scratchpad); \
+	INSTR_DISPATCH \
+	op_ ## x ## _CONST: \
+	exe<AddressConstant>(*ibc, scratchpad); \
+	INSTR_DISPATCH
+
+#define FUSED_HANDLER(a, b) op_ ## a ## _ ## b: \
+	exe_ ## a(ibc[0], pc, scratchpad, *config, flags); \
+	exe_ ## b(ibc[1], pc, scratchpad, *config, flags); \
+	++pc; \
+	INSTR_DISPATCH
+
+#define SELECT_SRC(x) case InstructionType::x: \
+	if (ibc.isrc == &ibc.imm) \
+		ibc.handler = &&op_ ## x ## _IMM; \
+	break;
+
+#define SELECT_MEM(x) case InstructionType::x: \
+	if (ibc.isrc == &zero) { \
+		ibc.imm &= ibc.memMask; \
+		ibc.handler = &&op_ ## x ## _CONST; \
+	} \
+	break;
+
+	void BytecodeMachine::runBytecode(InstructionByteCode bytecode[RANDOMX_PROGRAM_MAX_SIZE], uint8_t* scratchpad, ProgramConfiguration* config, randomx_flags flags, bool resolve) {
+		//indexed by InstructionType
+		static const void* const handlers[] = {
+			INSTR_LABEL(IADD_RS)
+			INSTR_LABEL(IADD_M)
+			INSTR_LABEL(ISUB_R)
+			INSTR_LABEL(ISUB_M)
+			INSTR_LABEL(IMUL_R)
+			INSTR_LABEL(IMUL_M)
+			INSTR_LABEL(IMULH_R)
+			INSTR_LABEL(IMULH_M)
+			INSTR_LABEL(ISMULH_R)
+			INSTR_LABEL(ISMULH_M)
+			INSTR_LABEL(IMUL_R) //IMUL_RCP is executed as IMUL_R
+			INSTR_LABEL(INEG_R)
+			INSTR_LABEL(IXOR_R)
+			INSTR_LABEL(IXOR_M)
+			INSTR_LABEL(IROR_R)
+			INSTR_LABEL(IROL_R)
+			INSTR_LABEL(ISWAP_R)
+			INSTR_LABEL(FSWAP_R)
+			INSTR_LABEL(FADD_R)
+			INSTR_LABEL(FADD_M)
+			INSTR_LABEL(FSUB_R)
+			INSTR_LABEL(FSUB_M)
+			INSTR_LABEL(FSCAL_R)
+			INSTR_LABEL(FMUL_R)
+			INSTR_LABEL(FDIV_M)
+			INSTR_LABEL(FSQRT_R)
+			INSTR_LABEL(CBRANCH)
+			INSTR_LABEL(CFROUND)
+			INSTR_LABEL(ISTORE)
+			INSTR_LABEL(NOP)
+		};
+		static_assert(sizeof(handlers) / sizeof(handlers[0]) == (int)InstructionType::NOP + 1, "Invalid handler table");
+
+		//indexed by fusedIndex of the first and the second instruction
+		static const void* const fusedHandlers[] = {
+			FUSED_PAIRS(FUSED_LABEL)
+		};
+
+		const int n = Program::getSize(flags);
+
+		if (resolve) {
+			for (int i = 0; i < n; ++i) {
+				auto& ibc = bytecode[i];
+				ibc.handler = handlers[(int)ibc.type];
+				switch (ibc.type) {
+					SELECT_SRC(ISUB_R)
+					SELECT_SRC(IMUL_R)
+					SELECT_SRC(IXOR_R)
+					SELECT_SRC(IROR_R)
+					SELECT_SRC(IROL_R)
+					SELECT_MEM(IADD_M)
+					SELECT_MEM(ISUB_M)
+					SELECT_MEM(IMUL_M)
+					SELECT_MEM(IMULH_M)
+					SELECT_MEM(ISMULH_M)
+					SELECT_MEM(IXOR_M)
+				default:
+					break;
+				}
+			}
+			for (int i = 0; i + 1 < n; ++i) {
+				int first = fusedIndex(bytecode[i].type);
+				int second = fusedIndex(bytecode[i + 1].type);
+				if (first >= 0 && second >= 0) {
+					bytecode[i].handler = fusedHandlers[first * 6 + second];
+				}
+			}
+			return;
+		}
+
+		int pc = 0;
+		InstructionByteCode* ibc = &bytecode[0];
+		goto *ibc->handler;
+
+		INSTR_HANDLER(IADD_RS)
+		INSTR_HANDLER_MEM(IADD_M, exeIaddM)
+		INSTR_HANDLER_SRC(ISUB_R, exeIsub)
+		INSTR_HANDLER_MEM(ISUB_M, exeIsubM)
+		INSTR_HANDLER_SRC(IMUL_R, exeImul)
+		INSTR_HANDLER_MEM(IMUL_M, exeImulM)
+		INSTR_HANDLER(IMULH_R)
+		INSTR_HANDLER_MEM(IMULH_M, exeImulhM)
+		INSTR_HANDLER(ISMULH_R)
+		INSTR_HANDLER_MEM(ISMULH_M, exeIsmulhM)
+		INSTR_HANDLER(INEG_R)
+		INSTR_HANDLER_SRC(IXOR_R, exeIxor)
+		INSTR_HANDLER_MEM(IXOR_M, exeIxorM)
+		INSTR_HANDLER_SRC(IROR_R, exeIror)
+		INSTR_HANDLER_SRC(IROL_R, exeIrol)
+		INSTR_HANDLER(ISWAP_R)
+		INSTR_HANDLER(FSWAP_R)
+		INSTR_HANDLER(FADD_R)
+		INSTR_HANDLER(FADD_M)
+		INSTR_HANDLER(FSUB_R)
+		INSTR_HANDLER(FSUB_M)
+		INSTR_HANDLER(FSCAL_R)
+		INSTR_HANDLER(FMUL_R)
+		INSTR_HANDLER(FDIV_M)
+		INSTR_HANDLER(FSQRT_R)
+		INSTR_HANDLER(CBRANCH)
+		INSTR_HANDLER(CFROUND)
+		INSTR_HANDLER(ISTORE)
+
+		FUSED_PAIRS(FUSED_HANDLER)
+
+	op_NOP:
+		INSTR_DISPATCH
+	}
+
+#undef FUSED_ROW
+#undef FUSED_PAIRS
+#undef INSTR_LABEL
+#undef FUSED_LABEL
+#undef INSTR_DISPATCH
+#undef INSTR_HANDLER
+#undef INSTR_HANDLER_SRC
+#undef INSTR_HANDLER_MEM
+#undef FUSED_HANDLER
+#undef SELECT_SRC
+#undef SELECT_MEM
+
+#else
+
+	void BytecodeMachine::runBytecode(InstructionByteCode bytecode[RANDOMX_PROGRAM_MAX_SIZE], uint8_t* scratchpad, ProgramConfiguration* config, randomx_flags flags) {
+		for (int pc = 0, n = Program::getSize(flags); pc < n; ++pc) {
+			auto& ibc = bytecode[pc];
+			executeInstruction(ibc, pc, scratchpad, *config, flags);
+		}
+	}
+
+#endif
+
 	void BytecodeMachine::compileInstruction(RANDOMX_GEN_ARGS) {
 		int opcode = instr.opcode;
 
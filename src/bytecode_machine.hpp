@@ -33,6 +33,12 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "instruction.hpp"
 #include "program.hpp"
 
+//GCC and Clang support labels as values, so the bytecode can be executed
+//with direct threading instead of a switch (one indirect jump per instruction)
+#if defined(__GNUC__) && !defined(RANDOMX_NO_THREADED_BYTECODE)
+#define RANDOMX_THREADED_BYTECODE
+#endif
+
 namespace randomx {
 
 	//register file in machine byte order
@@ -62,6 +68,9 @@ namespace randomx {
 			uint16_t shift;
 		};
 		uint32_t memMask;
+#ifdef RANDOMX_THREADED_BYTECODE
+		const void* handler; //label address in runBytecode
+#endif
 	};
 
 #define OPCODE_CEIL_DECLARE(curr, prev) constexpr int ceil_ ## curr = ceil_ ## prev + RANDOMX_FREQ_ ## curr;
@@ -121,13 +130,17 @@ namespace randomx {
 				auto& ibc = bytecode[i];
 				compileInstruction(instr, i, ibc);
 			}
+#ifdef RANDOMX_THREADED_BYTECODE
+			runBytecode(bytecode, nullptr, nullptr, flags, true);
+#endif
 		}
 
 		static void executeBytecode(InstructionByteCode bytecode[RANDOMX_PROGRAM_MAX_SIZE], uint8_t* scratchpad, ProgramConfiguration& config, randomx_flags flags) {
-			for (int pc = 0, n = Program::getSize(flags); pc < n; ++pc) {
-				auto& ibc = bytecode[pc];
-				executeInstruction(ibc, pc, scratchpad, config, flags);
-			}
+#ifdef RANDOMX_THREADED_BYTECODE
+			runBytecode(bytecode, scratchpad, &config, flags, false);
+#else
+			runBytecode(bytecode, scratchpad, &config, flags);
+#endif
 		}
 
 		void compileInstruction(RANDOMX_GEN_ARGS)
@@ -278,6 +291,14 @@ namespace randomx {
 		}
 
 	private:
+#ifdef RANDOMX_THREADED_BYTECODE
+		//the handler labels are local to runBytecode, so it also resolves them:
+		//with resolve == true, it only sets the handler of each instruction and executes nothing
+		static void runBytecode(InstructionByteCode bytecode[RANDOMX_PROGRAM_MAX_SIZE], uint8_t* scratchpad, ProgramConfiguration* config, randomx_flags flags, bool resolve);
+#else
+		static void runBytecode(InstructionByteCode bytecode[RANDOMX_PROGRAM_MAX_SIZE], uint8_t* scratchpad, ProgramConfiguration* config, randomx_flags flags);
+#endif
+
 		static const int_reg_t zero;
 		int registerUsage[RegistersCount];
 		NativeRegisterFile* nreg;
@@ -0,0 +1,183 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include "cache_manager.hpp"
+
+randomx_cache_manager::randomx_cache_manager(randomx_flags flags, unsigned capacity)
+	: flags(flags), capacity(std::max(capacity, 1u)) {
+	prefetcher = std::thread(&randomx_cache_manager::prefetchLoop, this);
+}
+
+randomx_cache_manager::~randomx_cache_manager() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	prefetchCondition.notify_all();
+	prefetcher.join();
+	for (auto& entry : entries) {
+		assert(entry->refCount == 0);
+		randomx_release_cache(entry->cache);
+	}
+}
+
+randomx_cache* randomx_cache_manager::acquire(const void* key, size_t keySize) {
+	std::string cacheKey((const char*)key, keySize);
+	std::unique_lock<std::mutex> lock(mutex);
+	Entry* entry = find(cacheKey);
+	if (entry == nullptr) {
+		entry = insert(cacheKey);
+		if (entry == nullptr)
+			return nullptr;
+		entry->refCount++;
+		lock.unlock();
+		initialize(entry);
+		return entry->cache;
+	}
+	entry->refCount++;
+	entry->lastUse = ++useCounter;
+	//the cache is being initialized by another thread
+	readyCondition.wait(lock, [entry]() { return entry->ready; });
+	return entry->cache;
+}
+
+randomx_cache* randomx_cache_manager::tryAcquire(const void* key, size_t keySize) {
+	std::string cacheKey((const char*)key, keySize);
+	std::lock_guard<std::mutex> lock(mutex);
+	Entry* entry = find(cacheKey);
+	if (entry == nullptr || !entry->ready)
+		return nullptr;
+	entry->refCount++;
+	entry->lastUse = ++useCounter;
+	return entry->cache;
+}
+
+void randomx_cache_manager::release(randomx_cache* cache) {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& entry : entries) {
+		if (entry->cache == cache) {
+			assert(entry->refCount > 0);
+			entry->refCount--;
+			break;
+		}
+	}
+	evict();
+}
+
+void randomx_cache_manager::prefetch(const void* key, size_t keySize) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		prefetchQueue.emplace_back((const char*)key, keySize);
+	}
+	prefetchCondition.notify_one();
+}
+
+randomx_cache_manager::Entry* randomx_cache_manager::find(const std::string& key) {
+	for (auto& entry : entries) {
+		if (entry->key == key)
+			return entry.get();
+	}
+	return nullptr;
+}
+
+//Creates an entry that is not ready. The caller must initialize it.
+randomx_cache_manager::Entry* randomx_cache_manager::insert(const std::string& key) {
+	evict();
+	Entry* entry = nullptr;
+	//reuse the least recently used unreferenced cache if the manager is full
+	if (entries.size() >= capacity) {
+		for (auto& candidate : entries) {
+			if (candidate->refCount == 0 && candidate->ready && (entry == nullptr || candidate->lastUse < entry->lastUse))
+				entry = candidate.get();
+		}
+	}
+	if (entry == nullptr) {
+		randomx_cache* cache = randomx_alloc_cache(flags);
+		if (cache == nullptr)
+			return nullptr;
+		entries.emplace_back(new Entry());
+		entry = entries.back().get();
+		entry->cache = cache;
+		entry->refCount = 0;
+	}
+	entry->key = key;
+	entry->ready = false;
+	entry->lastUse = ++useCounter;
+	return entry;
+}
+
+//Releases the least recently used unreferenced caches over capacity.
+void randomx_cache_manager::evict() {
+	while (entries.size() > capacity) {
+		auto victim = entries.end();
+		for (auto it = entries.begin(); it != entries.end(); ++it) {
+			if ((*it)->refCount == 0 && (*it)->ready && (victim == entries.end() || (*it)->lastUse < (*victim)->lastUse))
+				victim = it;
+		}
+		if (victim == entries.end())
+			break;
+		randomx_release_cache((*victim)->cache);
+		entries.erase(victim);
+	}
+}
+
+void randomx_cache_manager::initialize(Entry* entry) {
+	randomx_init_cache(entry->cache, entry->key.data(), entry->key.size());
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		entry->ready = true;
+	}
+	readyCondition.notify_all();
+}
+
+//The prefetch thread runs at normal priority because a thread that calls acquire
+//for the same key waits for it.
+void randomx_cache_manager::prefetchLoop() {
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		prefetchCondition.wait(lock, [this]() { return stop || !prefetchQueue.empty(); });
+		if (stop)
+			return;
+		std::string key = std::move(prefetchQueue.front());
+		prefetchQueue.pop_front();
+		if (find(key) != nullptr)
+			continue;
+		Entry* entry = insert(key);
+		if (entry == nullptr)
+			continue;
+		//keep the entry referenced while it is being initialized
+		entry->refCount++;
+		lock.unlock();
+		initialize(entry);
+		lock.lock();
+		entry->refCount--;
+		evict();
+	}
+}
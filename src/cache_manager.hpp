@@ -0,0 +1,74 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "randomx.h"
+
+/* Global namespace for C binding */
+class randomx_cache_manager {
+public:
+	randomx_cache_manager(randomx_flags flags, unsigned capacity);
+	~randomx_cache_manager();
+	randomx_cache* acquire(const void* key, size_t keySize);
+	randomx_cache* tryAcquire(const void* key, size_t keySize);
+	void release(randomx_cache* cache);
+	void prefetch(const void* key, size_t keySize);
+private:
+	struct Entry {
+		std::string key;
+		randomx_cache* cache;
+		unsigned refCount;
+		bool ready;
+		uint64_t lastUse;
+	};
+	Entry* find(const std::string& key);
+	Entry* insert(const std::string& key);
+	void evict();
+	void initialize(Entry* entry);
+	void prefetchLoop();
+
+	const randomx_flags flags;
+	const unsigned capacity;
+	std::mutex mutex;
+	std::condition_variable readyCondition;
+	std::condition_variable prefetchCondition;
+	std::vector<std::unique_ptr<Entry>> entries;
+	std::deque<std::string> prefetchQueue;
+	uint64_t useCounter = 0;
+	bool stop = false;
+	std::thread prefetcher;
+};
@@ -28,17 +28,24 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "cpu.hpp"
 #include <cstring>
+#include <cstddef>
 
 #if defined(_M_X64) || defined(__x86_64__)
 	#define HAVE_CPUID
 	#if defined(_MSC_VER)
 		#include <intrin.h>
 		#define cpuid(info, x) __cpuidex(info, x, 0)
+		#define xgetbv(x) _xgetbv(x)
 	#else //GCC
 		#include <cpuid.h>
 		void cpuid(int info[4], int InfoType) {
 			__cpuid_count(InfoType, 0, info[0], info[1], info[2], info[3]);
 		}
+		static unsigned long long xgetbv(unsigned index) {
+			unsigned eax, edx;
+			__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+			return ((unsigned long long)edx << 32) | eax;
+		}
 	#endif
 #endif
 
@@ -69,14 +76,45 @@ namespace randomx {
 		int info[4];
 		cpuid(info, 0);
 		int nIds = info[0];
+		memcpy(vendor_ + 0, &info[1], 4);
+		memcpy(vendor_ + 4, &info[3], 4);
+		memcpy(vendor_ + 8, &info[2], 4);
+		unsigned long long xcr0 = 0;
 		if (nIds >= 0x00000001) {
 			cpuid(info, 0x00000001);
+			unsigned signature = info[0];
+			family_ = (signature >> 8) & 0xf;
+			model_ = (signature >> 4) & 0xf;
+			if (family_ == 0xf) {
+				family_ += (signature >> 20) & 0xff;
+			}
+			if (family_ == 0x6 || family_ >= 0xf) {
+				model_ |= ((signature >> 16) & 0xf) << 4;
+			}
 			ssse3_ = (info[2] & (1 << 9)) != 0;
+			sse41_ = (info[2] & (1 << 19)) != 0;
 			aes_ = (info[2] & (1 << 25)) != 0;
+			if ((info[2] & (1 << 27)) != 0) {
+				xcr0 = xgetbv(0);
+			}
 		}
 		if (nIds >= 0x00000007) {
 			cpuid(info, 0x00000007);
-			avx2_ = (info[1] & (1 << 5)) != 0;
+			//the OS must save the YMM registers (XCR0 bits 1, 2)
+			bool ymm = (xcr0 & 0x06) == 0x06;
+			//the OS must save the opmask and ZMM registers (XCR0 bits 1, 2, 5, 6, 7)
+			bool zmm = (xcr0 & 0xE6) == 0xE6;
+			avx2_ = ymm && (info[1] & (1 << 5)) != 0;
+			bmi2_ = (info[1] & (1 << 8)) != 0;
+			sha_ = (info[1] & (1 << 29)) != 0;
+			vaes_ = avx2_ && (info[2] & (1 << 9)) != 0;
+			vpclmul_ = avx2_ && (info[2] & (1 << 10)) != 0;
+			avx512f_ = zmm && (info[1] & (1 << 16)) != 0;
+			avx512ifma_ = avx512f_ && (info[1] & (1 << 21)) != 0;
+			avx512bw_ = avx512f_ && (info[1] & (1 << 30)) != 0;
+			avx512vl_ = avx512f_ && (info[1] & (1u << 31)) != 0;
+			//vpmullq
+			avx512_ = avx512f_ && (info[1] & (1 << 17)) != 0;
 		}
 #elif defined(__aarch64__)
 	#if defined(HWCAP_AES)
@@ -36,7 +36,23 @@ namespace randomx {
 
 		inline bool hasAes() const { return aes_; }
 		inline bool hasSsse3() const { return ssse3_; }
+		inline bool hasSse41() const { return sse41_; }
 		inline bool hasAvx2() const { return avx2_; }
+		//AVX512F + AVX512DQ, the subset required by the AVX-512 kernels
+		inline bool hasAvx512() const { return avx512_; }
+		inline bool hasAvx512F() const { return avx512f_; }
+		inline bool hasAvx512BW() const { return avx512bw_; }
+		inline bool hasAvx512VL() const { return avx512vl_; }
+		inline bool hasAvx512Ifma() const { return avx512ifma_; }
+		inline bool hasVaes() const { return vaes_; }
+		inline bool hasVpclmul() const { return vpclmul_; }
+		inline bool hasBmi2() const { return bmi2_; }
+		inline bool hasSha() const { return sha_; }
+		//CPUID vendor string, empty if not available
+		inline const char* getVendor() const { return vendor_; }
+		//display family and model (including the extended fields), 0 if not available
+		inline unsigned getFamily() const { return family_; }
+		inline unsigned getModel() const { return model_; }
 #ifdef __riscv
 		inline bool hasRVV() const { return rvv_; }
 		inline int getRVV_Length() const { return rvv_length; }
@@ -45,7 +61,20 @@ namespace randomx {
 	private:
 		bool aes_ = false;
 		bool ssse3_ = false;
+		bool sse41_ = false;
 		bool avx2_ = false;
+		bool avx512_ = false;
+		bool avx512f_ = false;
+		bool avx512bw_ = false;
+		bool avx512vl_ = false;
+		bool avx512ifma_ = false;
+		bool vaes_ = false;
+		bool vpclmul_ = false;
+		bool bmi2_ = false;
+		bool sha_ = false;
+		char vendor_[13] = {};
+		unsigned family_ = 0;
+		unsigned model_ = 0;
 #ifdef __riscv
 		bool rvv_ = false;
 		int rvv_length = 0;
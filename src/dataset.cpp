@@ -39,6 +39,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <limits>
 #include <cstring>
 #include <cassert>
+#include <thread>
+#include <vector>
+#include <system_error>
 
 #include "common.hpp"
 #include "dataset.hpp"
@@ -51,6 +54,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "argon2_core.h"
 #include "jit_compiler.hpp"
 #include "intrin_portable.h"
+#include "affinity.hpp"
 
 static_assert(RANDOMX_ARGON_MEMORY % (RANDOMX_ARGON_LANES * ARGON2_SYNC_POINTS) == 0, "RANDOMX_ARGON_MEMORY - invalid value");
 static_assert(ARGON2_BLOCK_SIZE == randomx::ArgonBlockSize, "Unpexpected value of ARGON2_BLOCK_SIZE");
@@ -67,6 +71,15 @@ namespace randomx {
 
 	template void deallocCache<DefaultAllocator>(randomx_cache* cache);
 	template void deallocCache<LargePageAllocator>(randomx_cache* cache);
+	template void deallocCache<MappedFileAllocator>(randomx_cache* cache);
+	template void deallocCache<SharedMemoryAllocator>(randomx_cache* cache);
+
+	template<>
+	void deallocCache<UserAllocator>(randomx_cache* cache) {
+		UserAllocator::freeMemory(cache->allocator, cache->memory, CacheSize, RANDOMX_MEMORY_CACHE);
+		if (cache->jit != nullptr)
+			delete cache->jit;
+	}
 
 	void initCache(randomx_cache* cache, const void* key, size_t keySize) {
 		uint32_t memory_blocks, segment_length;
@@ -124,6 +137,10 @@ namespace randomx {
 
 		randomx_argon2_fill_memory_blocks(&instance);
 
+		generateCachePrograms(cache, key, keySize);
+	}
+
+	void generateCachePrograms(randomx_cache* cache, const void* key, size_t keySize) {
 		cache->reciprocalCache.clear();
 		randomx::Blake2Generator gen(key, keySize);
 		for (int i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
@@ -141,21 +158,17 @@ namespace randomx {
 
 	void initCacheCompile(randomx_cache* cache, const void* key, size_t keySize) {
 		initCache(cache, key, keySize);
+		compileCache(cache);
+	}
+
+	void compileCache(randomx_cache* cache) {
 		cache->jit->enableWriting();
 		cache->jit->generateSuperscalarHash(cache->programs, cache->reciprocalCache);
 		cache->jit->generateDatasetInitCode();
 		cache->jit->enableExecution();
+		cache->datasetInit = cache->jit->getDatasetInitFunc();
 	}
 
-	constexpr uint64_t superscalarMul0 = 6364136223846793005ULL;
-	constexpr uint64_t superscalarAdd1 = 9298411001130361340ULL;
-	constexpr uint64_t superscalarAdd2 = 12065312585734608966ULL;
-	constexpr uint64_t superscalarAdd3 = 9306329213124626780ULL;
-	constexpr uint64_t superscalarAdd4 = 5281919268842080866ULL;
-	constexpr uint64_t superscalarAdd5 = 10536153434571861004ULL;
-	constexpr uint64_t superscalarAdd6 = 3398623926847679864ULL;
-	constexpr uint64_t superscalarAdd7 = 9549104520008361294ULL;
-
 	static inline uint8_t* getMixBlock(uint64_t registerValue, uint8_t *memory) {
 		constexpr uint32_t mask = CacheSize / CacheLineSize - 1;
 		return memory + (registerValue & mask) * CacheLineSize;
@@ -189,8 +202,157 @@ namespace randomx {
 		memcpy(out, &rl, CacheLineSize);
 	}
 
+	void initDatasetItemPair(randomx_cache* cache, uint8_t* out, uint64_t itemNumber) {
+		int_reg_t rl[2][8];
+		uint64_t registerValue[2] = { itemNumber, itemNumber + 1 };
+		for (unsigned k = 0; k < 2; ++k) {
+			rl[k][0] = (registerValue[k] + 1) * superscalarMul0;
+			rl[k][1] = rl[k][0] ^ superscalarAdd1;
+			rl[k][2] = rl[k][0] ^ superscalarAdd2;
+			rl[k][3] = rl[k][0] ^ superscalarAdd3;
+			rl[k][4] = rl[k][0] ^ superscalarAdd4;
+			rl[k][5] = rl[k][0] ^ superscalarAdd5;
+			rl[k][6] = rl[k][0] ^ superscalarAdd6;
+			rl[k][7] = rl[k][0] ^ superscalarAdd7;
+		}
+		for (unsigned i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+			uint8_t* mixBlock0 = getMixBlock(registerValue[0], cache->memory);
+			uint8_t* mixBlock1 = getMixBlock(registerValue[1], cache->memory);
+			rx_prefetch_nta(mixBlock0);
+			rx_prefetch_nta(mixBlock1);
+			SuperscalarProgram& prog = cache->programs[i];
+
+			executeSuperscalarInterleaved(rl, prog, &cache->reciprocalCache);
+
+			for (unsigned q = 0; q < 8; ++q) {
+				rl[0][q] ^= load64_native(mixBlock0 + 8 * q);
+				rl[1][q] ^= load64_native(mixBlock1 + 8 * q);
+			}
+
+			registerValue[0] = rl[0][prog.getAddressRegister()];
+			registerValue[1] = rl[1][prog.getAddressRegister()];
+		}
+
+		memcpy(out, &rl, 2 * CacheLineSize);
+	}
+
 	void initDataset(randomx_cache* cache, uint8_t* dataset, uint32_t startItem, uint32_t endItem) {
-		for (uint32_t itemNumber = startItem; itemNumber < endItem; ++itemNumber, dataset += CacheLineSize)
+		uint32_t itemNumber = startItem;
+		for (; itemNumber + 1 < endItem; itemNumber += 2, dataset += 2 * CacheLineSize)
+			initDatasetItemPair(cache, dataset, itemNumber);
+		if (itemNumber < endItem)
 			initDatasetItem(cache, dataset, itemNumber);
 	}
+
+	void initDatasetLazy(randomx_dataset* dataset, randomx_cache* cache) {
+		constexpr size_t bitmapWords = (DatasetSize / CacheLineSize + 63) / 64;
+		if (dataset->lazy == nullptr) {
+			dataset->lazy = new LazyDataset();
+			dataset->lazy->bitmap = std::vector<std::atomic<uint64_t>>(bitmapWords);
+		}
+		LazyDataset* lazy = dataset->lazy;
+		lazy->cache = cache;
+		lazy->cacheKey = cache->cacheKey;
+		for (auto& word : lazy->bitmap) {
+			word.store(0, std::memory_order_relaxed);
+		}
+		lazy->readyCount.store(0);
+	}
+
+	static inline void markDatasetItemsLazy(LazyDataset* lazy, uint32_t word, uint64_t bits) {
+		uint64_t previous = lazy->bitmap[word].fetch_or(bits, std::memory_order_release);
+		uint64_t added = bits & ~previous;
+		unsigned count = 0;
+		for (; added != 0; added &= added - 1) {
+			count++;
+		}
+		if (count != 0) {
+			lazy->readyCount.fetch_add(count);
+		}
+	}
+
+	//Two threads may calculate the same item at the same time. Both write identical
+	//values, so a concurrent reader that already sees the valid bit reads the correct item.
+	const uint8_t* getDatasetItemLazy(randomx_dataset* dataset, uint32_t itemNumber) {
+		LazyDataset* lazy = dataset->lazy;
+		uint8_t* item = dataset->memory + (uint64_t)itemNumber * CacheLineSize;
+		uint64_t bit = 1ULL << (itemNumber % 64);
+		if (!(lazy->bitmap[itemNumber / 64].load(std::memory_order_acquire) & bit)) {
+			initDatasetItem(lazy->cache, item, itemNumber);
+			markDatasetItemsLazy(lazy, itemNumber / 64, bit);
+		}
+		return item;
+	}
+
+	void fillDatasetLazy(randomx_dataset* dataset, uint32_t startItem, uint32_t endItem) {
+		LazyDataset* lazy = dataset->lazy;
+		randomx_cache* cache = lazy->cache;
+		uint32_t itemNumber = startItem;
+		while (itemNumber < endItem) {
+			uint32_t word = itemNumber / 64;
+			uint32_t wordEnd = std::min((word + 1) * 64, endItem);
+			uint64_t valid = lazy->bitmap[word].load(std::memory_order_acquire);
+			if (valid == 0 && itemNumber % 64 == 0 && wordEnd - itemNumber == 64) {
+				//whole words are calculated by the (possibly compiled) dataset init function
+				cache->datasetInit(cache, dataset->memory + (uint64_t)itemNumber * CacheLineSize, itemNumber, wordEnd);
+				markDatasetItemsLazy(lazy, word, ~0ULL);
+			}
+			else {
+				for (; itemNumber < wordEnd; ++itemNumber) {
+					getDatasetItemLazy(dataset, itemNumber);
+				}
+			}
+			itemNumber = wordEnd;
+		}
+	}
+
+	//256 KiB of dataset per chunk; a multiple of 4 items for the JIT compilers
+	constexpr unsigned long DatasetInitChunkItems = 4096;
+
+	void initDatasetParallel(randomx_dataset* dataset, randomx_cache* cache, unsigned threadCount, uint64_t affinityMask, bool lowPriority, const std::atomic<bool>* abort) {
+		constexpr unsigned long itemCount = DatasetSize / CacheLineSize;
+		std::atomic<unsigned long> nextItem(0);
+		auto worker = [dataset, cache, lowPriority, abort, &nextItem](int cpuid) {
+			if (cpuid >= 0) {
+				set_thread_affinity(cpuid);
+			}
+			if (lowPriority) {
+				set_thread_low_priority();
+			}
+			while (abort == nullptr || !abort->load()) {
+				unsigned long startItem = nextItem.fetch_add(DatasetInitChunkItems);
+				if (startItem >= itemCount)
+					break;
+				randomx_init_dataset(dataset, cache, startItem, std::min(DatasetInitChunkItems, itemCount - startItem));
+			}
+		};
+
+		if (threadCount == 0) {
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+		if (threadCount == 1 && affinityMask == 0) {
+			worker(-1);
+			return;
+		}
+
+		unsigned cpuCount = 0;
+		for (uint64_t mask = affinityMask; mask != 0; mask &= mask - 1) {
+			cpuCount++;
+		}
+
+		std::vector<std::thread> threads;
+		try {
+			for (unsigned i = 0; i < threadCount; ++i) {
+				int cpuid = cpuCount > 0 ? (int)cpuid_from_mask(affinityMask, i % cpuCount) : -1;
+				threads.emplace_back(worker, cpuid);
+			}
+		}
+		catch (std::system_error &ex) {
+			//if no more threads can be created, the calling thread helps with the rest
+			worker(-1);
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
 }
@@ -30,16 +30,24 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <cstdint>
 #include <vector>
+#include <atomic>
 #include <type_traits>
 #include "common.hpp"
 #include "superscalar_program.hpp"
 #include "allocator.hpp"
 #include "argon2.h"
 
+namespace randomx {
+	struct LazyDataset;
+}
+
 /* Global scope for C binding */
 struct randomx_dataset {
 	uint8_t* memory = nullptr;
 	randomx::DatasetDeallocFunc* dealloc;
+	randomx::LazyDataset* lazy = nullptr;
+	size_t pageSize = 0;
+	randomx_allocator allocator = {};
 };
 
 /* Global scope for C binding */
@@ -53,6 +61,8 @@ struct randomx_cache {
 	std::vector<uint64_t> reciprocalCache;
 	std::string cacheKey;
 	randomx_argon2_impl* argonImpl;
+	size_t pageSize = 0;
+	randomx_allocator allocator = {};
 
 	bool isInitialized() {
 		return programs[0].getSize() != 0;
@@ -77,21 +87,67 @@ namespace randomx {
 
 	using DefaultAllocator = AlignedAllocator<CacheLineSize>;
 
+	constexpr uint64_t superscalarMul0 = 6364136223846793005ULL;
+	constexpr uint64_t superscalarAdd1 = 9298411001130361340ULL;
+	constexpr uint64_t superscalarAdd2 = 12065312585734608966ULL;
+	constexpr uint64_t superscalarAdd3 = 9306329213124626780ULL;
+	constexpr uint64_t superscalarAdd4 = 5281919268842080866ULL;
+	constexpr uint64_t superscalarAdd5 = 10536153434571861004ULL;
+	constexpr uint64_t superscalarAdd6 = 3398623926847679864ULL;
+	constexpr uint64_t superscalarAdd7 = 9549104520008361294ULL;
+
+	//Dataset items are calculated on first access and marked as valid in the bitmap
+	struct LazyDataset {
+		randomx_cache* cache;
+		std::string cacheKey;
+		std::vector<std::atomic<uint64_t>> bitmap;
+		std::atomic<uint64_t> readyCount;
+	};
+
+	//returns the lazy state of the dataset if it was prepared with this cache and key
+	inline LazyDataset* getLazyDataset(randomx_dataset* dataset, randomx_cache* cache) {
+		if (dataset == nullptr || dataset->lazy == nullptr)
+			return nullptr;
+		LazyDataset* lazy = dataset->lazy;
+		if (lazy->cache != cache || lazy->cacheKey != cache->cacheKey)
+			return nullptr;
+		return lazy;
+	}
+
 	template<class Allocator>
 	void deallocDataset(randomx_dataset* dataset) {
 		if (dataset->memory != nullptr)
 			Allocator::freeMemory(dataset->memory, DatasetSize);
 	}
 
+	template<>
+	inline void deallocDataset<UserAllocator>(randomx_dataset* dataset) {
+		UserAllocator::freeMemory(dataset->allocator, dataset->memory, DatasetSize, RANDOMX_MEMORY_DATASET);
+	}
+
 	template<class Allocator>
 	void deallocCache(randomx_cache* cache);
 
+	template<>
+	void deallocCache<UserAllocator>(randomx_cache* cache);
+
 	void initCache(randomx_cache*, const void*, size_t);
 	void initCacheCompile(randomx_cache*, const void*, size_t);
+	//generates the SuperscalarHash programs of the key without touching the cache memory
+	void generateCachePrograms(randomx_cache*, const void*, size_t);
+	void compileCache(randomx_cache*);
 	void initDatasetItem(randomx_cache* cache, uint8_t* out, uint64_t blockNumber);
+	void initDatasetItemPair(randomx_cache* cache, uint8_t* out, uint64_t blockNumber);
 	void initDataset(randomx_cache* cache, uint8_t* dataset, uint32_t startBlock, uint32_t endBlock);
+	void initDatasetLazy(randomx_dataset* dataset, randomx_cache* cache);
+	const uint8_t* getDatasetItemLazy(randomx_dataset* dataset, uint32_t itemNumber);
+	void fillDatasetLazy(randomx_dataset* dataset, uint32_t startItem, uint32_t endItem);
+	void initDatasetParallel(randomx_dataset* dataset, randomx_cache* cache, unsigned threadCount, uint64_t affinityMask, bool lowPriority = false, const std::atomic<bool>* abort = nullptr);
 
 	inline randomx_argon2_impl* selectArgonImpl(randomx_flags flags) {
+		if (flags & RANDOMX_FLAG_ARGON2_AVX512) {
+			return randomx_argon2_impl_avx512();
+		}
 		if (flags & RANDOMX_FLAG_ARGON2_AVX2) {
 			return randomx_argon2_impl_avx2();
 		}
@@ -0,0 +1,145 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include "dataset_file.hpp"
+#include "common.hpp"
+#include "virtual_memory.h"
+#include "blake2/blake2.h"
+
+namespace randomx {
+
+	static const char FileMagic[8] = { 'R', 'a', 'n', 'd', 'o', 'm', 'X', 'F' };
+
+	//Hashes all configuration parameters that affect the contents of the cache
+	//and the dataset, so files produced by a differently configured build are rejected.
+	//Data are stored in native byte order, so the endianness is included as well.
+	static void configHash(uint8_t (&out)[32]) {
+		const uint64_t params[] = {
+			RANDOMX_ARGON_MEMORY,
+			RANDOMX_ARGON_ITERATIONS,
+			RANDOMX_ARGON_LANES,
+			RANDOMX_CACHE_ACCESSES,
+			RANDOMX_SUPERSCALAR_LATENCY,
+			RANDOMX_DATASET_BASE_SIZE,
+			RANDOMX_DATASET_EXTRA_SIZE,
+			RANDOMX_DATASET_ITEM_SIZE,
+			0x0102030405060708,
+		};
+		blake2b_state state;
+		blake2b_init(&state, sizeof(out));
+		blake2b_update(&state, params, sizeof(params));
+		blake2b_update(&state, RANDOMX_ARGON_SALT, ArgonSaltSize);
+		blake2b_final(&state, out, sizeof(out));
+	}
+
+	static void keyHash(uint8_t (&out)[32], const void* key, size_t keySize) {
+		blake2b(out, sizeof(out), key, keySize, nullptr, 0);
+	}
+
+	void initFileHeader(FileHeader& header, FileKind kind, const void* key, size_t keySize, uint64_t dataSize) {
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, FileMagic, sizeof(FileMagic));
+		header.version = FileFormatVersion;
+		header.kind = (uint32_t)kind;
+		configHash(header.configHash);
+		keyHash(header.keyHash, key, keySize);
+		header.keySize = keySize;
+		header.dataSize = dataSize;
+	}
+
+	bool checkFileHeader(const FileHeader& header, FileKind kind, const void* key, size_t keySize, uint64_t dataSize) {
+		FileHeader expected;
+		initFileHeader(expected, kind, key, keySize, dataSize);
+		return memcmp(&header, &expected, sizeof(header)) == 0;
+	}
+
+	bool readFileHeader(const char* path, FileHeader& header) {
+		FILE* file = fopen(path, "rb");
+		if (file == nullptr)
+			return false;
+		bool ok = fread(&header, sizeof(header), 1, file) == 1;
+		fclose(file);
+		return ok;
+	}
+
+	bool readFileData(const char* path, size_t offset, void* out, size_t size) {
+		FILE* file = fopen(path, "rb");
+		if (file == nullptr)
+			return false;
+		bool ok = fseek(file, (long)offset, SEEK_SET) == 0 && fread(out, size, 1, file) == 1;
+		fclose(file);
+		return ok;
+	}
+
+	uint8_t* createSharedSegment(const char* name, uint64_t dataSize) {
+		return (uint8_t*)createSharedMemory(name, fileSize(dataSize));
+	}
+
+	void publishSharedSegment(uint8_t* segment, FileKind kind, const void* key, size_t keySize, uint64_t dataSize) {
+		SharedHeader* shared = (SharedHeader*)segment;
+		initFileHeader(shared->header, kind, key, keySize, dataSize);
+		shared->ready.store(SharedReady, std::memory_order_release);
+	}
+
+	uint8_t* attachSharedSegment(const char* name, FileKind kind, const void* key, size_t keySize, uint64_t dataSize, unsigned long timeoutMs) {
+		const size_t size = fileSize(dataSize);
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+		uint8_t* segment = nullptr;
+		for (;;) {
+			//the segment does not exist or has not been sized until the creator gets to it
+			if (segment == nullptr) {
+				segment = (uint8_t*)openSharedMemory(name, size);
+			}
+			if (segment != nullptr) {
+				SharedHeader* shared = (SharedHeader*)segment;
+				if (shared->ready.load(std::memory_order_acquire) == SharedReady) {
+					if (checkFileHeader(shared->header, kind, key, keySize, dataSize)) {
+						return segment;
+					}
+					break;
+				}
+			}
+			if (std::chrono::steady_clock::now() >= deadline) {
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		if (segment != nullptr) {
+			unmapFileMemory(segment, size);
+		}
+		return nullptr;
+	}
+
+	void releaseSharedSegment(uint8_t* segment, uint64_t dataSize) {
+		unmapFileMemory(segment, fileSize(dataSize));
+	}
+}
@@ -0,0 +1,92 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include "common.hpp"
+
+namespace randomx {
+
+	//Files produced by randomx_save_dataset and randomx_save_cache have the following layout:
+	//[FileHeader][zero padding][data]
+	//The data starts at FileDataOffset, which is a multiple of the 2 MiB large
+	//page size and the 64 KiB allocation granularity of Windows, so it can be
+	//mapped directly from a regular file or from a file on hugetlbfs.
+	//A cache file contains only the cache memory; the SuperscalarHash programs
+	//are always generated from the key when the cache is loaded.
+	constexpr size_t FileDataOffset = 2 * 1024 * 1024;
+	constexpr uint32_t FileFormatVersion = 2;
+
+	enum class FileKind : uint32_t {
+		Dataset = 1,
+		Cache = 2,
+	};
+
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t kind;
+		uint8_t configHash[32];
+		uint8_t keyHash[32];
+		uint64_t keySize;
+		uint64_t dataSize;
+	};
+
+	//Shared memory segments created by randomx_create_shared_cache and randomx_create_shared_dataset
+	//have the file layout. The creator sets 'ready' after the data and the header have been written,
+	//so attached processes never use a partially initialized segment.
+	struct SharedHeader {
+		FileHeader header;
+		std::atomic<uint32_t> ready;
+	};
+
+	constexpr uint32_t SharedReady = 1;
+
+	static_assert(ATOMIC_INT_LOCK_FREE == 2, "the ready flag must be lock-free to be shared between processes");
+	static_assert(sizeof(SharedHeader) <= FileDataOffset, "SharedHeader must fit before the data");
+
+	inline size_t fileSize(size_t dataSize) {
+		return (FileDataOffset + dataSize + FileDataOffset - 1) / FileDataOffset * FileDataOffset;
+	}
+
+	void initFileHeader(FileHeader& header, FileKind kind, const void* key, size_t keySize, uint64_t dataSize);
+	bool checkFileHeader(const FileHeader& header, FileKind kind, const void* key, size_t keySize, uint64_t dataSize);
+	bool readFileHeader(const char* path, FileHeader& header);
+	bool readFileData(const char* path, size_t offset, void* out, size_t size);
+
+	//returns the base of the segment mapped writable, nullptr if it exists or cannot be created
+	uint8_t* createSharedSegment(const char* name, uint64_t dataSize);
+	void publishSharedSegment(uint8_t* segment, FileKind kind, const void* key, size_t keySize, uint64_t dataSize);
+	//waits up to timeoutMs milliseconds for the segment to be published and returns its base
+	//mapped read-only, nullptr on timeout or if it was built with a different key or configuration
+	uint8_t* attachSharedSegment(const char* name, FileKind kind, const void* key, size_t keySize, uint64_t dataSize, unsigned long timeoutMs);
+	void releaseSharedSegment(uint8_t* segment, uint64_t dataSize);
+}
@@ -0,0 +1,125 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "dispatch.hpp"
+#include "common.hpp"
+#include "soft_aes.h"
+#include "aes_hash_vaes.hpp"
+
+namespace randomx {
+
+	static DispatchTable buildDispatchTable() {
+		DispatchTable table{};
+		const Cpu& cpu = table.cpu;
+
+		table.names[RANDOMX_KERNEL_AES] = (HAVE_AES && cpu.hasAes()) ? "hardware" : "unsupported";
+		table.names[RANDOMX_KERNEL_SOFT_AES] = "table";
+#if defined(_M_X64) || defined(__x86_64__)
+		if (cpu.hasAes()) {
+			table.names[RANDOMX_KERNEL_AES] = "AES-NI";
+		}
+#endif
+#ifdef RANDOMX_HAVE_VAES
+		//not selected by default, see RANDOMX_FLAG_VAES
+		if (cpu.hasVaes()) {
+			table.hardAes = { &hashAes1Rx4_vaes, &fillAes1Rx4_vaes, &fillAes4Rx4_vaes, &hashAndFillAes1Rx4_vaes };
+		}
+#endif
+#ifdef RANDOMX_HAVE_SOFT_AES_VPERM
+		if (cpu.hasAvx2()) {
+			table.softAes = { &hashAes1Rx4_soft_avx2, &fillAes1Rx4_soft_avx2, &fillAes4Rx4_soft_avx2, &hashAndFillAes1Rx4_soft_avx2 };
+			table.names[RANDOMX_KERNEL_SOFT_AES] = "AVX2 vperm";
+		}
+		else if (cpu.hasSsse3()) {
+			table.names[RANDOMX_KERNEL_SOFT_AES] = "SSSE3 vperm";
+		}
+#endif
+#ifdef __riscv
+		if (cpu.hasAes()) {
+			table.names[RANDOMX_KERNEL_AES] = "Zvkned";
+		}
+		if (cpu.hasRVV() && cpu.getRVV_Length() >= 256) {
+			table.names[RANDOMX_KERNEL_SOFT_AES] = "RVV";
+		}
+#endif
+
+		table.names[RANDOMX_KERNEL_BLAKE2B] = "reference";
+		if (cpu.hasAvx2() && (table.blake2bCompress = randomx_blake2b_compress_avx2()) != nullptr) {
+			table.names[RANDOMX_KERNEL_BLAKE2B] = "AVX2";
+		}
+		else if (cpu.hasSse41() && (table.blake2bCompress = randomx_blake2b_compress_sse41()) != nullptr) {
+			table.names[RANDOMX_KERNEL_BLAKE2B] = "SSE4.1";
+		}
+		if (cpu.hasAvx2()) {
+			table.blake2b4way = randomx_blake2b_4way_avx2();
+		}
+
+		table.argon2 = &randomx_argon2_fill_segment_ref;
+		table.argon2Flags = RANDOMX_FLAG_DEFAULT;
+		table.names[RANDOMX_KERNEL_ARGON2] = "reference";
+		//in order of increasing preference
+		if (cpu.hasSsse3() && randomx_argon2_impl_ssse3() != nullptr) {
+			table.argon2 = randomx_argon2_impl_ssse3();
+			table.argon2Flags |= RANDOMX_FLAG_ARGON2_SSSE3;
+			table.names[RANDOMX_KERNEL_ARGON2] = "SSSE3";
+		}
+		if (cpu.hasAvx2() && randomx_argon2_impl_avx2() != nullptr) {
+			table.argon2 = randomx_argon2_impl_avx2();
+			table.argon2Flags |= RANDOMX_FLAG_ARGON2_AVX2;
+			table.names[RANDOMX_KERNEL_ARGON2] = "AVX2";
+		}
+		//the AVX-512 Argon2 kernel only uses AVX512F instructions
+		if (cpu.hasAvx512F() && randomx_argon2_impl_avx512() != nullptr) {
+			table.argon2 = randomx_argon2_impl_avx512();
+			table.argon2Flags |= RANDOMX_FLAG_ARGON2_AVX512;
+			table.names[RANDOMX_KERNEL_ARGON2] = "AVX-512";
+		}
+
+		table.names[RANDOMX_KERNEL_SUPERSCALAR] = RANDOMX_HAVE_COMPILER ? "JIT" : "interpreter";
+#ifdef RANDOMX_COMPILER_X86
+		if (cpu.hasAvx512()) {
+			table.superscalarAvx512 = true;
+			table.names[RANDOMX_KERNEL_SUPERSCALAR] = "AVX-512 JIT";
+		}
+#endif
+		return table;
+	}
+
+	const DispatchTable& getDispatchTable() {
+		static const DispatchTable table = buildDispatchTable();
+		return table;
+	}
+}
+
+extern "C" randomx_blake2b_compress_fn* randomx_blake2b_select_compress() {
+	return randomx::getDispatchTable().blake2bCompress;
+}
+
+extern "C" randomx_blake2b_4way_fn* randomx_blake2b_select_4way() {
+	return randomx::getDispatchTable().blake2b4way;
+}
@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include "cpu.hpp"
+#include "randomx.h"
+#include "blake2/blake2.h"
+#include "argon2.h"
+
+namespace randomx {
+
+	//scratchpad hashing and filling kernels, see aes_hash.hpp
+	struct AesKernels {
+		void(*hashAes1Rx4)(const void *input, size_t inputSize, void *hash);
+		void(*fillAes1Rx4)(void *state, size_t outputSize, void *buffer);
+		void(*fillAes4Rx4)(void *state, size_t outputSize, void *buffer);
+		void(*hashAndFillAes1Rx4)(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state);
+	};
+
+	//The best implementation of each kernel for the CPU that runs the process.
+	//The table is built once on first use and never changes afterwards.
+	struct DispatchTable {
+		Cpu cpu;
+		//256-bit scratchpad AES for virtual machines created with RANDOMX_FLAG_VAES,
+		//all members are nullptr if the CPU does not support it
+		AesKernels hardAes;
+		//only valid while SoftAesImpl::Vperm is selected (see soft_aes.h)
+		AesKernels softAes;
+		//nullptr selects the reference code
+		randomx_blake2b_compress_fn* blake2bCompress;
+		randomx_blake2b_4way_fn* blake2b4way;
+		//the fastest Argon2 implementation and all RANDOMX_FLAG_ARGON2_* flags supported by the CPU
+		randomx_argon2_impl* argon2;
+		randomx_flags argon2Flags;
+		//superscalar dataset initialization with the AVX-512 JIT code
+		bool superscalarAvx512;
+		const char* names[RANDOMX_KERNEL_COUNT];
+	};
+
+	const DispatchTable& getDispatchTable();
+}
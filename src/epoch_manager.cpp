@@ -0,0 +1,118 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <new>
+#include <system_error>
+#include "epoch_manager.hpp"
+#include "dataset.hpp"
+#include "affinity.hpp"
+
+randomx_epoch_manager::randomx_epoch_manager(randomx_flags flags, unsigned threadCount, uint64_t affinityMask)
+	: flags(flags), threadCount(threadCount), affinityMask(affinityMask), abort(false), ready(false) {
+	cache = randomx_alloc_cache(flags);
+	if (cache == nullptr)
+		throw std::bad_alloc();
+}
+
+randomx_epoch_manager::~randomx_epoch_manager() {
+	abortBuild();
+	if (current != nullptr)
+		randomx_release_dataset(current);
+	if (next != nullptr)
+		randomx_release_dataset(next);
+	randomx_release_cache(cache);
+}
+
+void randomx_epoch_manager::registerVm(randomx_vm* vm) {
+	std::lock_guard<std::mutex> lock(mutex);
+	vms.push_back(vm);
+	if (current != nullptr)
+		randomx_vm_set_dataset(vm, current);
+}
+
+void randomx_epoch_manager::unregisterVm(randomx_vm* vm) {
+	std::lock_guard<std::mutex> lock(mutex);
+	vms.erase(std::remove(vms.begin(), vms.end(), vm), vms.end());
+}
+
+bool randomx_epoch_manager::prepare(const void* key, size_t keySize) {
+	std::lock_guard<std::mutex> lock(mutex);
+	abortBuild();
+	if (next == nullptr) {
+		next = randomx_alloc_dataset(flags);
+		if (next == nullptr)
+			return false;
+	}
+	nextKey.assign((const char*)key, keySize);
+	try {
+		builder = std::thread(&randomx_epoch_manager::build, this);
+	}
+	catch (std::system_error& ex) {
+		return false;
+	}
+	return true;
+}
+
+bool randomx_epoch_manager::switchDataset() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (builder.joinable())
+		builder.join();
+	if (!ready.load())
+		return false;
+	for (auto vm : vms)
+		randomx_vm_set_dataset(vm, next);
+	//the previous dataset is rebuilt for the next key, so no memory is allocated per epoch
+	std::swap(current, next);
+	ready = false;
+	return true;
+}
+
+randomx_dataset* randomx_epoch_manager::getDataset() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return current;
+}
+
+void randomx_epoch_manager::build() {
+	randomx::set_thread_low_priority();
+	randomx_init_cache(cache, nextKey.data(), nextKey.size());
+	if (abort.load())
+		return;
+	randomx::initDatasetParallel(next, cache, threadCount, affinityMask, true, &abort);
+	if (!abort.load())
+		ready = true;
+}
+
+void randomx_epoch_manager::abortBuild() {
+	if (builder.joinable()) {
+		abort = true;
+		builder.join();
+		abort = false;
+	}
+	ready = false;
+}
@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "randomx.h"
+
+/* Global namespace for C binding */
+class randomx_epoch_manager {
+public:
+	randomx_epoch_manager(randomx_flags flags, unsigned threadCount, uint64_t affinityMask);
+	~randomx_epoch_manager();
+	void registerVm(randomx_vm* vm);
+	void unregisterVm(randomx_vm* vm);
+	bool prepare(const void* key, size_t keySize);
+	bool isReady() const {
+		return ready.load();
+	}
+	bool switchDataset();
+	randomx_dataset* getDataset();
+private:
+	void build();
+	void abortBuild();
+
+	const randomx_flags flags;
+	const unsigned threadCount;
+	const uint64_t affinityMask;
+	std::mutex mutex;
+	std::vector<randomx_vm*> vms;
+	randomx_cache* cache = nullptr;
+	randomx_dataset* current = nullptr;
+	randomx_dataset* next = nullptr;
+	std::string nextKey;
+	std::thread builder;
+	std::atomic<bool> abort;
+	std::atomic<bool> ready;
+};
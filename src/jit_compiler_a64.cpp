@@ -32,6 +32,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "program.hpp"
 #include "reciprocal.h"
 #include "virtual_memory.h"
+#include "allocator.hpp"
 #include "soft_aes.h"
 
 namespace ARMV8A {
@@ -89,13 +90,14 @@ constexpr uint32_t IntRegMap[8] = { 4, 5, 6, 7, 12, 13, 14, 15 };
 
 template<typename T> static constexpr size_t Log2(T value) { return (value > 1) ? (Log2(value / 2) + 1) : 0; }
 
-JitCompilerA64::JitCompilerA64()
-	: code((uint8_t*) allocMemoryPages(CodeSize + CalcDatasetItemSize))
+JitCompilerA64::JitCompilerA64(const randomx_allocator* alloc)
+	: allocator(alloc != nullptr ? *alloc : randomx_allocator{})
+	, code((uint8_t*) allocCodeMemory(allocator, CodeSize + CalcDatasetItemSize))
 	, literalPos(ImulRcpLiteralsEnd)
 	, num32bitLiterals(0)
 {
 	if (code == nullptr)
-		throw std::runtime_error("allocMemoryPages");
+		throw std::runtime_error("allocCodeMemory");
 	memset(reg_changed_offset, 0, sizeof(reg_changed_offset));
 	memcpy(code, (void*) randomx_program_aarch64, CodeSize);
 
@@ -106,7 +108,7 @@ JitCompilerA64::JitCompilerA64()
 
 JitCompilerA64::~JitCompilerA64()
 {
-	freePagedMemory(code, CodeSize + CalcDatasetItemSize);
+	freeCodeMemory(allocator, code, CodeSize + CalcDatasetItemSize);
 }
 
 void JitCompilerA64::enableWriting()
@@ -46,13 +46,18 @@ namespace randomx {
 
 	class JitCompilerA64 {
 	public:
-		JitCompilerA64();
+		explicit JitCompilerA64(const randomx_allocator* allocator = nullptr);
 		~JitCompilerA64();
 
 		void generateProgram(Program&, ProgramConfiguration&);
 		void generateProgramLight(Program&, ProgramConfiguration&, uint32_t);
+		void generateProgramLazy(Program& prog, ProgramConfiguration& pcfg, uint32_t datasetOffset, uint8_t*, const void*, const void*) {
+			//dataset items are not cached by this compiler
+			generateProgramLight(prog, pcfg, datasetOffset);
+		}
 
 		void generateSuperscalarHash(SuperscalarProgramList &programs, std::vector<uint64_t> &);
+		bool shareSuperscalarHash(const JitCompilerA64&) { return false; }
 
 		void generateDatasetInitCode() {}
 
@@ -69,6 +74,7 @@ namespace randomx {
 	private:
 		static InstructionGeneratorA64 engine[256];
 		uint32_t reg_changed_offset[8];
+		randomx_allocator allocator;
 		uint8_t* code;
 		uint32_t literalPos;
 		uint32_t num32bitLiterals;
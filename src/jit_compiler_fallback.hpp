@@ -41,7 +41,7 @@ namespace randomx {
 
 	class JitCompilerFallback {
 	public:
-		JitCompilerFallback() {
+		explicit JitCompilerFallback(const randomx_allocator* = nullptr) {
 			throw std::runtime_error("JIT compilation is not supported on this platform");
 		}
 		void generateProgram(Program&, ProgramConfiguration&) {
@@ -49,10 +49,16 @@ namespace randomx {
 		}
 		void generateProgramLight(Program&, ProgramConfiguration&, uint32_t) {
 
+		}
+		void generateProgramLazy(Program&, ProgramConfiguration&, uint32_t, uint8_t*, const void*, const void*) {
+
 		}
 
 		void generateSuperscalarHash(SuperscalarProgramList& programs, std::vector<uint64_t> &) {
 
+		}
+		bool shareSuperscalarHash(const JitCompilerFallback&) {
+			return false;
 		}
 		void generateDatasetInitCode() {
 
@@ -36,6 +36,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "program.hpp"
 #include "reciprocal.h"
 #include "virtual_memory.h"
+#include "allocator.hpp"
 #include "cpu.hpp"
 #include "jit_compiler_rv64_vector_static.h"
 #include "jit_compiler_rv64_vector.h"
@@ -620,10 +621,13 @@ namespace randomx {
 		return CodeSize;
 	}
 
-	JitCompilerRV64::JitCompilerRV64() {
-		state.code = (uint8_t*)allocMemoryPages(CodeSize);
+	JitCompilerRV64::JitCompilerRV64(const randomx_allocator* alloc) {
+		if (alloc != nullptr) {
+			allocator = *alloc;
+		}
+		state.code = (uint8_t*)allocCodeMemory(allocator, CodeSize);
 		if (state.code == nullptr)
-			throw std::runtime_error("allocMemoryPages");
+			throw std::runtime_error("allocCodeMemory");
 		state.emitAt(LiteralPoolOffset, codeLiterals, sizeLiterals);
 		state.emitAt(LiteralPoolSize, codeDataInit, sizeDataInit + sizePrologue + sizeLoopBegin);
 		entryDataInit = state.code + LiteralPoolSize;
@@ -635,7 +639,7 @@ namespace randomx {
 			vectorRegisterLength = randomx::cpu.getRVV_Length();
 
 			vectorCodeSize = ((uint8_t*)randomx_riscv64_vector_code_end) - ((uint8_t*)randomx_riscv64_vector_code_begin);
-			vectorCode = static_cast<uint8_t*>(allocMemoryPages(vectorCodeSize));
+			vectorCode = static_cast<uint8_t*>(allocCodeMemory(allocator, vectorCodeSize));
 
 			if (vectorCode) {
 				memcpy(vectorCode, reinterpret_cast<uint8_t*>(randomx_riscv64_vector_code_begin), vectorCodeSize);
@@ -646,9 +650,9 @@ namespace randomx {
 	}
 
 	JitCompilerRV64::~JitCompilerRV64() {
-		freePagedMemory(state.code, CodeSize);
+		freeCodeMemory(allocator, state.code, CodeSize);
 		if (vectorCode) {
-			freePagedMemory(vectorCode, vectorCodeSize);
+			freeCodeMemory(allocator, vectorCode, vectorCodeSize);
 		}
 	}
 
@@ -42,11 +42,16 @@ namespace randomx {
 
 	class JitCompilerRV64 {
 	public:
-		JitCompilerRV64();
+		explicit JitCompilerRV64(const randomx_allocator* allocator = nullptr);
 		~JitCompilerRV64();
 		void generateProgram(Program&, ProgramConfiguration&);
 		void generateProgramLight(Program&, ProgramConfiguration&, uint32_t);
+		void generateProgramLazy(Program& prog, ProgramConfiguration& pcfg, uint32_t datasetOffset, uint8_t*, const void*, const void*) {
+			//dataset items are not cached by this compiler
+			generateProgramLight(prog, pcfg, datasetOffset);
+		}
 		void generateSuperscalarHash(SuperscalarProgramList &programs, std::vector<uint64_t>&);
+		bool shareSuperscalarHash(const JitCompilerRV64&) { return false; }
 		void generateDatasetInitCode() {}
 		ProgramFunc* getProgramFunc() {
 			return (ProgramFunc*)(vectorCode ? entryProgramVector : entryProgram);
@@ -66,6 +71,7 @@ namespace randomx {
 
 		static uint8_t instMap[256];
 	private:
+		randomx_allocator allocator = {};
 		CompilerState state;
 
 		randomx_flags flags;
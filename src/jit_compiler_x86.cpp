@@ -31,11 +31,14 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <climits>
 #include "jit_compiler_x86.hpp"
 #include "jit_compiler_x86_static.hpp"
+#include "jit_compiler_x86_avx512.hpp"
 #include "superscalar.hpp"
 #include "program.hpp"
 #include "reciprocal.h"
 #include "virtual_memory.h"
+#include "allocator.hpp"
 #include "soft_aes.h"
+#include "dispatch.hpp"
 
 namespace randomx {
 	/*
@@ -162,6 +165,10 @@ namespace randomx {
 	const uint8_t* codeLoopEnd = ADDR(randomx_program_loop_end);
 	const uint8_t* codeSoftAes = ADDR(randomx_program_soft_aes);
 	const uint8_t* codeSoftAesEnd = ADDR(randomx_program_soft_aes_end);
+	const uint8_t* codeLoopStoreSoftAesVperm = ADDR(randomx_program_loop_store_soft_aes_vperm);
+	const uint8_t* codeLoopEndVperm = ADDR(randomx_program_loop_end_vperm);
+	const uint8_t* codeSoftAesVperm = ADDR(randomx_program_soft_aes_vperm);
+	const uint8_t* codeSoftAesVpermEnd = ADDR(randomx_program_soft_aes_vperm_end);
 	const uint8_t* codeEpilogue = ADDR(randomx_program_epilogue);
 	const uint8_t* codeProgramEnd = ADDR(randomx_program_end);
 	const uint8_t* codeShhLoad = ADDR(randomx_sshash_load);
@@ -180,6 +187,8 @@ namespace randomx {
 	const int32_t loopStoreHardAesSize = codeLoopStoreSoftAes - codeLoopStoreHardAes;
 	const int32_t loopStoreSoftAesSize = codeLoopEnd - codeLoopStoreSoftAes;
 	const int32_t softAesSize = codeSoftAesEnd - codeSoftAes;
+	const int32_t loopStoreSoftAesVpermSize = codeLoopEndVperm - codeLoopStoreSoftAesVperm;
+	const int32_t softAesVpermSize = codeSoftAesVpermEnd - codeSoftAesVperm;
 
 	const int32_t datasetInitSize = codeEpilogue - codeDatasetInit;
 	const int32_t epilogueSize = codeShhLoad - codeEpilogue;
@@ -259,6 +268,20 @@ namespace randomx {
 	static const uint8_t REX_PADD[] = { 0x66, 0x44, 0x0f };
 	static const uint8_t PADD_OPCODES[] = { 0xfc, 0xfd, 0xfe, 0xd4 };
 	static const uint8_t CALL = 0xe8;
+	static const uint8_t CALL_RAX[] = { 0xff, 0xd0 };
+	static const uint8_t MOV_RDX_I[] = { 0x48, 0xba };
+	static const uint8_t BT_RDX_RBX[] = { 0x48, 0x0f, 0xa3, 0x1a };
+	static const uint8_t LOCK_BTS_RDX_RCX[] = { 0xf0, 0x48, 0x0f, 0xab, 0x0a };
+	static const uint8_t LOCK_INC_RDX[] = { 0xf0, 0x48, 0xff, 0x02 };
+	static const uint8_t SHL_RCX_6[] = { 0x48, 0xc1, 0xe1, 0x06 };
+	static const uint8_t SHR_RCX_6[] = { 0x48, 0xc1, 0xe9, 0x06 };
+	static const uint8_t SHL_RBX_6[] = { 0x48, 0xc1, 0xe3, 0x06 };
+	static const uint8_t REX_MOV_RDX_RCX_R[] = { 0x4c, 0x89 };
+	static const uint8_t REX_MOV_R_RDX_RBX[] = { 0x4c, 0x8b };
+	static const uint8_t PUSH_RBX = 0x53;
+	static const uint8_t POP_RCX = 0x59;
+	static const uint8_t JC_SHORT = 0x72;
+	static const uint8_t JMP_SHORT = 0xeb;
 	static const uint8_t REX_ADD_I[] = { 0x49, 0x81 };
 	static const uint8_t REX_TEST[] = { 0x49, 0xF7 };
 	static const uint8_t JZ[] = { 0x0f, 0x84 };
@@ -293,28 +316,43 @@ namespace randomx {
 		}
 	}
 
-	JitCompilerX86::JitCompilerX86() {
-		code = (uint8_t*)allocMemoryPages(CodeSize);
+	JitCompilerX86::JitCompilerX86(const randomx_allocator* alloc) {
+		if (alloc != nullptr) {
+			allocator = *alloc;
+		}
+		code = (uint8_t*)allocCodeMemory(allocator, CodeSize);
 		if (code == nullptr)
-			throw std::runtime_error("allocMemoryPages");
+			throw std::runtime_error("allocCodeMemory");
 		memcpy(code, codePrologue, prologueSize);
 		memcpy(code + epilogueOffset, codeEpilogue, epilogueSize);
 	}
 
 	JitCompilerX86::~JitCompilerX86() {
-		freePagedMemory(code, CodeSize);
+		freeCodeMemory(allocator, code, CodeSize);
+		if (avx512Code) {
+			freeCodeMemory(allocator, avx512Code, getDatasetInitAvx512Size());
+		}
 	}
 
 	void JitCompilerX86::enableAll() {
 		setPagesRWX(code, CodeSize);
+		if (avx512Code) {
+			setPagesRWX(avx512Code, getDatasetInitAvx512Size());
+		}
 	}
 
 	void JitCompilerX86::enableWriting() {
 		setPagesRW(code, CodeSize);
+		if (avx512Code) {
+			setPagesRW(avx512Code, getDatasetInitAvx512Size());
+		}
 	}
 
 	void JitCompilerX86::enableExecution() {
 		setPagesRX(code, CodeSize);
+		if (avx512Code) {
+			setPagesRX(avx512Code, getDatasetInitAvx512Size());
+		}
 	}
 
 	void JitCompilerX86::generateProgram(Program& prog, ProgramConfiguration& pcfg) {
@@ -331,6 +369,63 @@ namespace randomx {
 
 	void JitCompilerX86::generateProgramLight(Program& prog, ProgramConfiguration& pcfg, uint32_t datasetOffset) {
 		generateProgramPrologue(prog, pcfg);
+		generateReadDatasetLightInit(datasetOffset);
+		generateSuperscalarHashCall();
+		emit(codeReadDatasetLightSshFin, readDatasetLightFinSize);
+		generateProgramEpilogue(prog, pcfg);
+	}
+
+	void JitCompilerX86::generateProgramLazy(Program& prog, ProgramConfiguration& pcfg, uint32_t datasetOffset, uint8_t* dataset, const void* bitmap, const void* readyCount) {
+		generateProgramPrologue(prog, pcfg);
+		generateReadDatasetLightInit(datasetOffset);
+		//rbx = item number, rcx and rdx are free
+		emit(MOV_RDX_I);
+		emit64((uint64_t)bitmap);
+		emit(BT_RDX_RBX);
+		emitByte(JC_SHORT);
+		int32_t validJump = codePos++;
+		//the item is not valid yet: calculate it, store it and set its bit
+		emitByte(PUSH_RBX);
+		generateSuperscalarHashCall();
+		emitByte(POP_RCX);
+		emit(MOV_RDX_I);
+		emit64((uint64_t)dataset);
+		emit(SHL_RCX_6);
+		for (unsigned i = 0; i < RegistersCount; ++i) {
+			emit(REX_MOV_RDX_RCX_R);
+			emitByte(0x44 + 8 * i);
+			emitByte(0x0a);
+			emitByte(8 * i);
+		}
+		emit(SHR_RCX_6);
+		emit(MOV_RDX_I);
+		emit64((uint64_t)bitmap);
+		emit(LOCK_BTS_RDX_RCX);
+		emitByte(JC_SHORT);
+		int32_t doneJump1 = codePos++;
+		emit(MOV_RDX_I);
+		emit64((uint64_t)readyCount);
+		emit(LOCK_INC_RDX);
+		emitByte(JMP_SHORT);
+		int32_t doneJump2 = codePos++;
+		code[validJump] = codePos - (validJump + 1);
+		//the item is valid: load it from the dataset
+		emit(MOV_RDX_I);
+		emit64((uint64_t)dataset);
+		emit(SHL_RBX_6);
+		for (unsigned i = 0; i < RegistersCount; ++i) {
+			emit(REX_MOV_R_RDX_RBX);
+			emitByte(0x44 + 8 * i);
+			emitByte(0x1a);
+			emitByte(8 * i);
+		}
+		code[doneJump1] = codePos - (doneJump1 + 1);
+		code[doneJump2] = codePos - (doneJump2 + 1);
+		emit(codeReadDatasetLightSshFin, readDatasetLightFinSize);
+		generateProgramEpilogue(prog, pcfg);
+	}
+
+	void JitCompilerX86::generateReadDatasetLightInit(uint32_t datasetOffset) {
 		if (vmFlags & RANDOMX_FLAG_V2) {
 			emit(codeReadDatasetLightSshInitV2, readDatasetLightInitV2Size);
 		}
@@ -339,13 +434,23 @@ namespace randomx {
 		}
 		emit(ADD_EBX_I);
 		emit32(datasetOffset / CacheLineSize);
-		emitByte(CALL);
-		emit32(superScalarHashOffset - (codePos + 4));
-		emit(codeReadDatasetLightSshFin, readDatasetLightFinSize);
-		generateProgramEpilogue(prog, pcfg);
+	}
+
+	void JitCompilerX86::generateSuperscalarHashCall() {
+		if (superscalarHash != nullptr) {
+			//rax is clobbered by SuperscalarHash anyway
+			emit(MOV_RAX_I);
+			emit64((uint64_t)superscalarHash);
+			emit(CALL_RAX);
+		}
+		else {
+			emitByte(CALL);
+			emit32(superScalarHashOffset - (codePos + 4));
+		}
 	}
 
 	void JitCompilerX86::generateSuperscalarHash(SuperscalarProgramList &programs, std::vector<uint64_t> &reciprocalCache) {
+		superscalarHash = nullptr;
 		memcpy(code + superScalarHashOffset, codeShhInit, codeSshInitSize);
 		codePos = superScalarHashOffset + codeSshInitSize;
 		for (unsigned j = 0; j < programs.size(); ++j) {
@@ -365,6 +470,18 @@ namespace randomx {
 			}
 		}
 		emitByte(RET);
+		//the buffer is allocated on first use so that compilers of VMs don't pay for it
+		if (avx512Code == nullptr && getDispatchTable().superscalarAvx512) {
+			avx512Code = (uint8_t*)allocCodeMemory(allocator, getDatasetInitAvx512Size());
+		}
+		if (avx512Code) {
+			entryDataInitAvx512 = generateDatasetInitAvx512(avx512Code, programs, reciprocalCache);
+		}
+	}
+
+	bool JitCompilerX86::shareSuperscalarHash(const JitCompilerX86& source) {
+		superscalarHash = source.code + superScalarHashOffset;
+		return true;
 	}
 
 	void JitCompilerX86::generateDatasetInitCode() {
@@ -404,6 +521,10 @@ namespace randomx {
 				memcpy(code + codePos, codeLoopStoreHardAes, loopStoreHardAesSize);
 				codePos += loopStoreHardAesSize;
 			}
+			else if (randomx::getSoftAesImpl() == randomx::SoftAesImpl::Vperm) {
+				memcpy(code + codePos, codeLoopStoreSoftAesVperm, loopStoreSoftAesVpermSize);
+				codePos += loopStoreSoftAesVpermSize;
+			}
 			else {
 				memcpy(code + codePos, codeLoopStoreSoftAes, loopStoreSoftAesSize);
 				codePos += loopStoreSoftAesSize;
@@ -419,10 +540,18 @@ namespace randomx {
 		emitByte(JMP);
 		emit32(epilogueOffset - codePos - 4);
 		if ((vmFlags & RANDOMX_FLAG_V2) && !(vmFlags & RANDOMX_FLAG_HARD_AES)) {
-			memcpy(code + codePos, codeSoftAes, softAesSize);
-			codePos += softAesSize;
-			emit64((uint64_t)randomx_aes_lut_enc);
-			emit64((uint64_t)randomx_aes_lut_dec);
+			//the loop store calls the AES routines copied here, so both must come from the same implementation
+			if (randomx::getSoftAesImpl() == randomx::SoftAesImpl::Vperm) {
+				memcpy(code + codePos, codeSoftAesVperm, softAesVpermSize);
+				codePos += softAesVpermSize;
+				emit64((uint64_t)randomx_aes_vperm);
+			}
+			else {
+				memcpy(code + codePos, codeSoftAes, softAesSize);
+				codePos += softAesSize;
+				emit64((uint64_t)randomx_aes_lut_enc);
+				emit64((uint64_t)randomx_aes_lut_dec);
+			}
 		}
 	}
 
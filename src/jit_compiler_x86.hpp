@@ -45,17 +45,19 @@ namespace randomx {
 
 	class JitCompilerX86 {
 	public:
-		JitCompilerX86();
+		explicit JitCompilerX86(const randomx_allocator* allocator = nullptr);
 		~JitCompilerX86();
 		void generateProgram(Program&, ProgramConfiguration&);
 		void generateProgramLight(Program&, ProgramConfiguration&, uint32_t);
+		void generateProgramLazy(Program&, ProgramConfiguration&, uint32_t, uint8_t*, const void*, const void*);
 		void generateSuperscalarHash(SuperscalarProgramList &programs, std::vector<uint64_t> &);
+		bool shareSuperscalarHash(const JitCompilerX86& source);
 		void generateDatasetInitCode();
 		ProgramFunc* getProgramFunc() {
 			return (ProgramFunc*)code;
 		}
 		DatasetInitFunc* getDatasetInitFunc() {
-			return (DatasetInitFunc*)code;
+			return (DatasetInitFunc*)(entryDataInitAvx512 ? entryDataInitAvx512 : code);
 		}
 		uint8_t* getCode() {
 			return code;
@@ -70,13 +72,19 @@ namespace randomx {
 		static InstructionGeneratorX86 engine[256];
 		std::vector<int32_t> instructionOffsets;
 		int registerUsage[RegistersCount];
+		randomx_allocator allocator = {};
 		uint8_t* code;
 		int32_t codePos;
+		const uint8_t* superscalarHash = nullptr;
+		uint8_t* avx512Code = nullptr;
+		void* entryDataInitAvx512 = nullptr;
 
 		randomx_flags vmFlags;
 
 		void generateProgramPrologue(Program&, ProgramConfiguration&);
 		void generateProgramEpilogue(Program&, ProgramConfiguration&);
+		void generateReadDatasetLightInit(uint32_t datasetOffset);
+		void generateSuperscalarHashCall();
 		void genAddressReg(Instruction&, bool);
 		void genAddressRegDst(Instruction&);
 		void genAddressImm(Instruction&);
@@ -0,0 +1,375 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "jit_compiler_x86_avx512.hpp"
+#include "jit_compiler.hpp"
+#include "superscalar.hpp"
+#include "dataset.hpp"
+#include "virtual_memory.h"
+#include "intrin_portable.h"
+
+/*
+	AVX-512 SuperscalarHash
+
+	Computes 8 consecutive dataset items per loop iteration, one item per 64-bit lane.
+	The kernel has the DatasetInitFunc signature and only uses volatile registers
+	on both the System V and the Win64 ABI:
+
+	r8  -> item number
+	r9  -> end item
+	r10 -> cache memory
+	r11 -> output pointer
+	rax, rcx -> temporary
+
+	zmm0  -> lane stride of the output (0, 64, ..., 448)
+	zmm1  -> mix block offsets / temporary
+	zmm2-zmm5 -> temporary
+	zmm16-zmm23 -> "r0-r7"
+	zmm24-zmm31 -> mix block qwords 0-7
+
+	The buffer starts with a constant pool followed by the generated code.
+	Program constants (IADD_C, IXOR_C, IMUL_RCP) are 64-bit and used as
+	embedded broadcasts from the pool. The last group of items is written
+	with a masked scatter, so the item range doesn't need to be a multiple of 8.
+*/
+
+namespace randomx {
+
+	constexpr int ZmmStride = 0;
+	constexpr int ZmmAddress = 1;
+	constexpr int ZmmTemp = 2;
+	constexpr int ZmmReg = 16;
+	constexpr int ZmmMix = 24;
+
+	constexpr int GprR8 = 8;
+	constexpr int GprR10 = 10;
+	constexpr int GprR11 = 11;
+
+	constexpr int MapOF = 1;
+	constexpr int Map0F38 = 2;
+
+	constexpr int32_t PoolLaneOffsets = 0;
+	constexpr int32_t PoolLaneStride = PoolLaneOffsets + 64;
+	constexpr int32_t PoolOne = PoolLaneStride + 64;
+	constexpr int32_t PoolMul0 = PoolOne + 8;
+	constexpr int32_t PoolAdd = PoolMul0 + 8;
+	constexpr int32_t PoolCacheMask = PoolAdd + 7 * 8;
+	constexpr int32_t PoolMask32 = PoolCacheMask + 8;
+	constexpr int32_t PoolProgramConstants = PoolMask32 + 8;
+	constexpr int32_t PoolSize = PoolProgramConstants + 8 * SuperscalarMaxSize * RANDOMX_CACHE_ACCESSES;
+
+	constexpr int32_t MaxInstrCodeSize = 128;
+	constexpr int32_t ProgramHeaderSize = 16 + 8 * 15;
+	constexpr int32_t ProgramFooterSize = 8 * 7;
+	constexpr int32_t ReserveSize = 1024;
+	constexpr int32_t CodeOffset = alignSize(PoolSize, 64);
+	constexpr int32_t MaxCodeSize = ReserveSize + (ProgramHeaderSize + ProgramFooterSize + MaxInstrCodeSize * SuperscalarMaxSize) * RANDOMX_CACHE_ACCESSES;
+	constexpr size_t DatasetInitAvx512Size = alignSize(CodeOffset + MaxCodeSize, 4096);
+
+	static const uint8_t KXNORW_K1[] = { 0xC5, 0xFC, 0x46, 0xC8 };
+	static const uint8_t KMOVW_K1_EAX[] = { 0xC5, 0xF8, 0x92, 0xC8 };
+#if defined(_WIN32) || defined(__CYGWIN__)
+	static const uint8_t Prologue[] = {
+		0x4C, 0x8B, 0x11,             //mov r10, qword ptr [rcx]
+		0x49, 0x89, 0xD3,             //mov r11, rdx
+		0x45, 0x89, 0xC0,             //mov r8d, r8d
+		0x45, 0x89, 0xC9,             //mov r9d, r9d
+	};
+#else
+	static const uint8_t Prologue[] = {
+		0x4C, 0x8B, 0x17,             //mov r10, qword ptr [rdi]
+		0x49, 0x89, 0xF3,             //mov r11, rsi
+		0x41, 0x89, 0xD0,             //mov r8d, edx
+		0x41, 0x89, 0xC9,             //mov r9d, ecx
+	};
+#endif
+	static const uint8_t CmpJaeDone[] = { 0x4D, 0x39, 0xC8, 0x0F, 0x83 };        //cmp r8, r9; jae rel32
+	static const uint8_t StoreMask[] = {
+		0x44, 0x89, 0xC8,             //mov eax, r9d
+		0x44, 0x29, 0xC0,             //sub eax, r8d
+		0x83, 0xF8, 0x08,             //cmp eax, 8
+		0x72, 0x07,                   //jb partial
+		0xB8, 0xFF, 0x00, 0x00, 0x00, //mov eax, 0xff
+		0xEB, 0x0B,                   //jmp done
+		0x89, 0xC1,                   //partial: mov ecx, eax
+		0xB8, 0x01, 0x00, 0x00, 0x00, //mov eax, 1
+		0xD3, 0xE0,                   //shl eax, cl
+		0xFF, 0xC8,                   //dec eax
+	};
+	static const uint8_t LoopNext[] = {
+		0x49, 0x83, 0xC0, 0x08,                   //add r8, 8
+		0x49, 0x81, 0xC3, 0x00, 0x02, 0x00, 0x00, //add r11, 512
+		0x4D, 0x39, 0xC8,                         //cmp r8, r9
+		0x0F, 0x82,                               //jb rel32
+	};
+	static const uint8_t Epilogue[] = {
+		0xC5, 0xF8, 0x77,             //vzeroupper
+		0xC3,                         //ret
+	};
+
+	static_assert(sizeof(uint64_t) * DatasetInitAvx512Lanes == CacheLineSize, "One lane stride per dataset item");
+
+	class DatasetInitAvx512Emitter : public CodeBuffer {
+	public:
+		DatasetInitAvx512Emitter(uint8_t* buf) {
+			code = buf;
+			codePos = CodeOffset;
+			rcpCount = 0;
+		}
+
+		void poolConstant(int32_t offset, uint64_t value) {
+			emitAt(offset, value);
+		}
+
+		int32_t programConstant(uint64_t value) {
+			int32_t offset = PoolProgramConstants + 8 * rcpCount++;
+			emitAt(offset, value);
+			return offset;
+		}
+
+		//EVEX.512.66.W1 encodings only
+		void evex(int map, int reg, int vvvv, int x, int b, bool broadcast, int mask) {
+			emit<uint8_t>(0x62);
+			emit<uint8_t>((((reg >> 3) & 1) ? 0 : 0x80) | (x ? 0 : 0x40) | (b ? 0 : 0x20) | (((reg >> 4) & 1) ? 0 : 0x10) | map);
+			emit<uint8_t>(0x80 | ((~vvvv & 15) << 3) | 0x04 | 0x01);
+			emit<uint8_t>(0x40 | (broadcast ? 0x10 : 0) | (((vvvv >> 4) & 1) ? 0 : 0x08) | mask);
+		}
+
+		void rr(int map, uint8_t opcode, int reg, int vvvv, int rm) {
+			evex(map, reg, vvvv, (rm >> 4) & 1, (rm >> 3) & 1, false, 0);
+			emit<uint8_t>(opcode);
+			emit<uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7));
+		}
+
+		void ri(uint8_t opcode, int ext, int dst, int src, uint8_t imm) {
+			rr(MapOF, opcode, ext, dst, src);
+			emit<uint8_t>(imm);
+		}
+
+		void rm(int map, uint8_t opcode, int reg, int vvvv, int32_t poolOffset, bool broadcast) {
+			evex(map, reg, vvvv, 0, 0, broadcast, 0);
+			emit<uint8_t>(opcode);
+			emit<uint8_t>(0x05 | ((reg & 7) << 3));
+			emit<int32_t>(poolOffset - (codePos + 4));
+		}
+
+		void vsib(uint8_t opcode, int reg, int base, int index, int32_t disp) {
+			evex(Map0F38, reg, index & 16, (index >> 3) & 1, (base >> 3) & 1, false, 1);
+			emit<uint8_t>(opcode);
+			emit<uint8_t>(0x84 | ((reg & 7) << 3));
+			emit<uint8_t>(((index & 7) << 3) | (base & 7));
+			emit<int32_t>(disp);
+		}
+
+		void vpaddq(int dst, int a, int b) { rr(MapOF, 0xD4, dst, a, b); }
+		void vpsubq(int dst, int a, int b) { rr(MapOF, 0xFB, dst, a, b); }
+		void vpxorq(int dst, int a, int b) { rr(MapOF, 0xEF, dst, a, b); }
+		void vpandq(int dst, int a, int b) { rr(MapOF, 0xDB, dst, a, b); }
+		void vpmuludq(int dst, int a, int b) { rr(MapOF, 0xF4, dst, a, b); }
+		void vpmullq(int dst, int a, int b) { rr(Map0F38, 0x40, dst, a, b); }
+		void vpsrlq(int dst, int src, uint8_t imm) { ri(0x73, 2, dst, src, imm); }
+		void vpsllq(int dst, int src, uint8_t imm) { ri(0x73, 6, dst, src, imm); }
+		void vpsraq(int dst, int src, uint8_t imm) { ri(0x72, 4, dst, src, imm); }
+		void vprorq(int dst, int src, uint8_t imm) { ri(0x72, 0, dst, src, imm); }
+		void vpbroadcastq(int dst, int gpr) { rr(Map0F38, 0x7C, dst, 0, gpr); }
+		void vmovdqa64(int dst, int32_t poolOffset) { rm(MapOF, 0x6F, dst, 0, poolOffset, false); }
+		void vpaddqPool(int dst, int a, int32_t poolOffset, bool broadcast) { rm(MapOF, 0xD4, dst, a, poolOffset, broadcast); }
+		void vpxorqPool(int dst, int a, int32_t poolOffset) { rm(MapOF, 0xEF, dst, a, poolOffset, true); }
+		void vpandqPool(int dst, int a, int32_t poolOffset) { rm(MapOF, 0xDB, dst, a, poolOffset, true); }
+		void vpmullqPool(int dst, int a, int32_t poolOffset) { rm(Map0F38, 0x40, dst, a, poolOffset, true); }
+		void vpgatherqq(int dst, int base, int index, int32_t disp) {
+			emit(KXNORW_K1, sizeof(KXNORW_K1));
+			vsib(0x91, dst, base, index, disp);
+		}
+		void vpscatterqq(int src, int base, int index, int32_t disp) {
+			emit(KMOVW_K1_EAX, sizeof(KMOVW_K1_EAX));
+			vsib(0xA1, src, base, index, disp);
+		}
+
+		//unsigned high multiplication using 32x32 bit products; a and b are read before dst is written
+		void mulhu(int dst, int a, int b, int correction) {
+			const int t0 = ZmmTemp, t1 = ZmmTemp + 1, t2 = ZmmTemp + 2, t3 = ZmmTemp + 3;
+			vpsrlq(t0, a, 32);
+			vpsrlq(t1, b, 32);
+			vpmuludq(t2, a, b);
+			vpmuludq(t3, t0, b);
+			vpsrlq(t2, t2, 32);
+			vpaddq(t3, t3, t2);
+			vpmuludq(t2, a, t1);
+			vpmuludq(t0, t0, t1);
+			vpsrlq(t1, t3, 32);
+			vpandqPool(t3, t3, PoolMask32);
+			vpaddq(t3, t3, t2);
+			vpsrlq(t3, t3, 32);
+			vpaddq(dst, t0, t1);
+			vpaddq(dst, dst, t3);
+			if (correction >= 0) {
+				vpsubq(dst, dst, correction);
+			}
+		}
+
+		void generateInstruction(Instruction& instr, std::vector<uint64_t> &reciprocalCache) {
+			const int dst = ZmmReg + instr.dst;
+			const int src = ZmmReg + instr.src;
+			switch ((SuperscalarInstructionType)instr.opcode)
+			{
+			case SuperscalarInstructionType::ISUB_R:
+				vpsubq(dst, dst, src);
+				break;
+			case SuperscalarInstructionType::IXOR_R:
+				vpxorq(dst, dst, src);
+				break;
+			case SuperscalarInstructionType::IADD_RS:
+				if (instr.getModShift() == 0) {
+					vpaddq(dst, dst, src);
+				}
+				else {
+					vpsllq(ZmmTemp, src, instr.getModShift());
+					vpaddq(dst, dst, ZmmTemp);
+				}
+				break;
+			case SuperscalarInstructionType::IMUL_R:
+				vpmullq(dst, dst, src);
+				break;
+			case SuperscalarInstructionType::IROR_C:
+				vprorq(dst, dst, instr.getImm32() & 63);
+				break;
+			case SuperscalarInstructionType::IADD_C7:
+			case SuperscalarInstructionType::IADD_C8:
+			case SuperscalarInstructionType::IADD_C9:
+				vpaddqPool(dst, dst, programConstant(signExtend2sCompl(instr.getImm32())), true);
+				break;
+			case SuperscalarInstructionType::IXOR_C7:
+			case SuperscalarInstructionType::IXOR_C8:
+			case SuperscalarInstructionType::IXOR_C9:
+				vpxorqPool(dst, dst, programConstant(signExtend2sCompl(instr.getImm32())));
+				break;
+			case SuperscalarInstructionType::IMULH_R:
+				mulhu(dst, dst, src, -1);
+				break;
+			case SuperscalarInstructionType::ISMULH_R:
+				//smulh(a, b) = mulhu(a, b) - (a < 0 ? b : 0) - (b < 0 ? a : 0)
+				vpsraq(ZmmTemp, src, 63);
+				vpandq(ZmmTemp, ZmmTemp, dst);
+				vpsraq(ZmmAddress, dst, 63);
+				vpandq(ZmmAddress, ZmmAddress, src);
+				vpaddq(ZmmAddress, ZmmAddress, ZmmTemp);
+				mulhu(dst, dst, src, ZmmAddress);
+				break;
+			case SuperscalarInstructionType::IMUL_RCP:
+				vpmullqPool(dst, dst, programConstant(reciprocalCache[instr.getImm32()]));
+				break;
+			default:
+				UNREACHABLE;
+			}
+		}
+
+		void loadMixBlock(int registerValue) {
+			static_assert(CacheLineSize == 64, "Mix block offset is computed with a shift by 6");
+			vpandqPool(ZmmAddress, registerValue, PoolCacheMask);
+			vpsllq(ZmmAddress, ZmmAddress, 6);
+			for (int q = 0; q < 8; ++q) {
+				vpgatherqq(ZmmMix + q, GprR10, ZmmAddress, 8 * q);
+			}
+		}
+
+		void generate(SuperscalarProgramList &programs, std::vector<uint64_t> &reciprocalCache) {
+			poolConstants();
+			emit(Prologue, sizeof(Prologue));
+			emit(CmpJaeDone, sizeof(CmpJaeDone));
+			int32_t jumpDone = codePos;
+			emit<int32_t>(0);
+			vmovdqa64(ZmmStride, PoolLaneStride);
+			alignLoop();
+			int32_t loopBegin = codePos;
+			vpbroadcastq(ZmmTemp + 1, GprR8);
+			vpaddqPool(ZmmTemp + 1, ZmmTemp + 1, PoolLaneOffsets, false);
+			vpaddqPool(ZmmTemp, ZmmTemp + 1, PoolOne, true);
+			vpmullqPool(ZmmReg, ZmmTemp, PoolMul0);
+			for (int k = 1; k < 8; ++k) {
+				vpxorqPool(ZmmReg + k, ZmmReg, PoolAdd + 8 * (k - 1));
+			}
+			int registerValue = ZmmTemp + 1;
+			for (unsigned i = 0; i < programs.size(); ++i) {
+				SuperscalarProgram& prog = programs[i];
+				loadMixBlock(registerValue);
+				for (unsigned j = 0; j < prog.getSize(); ++j) {
+					generateInstruction(prog(j), reciprocalCache);
+				}
+				for (int q = 0; q < 8; ++q) {
+					vpxorq(ZmmReg + q, ZmmReg + q, ZmmMix + q);
+				}
+				registerValue = ZmmReg + prog.getAddressRegister();
+			}
+			emit(StoreMask, sizeof(StoreMask));
+			for (int q = 0; q < 8; ++q) {
+				vpscatterqq(ZmmReg + q, GprR11, ZmmStride, 8 * q);
+			}
+			emit(LoopNext, sizeof(LoopNext));
+			emit<int32_t>(loopBegin - (codePos + 4));
+			emitAt(jumpDone, codePos - (jumpDone + 4));
+			emit(Epilogue, sizeof(Epilogue));
+		}
+
+	private:
+		void poolConstants() {
+			for (int i = 0; i < DatasetInitAvx512Lanes; ++i) {
+				poolConstant(PoolLaneOffsets + 8 * i, i);
+				poolConstant(PoolLaneStride + 8 * i, i * CacheLineSize);
+			}
+			poolConstant(PoolOne, 1);
+			poolConstant(PoolMul0, superscalarMul0);
+			poolConstant(PoolAdd + 0 * 8, superscalarAdd1);
+			poolConstant(PoolAdd + 1 * 8, superscalarAdd2);
+			poolConstant(PoolAdd + 2 * 8, superscalarAdd3);
+			poolConstant(PoolAdd + 3 * 8, superscalarAdd4);
+			poolConstant(PoolAdd + 4 * 8, superscalarAdd5);
+			poolConstant(PoolAdd + 5 * 8, superscalarAdd6);
+			poolConstant(PoolAdd + 6 * 8, superscalarAdd7);
+			poolConstant(PoolCacheMask, CacheSize / CacheLineSize - 1);
+			poolConstant(PoolMask32, 0xFFFFFFFFULL);
+		}
+
+		void alignLoop() {
+			while (codePos % 64 != 0) {
+				emit<uint8_t>(0x90);
+			}
+		}
+	};
+
+	size_t getDatasetInitAvx512Size() {
+		return DatasetInitAvx512Size;
+	}
+
+	void* generateDatasetInitAvx512(uint8_t* buf, SuperscalarProgramList &programs, std::vector<uint64_t> &reciprocalCache) {
+		DatasetInitAvx512Emitter emitter(buf);
+		emitter.generate(programs, reciprocalCache);
+		return buf + CodeOffset;
+	}
+
+}
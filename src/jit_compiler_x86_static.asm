@@ -46,6 +46,10 @@ PUBLIC randomx_program_loop_store_soft_aes
 PUBLIC randomx_program_loop_end
 PUBLIC randomx_program_soft_aes
 PUBLIC randomx_program_soft_aes_end
+PUBLIC randomx_program_loop_store_soft_aes_vperm
+PUBLIC randomx_program_loop_end_vperm
+PUBLIC randomx_program_soft_aes_vperm
+PUBLIC randomx_program_soft_aes_vperm_end
 PUBLIC randomx_program_epilogue
 PUBLIC randomx_sshash_load
 PUBLIC randomx_sshash_prefetch
@@ -157,6 +161,28 @@ aes_lut_dec::
 	db 0, 0, 0, 0, 0, 0, 0, 0
 randomx_program_soft_aes_end ENDP
 
+randomx_program_loop_store_soft_aes_vperm PROC
+	include asm/program_loop_store_soft_aes_vperm.inc
+randomx_program_loop_store_soft_aes_vperm ENDP
+
+randomx_program_loop_end_vperm PROC
+	sub ebx, 1
+	jnz rx_program_end
+	jmp rx_program_end
+randomx_program_loop_end_vperm ENDP
+
+randomx_program_soft_aes_vperm PROC
+soft_aes_vperm_enc::
+	include asm/program_soft_aes_vperm_enc.inc
+soft_aes_vperm_dec::
+	include asm/program_soft_aes_vperm_dec.inc
+randomx_program_soft_aes_vperm ENDP
+
+randomx_program_soft_aes_vperm_end PROC
+aes_vperm_table::
+	db 0, 0, 0, 0, 0, 0, 0, 0
+randomx_program_soft_aes_vperm_end ENDP
+
 ALIGN 64
 randomx_dataset_init PROC
 	push rbx
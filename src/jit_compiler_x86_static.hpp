@@ -46,6 +46,10 @@ extern "C" {
 	void randomx_program_loop_end();
 	void randomx_program_soft_aes();
 	void randomx_program_soft_aes_end();
+	void randomx_program_loop_store_soft_aes_vperm();
+	void randomx_program_loop_end_vperm();
+	void randomx_program_soft_aes_vperm();
+	void randomx_program_soft_aes_vperm_end();
 	void randomx_dataset_init();
 	void randomx_program_epilogue();
 	void randomx_sshash_load();
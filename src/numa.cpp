@@ -0,0 +1,130 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "numa.hpp"
+
+#ifdef HAVE_NUMA
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+namespace randomx {
+
+#ifdef HAVE_NUMA
+
+	unsigned numaNodeCount() {
+		if (numa_available() < 0)
+			return 1;
+		return numa_max_node() + 1;
+	}
+
+	bool numaNodeHasMemory(unsigned node) {
+		if (numa_available() < 0)
+			return node == 0;
+		if (node > (unsigned)numa_max_node())
+			return false;
+		struct bitmask* mems = numa_get_mems_allowed();
+		bool allowed = mems != nullptr && numa_bitmask_isbitset(mems, node);
+		if (mems != nullptr)
+			numa_bitmask_free(mems);
+		return allowed && numa_node_size64(node, nullptr) > 0;
+	}
+
+	unsigned numaNodeOfCpu(unsigned cpu) {
+		if (numa_available() < 0)
+			return 0;
+		int node = numa_node_of_cpu(cpu);
+		return node < 0 ? 0 : node;
+	}
+
+	uint64_t numaNodeCpuMask(unsigned node) {
+		if (numa_available() < 0)
+			return ~0ULL;
+		uint64_t result = 0;
+		struct bitmask* cpus = numa_allocate_cpumask();
+		if (numa_node_to_cpus(node, cpus) == 0) {
+			for (unsigned cpu = 0; cpu < 64 && cpu < cpus->size; ++cpu) {
+				if (numa_bitmask_isbitset(cpus, cpu))
+					result |= 1ULL << cpu;
+			}
+		}
+		numa_free_cpumask(cpus);
+		return result;
+	}
+
+	void numaBindMemory(void* ptr, size_t size, unsigned node) {
+		if (numa_available() < 0)
+			return;
+		numa_tonode_memory(ptr, size, node);
+	}
+
+	NumaMemoryScope::NumaMemoryScope(unsigned node) {
+		if (numa_available() < 0 || node >= MaxNodes)
+			return;
+		if (get_mempolicy(&mode, mask, MaxNodes, nullptr, 0) != 0)
+			return;
+		unsigned long nodeMask[MaskWords] = {};
+		nodeMask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+		active = set_mempolicy(MPOL_BIND, nodeMask, MaxNodes + 1) == 0;
+	}
+
+	NumaMemoryScope::~NumaMemoryScope() {
+		if (active) {
+			set_mempolicy(mode, mode == MPOL_DEFAULT ? nullptr : mask, MaxNodes + 1);
+		}
+	}
+
+#else
+
+	unsigned numaNodeCount() {
+		return 1;
+	}
+
+	bool numaNodeHasMemory(unsigned node) {
+		return node == 0;
+	}
+
+	unsigned numaNodeOfCpu(unsigned) {
+		return 0;
+	}
+
+	uint64_t numaNodeCpuMask(unsigned) {
+		return ~0ULL;
+	}
+
+	void numaBindMemory(void*, size_t, unsigned) {
+	}
+
+	NumaMemoryScope::NumaMemoryScope(unsigned) {
+	}
+
+	NumaMemoryScope::~NumaMemoryScope() {
+	}
+
+#endif
+}
@@ -0,0 +1,65 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace randomx {
+
+	//node numbers are less than this, returns 1 if NUMA is not supported
+	unsigned numaNodeCount();
+
+	//false for memoryless nodes and nodes the process may not allocate from (cpuset)
+	bool numaNodeHasMemory(unsigned node);
+
+	//returns 0 if the node is unknown
+	unsigned numaNodeOfCpu(unsigned cpu);
+
+	//bitmask of the first 64 CPUs that belong to the node
+	uint64_t numaNodeCpuMask(unsigned node);
+
+	//binds a memory range to a node, must be called before the pages are touched
+	void numaBindMemory(void* ptr, size_t size, unsigned node);
+
+	//Binds the memory policy of the calling thread to a node, so pages that are
+	//faulted in by the allocation itself (e.g. with MAP_POPULATE) are placed on
+	//the node. The previous policy is restored by the destructor.
+	class NumaMemoryScope {
+	public:
+		explicit NumaMemoryScope(unsigned node);
+		~NumaMemoryScope();
+	private:
+		static constexpr unsigned MaxNodes = 1024;
+		static constexpr unsigned MaskWords = MaxNodes / (8 * sizeof(unsigned long));
+		unsigned long mask[MaskWords];
+		int mode;
+		bool active = false;
+	};
+}
@@ -28,14 +28,32 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "randomx.h"
 #include "dataset.hpp"
+#include "dataset_file.hpp"
+#include "virtual_memory.h"
 #include "vm_interpreted.hpp"
 #include "vm_interpreted_light.hpp"
 #include "vm_compiled.hpp"
 #include "vm_compiled_light.hpp"
 #include "blake2/blake2.h"
-#include "cpu.hpp"
+#include "dispatch.hpp"
+#include "soft_aes.h"
+#include "affinity.hpp"
+#include "numa.hpp"
+#include "epoch_manager.hpp"
+#include "cache_manager.hpp"
+#include "verify_service.hpp"
+#include "vm_pool.hpp"
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <limits>
+#include <new>
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <system_error>
 
 #if defined(__SSE__) || defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP > 0))
 #define USE_CSR_INTRINSICS
@@ -48,22 +66,53 @@ extern "C" {
 
 	randomx_flags randomx_get_flags() {
 		randomx_flags flags = RANDOMX_HAVE_COMPILER ? RANDOMX_FLAG_JIT : RANDOMX_FLAG_DEFAULT;
-		randomx::Cpu cpu;
+		const randomx::DispatchTable& table = randomx::getDispatchTable();
 #ifdef RANDOMX_FORCE_SECURE
 		if (flags == RANDOMX_FLAG_JIT) {
 			flags |= RANDOMX_FLAG_SECURE;
 		}
 #endif
-		if (HAVE_AES && cpu.hasAes()) {
+		if (HAVE_AES && table.cpu.hasAes()) {
 			flags |= RANDOMX_FLAG_HARD_AES;
 		}
-		if (randomx_argon2_impl_avx2() != nullptr && cpu.hasAvx2()) {
-			flags |= RANDOMX_FLAG_ARGON2_AVX2;
+		flags |= table.argon2Flags;
+		return flags;
+	}
+
+	const char *randomx_get_kernel_name(randomx_kernel kernel, randomx_flags flags) {
+		if (kernel < 0 || kernel >= RANDOMX_KERNEL_COUNT) {
+			return nullptr;
 		}
-		if (randomx_argon2_impl_ssse3() != nullptr && cpu.hasSsse3()) {
-			flags |= RANDOMX_FLAG_ARGON2_SSSE3;
+		if (kernel == RANDOMX_KERNEL_ARGON2) {
+			//same order as selectArgonImpl; a kernel that is compiled in can still
+			//be missing on the current CPU, which the dispatch table records
+			const randomx_flags supported = randomx::getDispatchTable().argon2Flags;
+			if (randomx::selectArgonImpl(flags) == nullptr) {
+				return "unsupported";
+			}
+			if (flags & RANDOMX_FLAG_ARGON2_AVX512) {
+				return (supported & RANDOMX_FLAG_ARGON2_AVX512) ? "AVX-512" : "unsupported";
+			}
+			if (flags & RANDOMX_FLAG_ARGON2_AVX2) {
+				return (supported & RANDOMX_FLAG_ARGON2_AVX2) ? "AVX2" : "unsupported";
+			}
+			if (flags & RANDOMX_FLAG_ARGON2_SSSE3) {
+				return (supported & RANDOMX_FLAG_ARGON2_SSSE3) ? "SSSE3" : "unsupported";
+			}
+			return "reference";
 		}
-		return flags;
+		if (kernel == RANDOMX_KERNEL_AES && (flags & RANDOMX_FLAG_VAES)) {
+			return randomx::getDispatchTable().hardAes.hashAes1Rx4 != nullptr ? "VAES" : "unsupported";
+		}
+		if (kernel == RANDOMX_KERNEL_SUPERSCALAR && !(flags & RANDOMX_FLAG_JIT)) {
+			return "interpreter";
+		}
+#ifdef RANDOMX_HAVE_SOFT_AES_VPERM
+		if (kernel == RANDOMX_KERNEL_SOFT_AES && randomx::getSoftAesImpl() == randomx::SoftAesImpl::Table) {
+			return "table";
+		}
+#endif
+		return randomx::getDispatchTable().names[kernel];
 	}
 
 	randomx_cache *randomx_alloc_cache(randomx_flags flags) {
@@ -82,7 +131,7 @@ extern "C" {
 					cache->jit = nullptr;
 					cache->initialize = &randomx::initCache;
 					cache->datasetInit = &randomx::initDataset;
-					cache->memory = (uint8_t*)randomx::DefaultAllocator::allocMemory(randomx::CacheSize);
+					cache->memory = (uint8_t*)randomx::DefaultAllocator::allocMemory(randomx::CacheSize, &cache->pageSize);
 					break;
 
 				case RANDOMX_FLAG_JIT:
@@ -90,7 +139,7 @@ extern "C" {
 					cache->jit = new randomx::JitCompiler();
 					cache->initialize = &randomx::initCacheCompile;
 					cache->datasetInit = cache->jit->getDatasetInitFunc();
-					cache->memory = (uint8_t*)randomx::DefaultAllocator::allocMemory(randomx::CacheSize);
+					cache->memory = (uint8_t*)randomx::DefaultAllocator::allocMemory(randomx::CacheSize, &cache->pageSize);
 					break;
 
 				case RANDOMX_FLAG_LARGE_PAGES:
@@ -98,7 +147,7 @@ extern "C" {
 					cache->jit = nullptr;
 					cache->initialize = &randomx::initCache;
 					cache->datasetInit = &randomx::initDataset;
-					cache->memory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::CacheSize);
+					cache->memory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::CacheSize, &cache->pageSize);
 					break;
 
 				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_LARGE_PAGES:
@@ -106,7 +155,7 @@ extern "C" {
 					cache->jit = new randomx::JitCompiler();
 					cache->initialize = &randomx::initCacheCompile;
 					cache->datasetInit = cache->jit->getDatasetInitFunc();
-					cache->memory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::CacheSize);
+					cache->memory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::CacheSize, &cache->pageSize);
 					break;
 
 				default:
@@ -127,6 +176,45 @@ extern "C" {
 		return cache;
 	}
 
+	randomx_cache *randomx_alloc_cache_ex(randomx_flags flags, const randomx_allocator *allocator) {
+		if (allocator == nullptr) {
+			return randomx_alloc_cache(flags);
+		}
+		assert(allocator->alloc != nullptr && allocator->free != nullptr);
+
+		randomx_cache *cache = nullptr;
+		auto impl = randomx::selectArgonImpl(flags);
+		if (impl == nullptr) {
+			return cache;
+		}
+
+		try {
+			cache = new randomx_cache();
+			cache->argonImpl = impl;
+			cache->allocator = *allocator;
+			cache->dealloc = &randomx::deallocCache<randomx::UserAllocator>;
+			if (flags & RANDOMX_FLAG_JIT) {
+				cache->jit = new randomx::JitCompiler(allocator);
+				cache->initialize = &randomx::initCacheCompile;
+				cache->datasetInit = cache->jit->getDatasetInitFunc();
+			}
+			else {
+				cache->jit = nullptr;
+				cache->initialize = &randomx::initCache;
+				cache->datasetInit = &randomx::initDataset;
+			}
+			cache->memory = (uint8_t*)randomx::UserAllocator::allocMemory(*allocator, randomx::CacheSize, randomx::CacheLineSize, RANDOMX_MEMORY_CACHE);
+		}
+		catch (std::exception &ex) {
+			if (cache != nullptr) {
+				randomx_release_cache(cache);
+				cache = nullptr;
+			}
+		}
+
+		return cache;
+	}
+
 	void randomx_init_cache(randomx_cache *cache, const void *key, size_t keySize) {
 		assert(cache != nullptr);
 		assert(keySize == 0 || key != nullptr);
@@ -143,12 +231,199 @@ extern "C" {
 		return cache->memory;
 	}
 
+	size_t randomx_get_cache_page_size(randomx_cache *cache) {
+		assert(cache != nullptr);
+		return cache->pageSize;
+	}
+
 	void randomx_release_cache(randomx_cache* cache) {
 		assert(cache != nullptr);
 		cache->dealloc(cache);
 		delete cache;
 	}
 
+	int randomx_save_cache(randomx_cache *cache, const char *path) {
+		assert(cache != nullptr);
+		assert(path != nullptr);
+
+		if (!cache->isInitialized()) {
+			return 0;
+		}
+
+		randomx::FileHeader header;
+		randomx::initFileHeader(header, randomx::FileKind::Cache, cache->cacheKey.data(), cache->cacheKey.size(), randomx::CacheSize);
+		return saveFileAtomic(path, &header, sizeof(header), randomx::FileDataOffset, cache->memory, randomx::CacheSize, randomx::fileSize(randomx::CacheSize));
+	}
+
+	randomx_cache *randomx_load_cache(randomx_flags flags, const void *key, size_t keySize, const char *path) {
+		assert(keySize == 0 || key != nullptr);
+		assert(path != nullptr);
+
+		randomx::FileHeader header;
+		if (!randomx::readFileHeader(path, header) || !randomx::checkFileHeader(header, randomx::FileKind::Cache, key, keySize, randomx::CacheSize)) {
+			return nullptr;
+		}
+
+		randomx_cache *cache = nullptr;
+		uint8_t* data = nullptr;
+
+		try {
+			if (flags & RANDOMX_FLAG_LARGE_PAGES) {
+				cache = randomx_alloc_cache(flags);
+				if (cache == nullptr) {
+					throw std::bad_alloc();
+				}
+				if (!randomx::readFileData(path, randomx::FileDataOffset, cache->memory, randomx::CacheSize)) {
+					throw std::runtime_error("Cannot read the cache file");
+				}
+			}
+			else {
+				auto impl = randomx::selectArgonImpl(flags);
+				if (impl == nullptr) {
+					throw std::runtime_error("Unsupported Argon2 implementation");
+				}
+				data = (uint8_t*)mapFileMemory(path, randomx::FileDataOffset, randomx::CacheSize);
+				if (data == nullptr) {
+					throw std::runtime_error("Cannot map the cache file");
+				}
+				cache = new randomx_cache();
+				cache->argonImpl = impl;
+				cache->dealloc = &randomx::deallocCache<randomx::MappedFileAllocator>;
+				cache->memory = data;
+				cache->pageSize = getPageSize();
+				data = nullptr;
+				cache->jit = nullptr;
+				if (flags & RANDOMX_FLAG_JIT) {
+					cache->jit = new randomx::JitCompiler();
+					cache->initialize = &randomx::initCacheCompile;
+					cache->datasetInit = cache->jit->getDatasetInitFunc();
+				}
+				else {
+					cache->initialize = &randomx::initCache;
+					cache->datasetInit = &randomx::initDataset;
+				}
+			}
+
+			//the programs are derived from the key instead of being trusted from the file
+			randomx::generateCachePrograms(cache, key, keySize);
+			cache->cacheKey.assign((const char *)key, keySize);
+			if (cache->jit != nullptr) {
+				randomx::compileCache(cache);
+			}
+		}
+		catch (std::exception &ex) {
+			if (data != nullptr) {
+				unmapFileMemory(data, randomx::CacheSize);
+			}
+			if (cache != nullptr) {
+				randomx_release_cache(cache);
+				cache = nullptr;
+			}
+		}
+
+		return cache;
+	}
+
+	randomx_cache *randomx_create_shared_cache(randomx_flags flags, const char *name, const void *key, size_t keySize) {
+		assert(name != nullptr);
+		assert(keySize == 0 || key != nullptr);
+
+		auto impl = randomx::selectArgonImpl(flags);
+		if (impl == nullptr) {
+			return nullptr;
+		}
+
+		uint8_t* segment = randomx::createSharedSegment(name, randomx::CacheSize);
+		if (segment == nullptr) {
+			return nullptr;
+		}
+
+		randomx_cache *cache = nullptr;
+		try {
+			cache = new randomx_cache();
+			cache->argonImpl = impl;
+			cache->dealloc = &randomx::deallocCache<randomx::SharedMemoryAllocator>;
+			cache->memory = segment + randomx::FileDataOffset;
+			cache->pageSize = getPageSize();
+			cache->jit = nullptr;
+			if (flags & RANDOMX_FLAG_JIT) {
+				cache->jit = new randomx::JitCompiler();
+				cache->initialize = &randomx::initCacheCompile;
+				cache->datasetInit = cache->jit->getDatasetInitFunc();
+			}
+			else {
+				cache->initialize = &randomx::initCache;
+				cache->datasetInit = &randomx::initDataset;
+			}
+			randomx_init_cache(cache, key, keySize);
+			randomx::publishSharedSegment(segment, randomx::FileKind::Cache, key, keySize, randomx::CacheSize);
+		}
+		catch (std::exception &ex) {
+			if (cache != nullptr) {
+				randomx_release_cache(cache);
+				cache = nullptr;
+			}
+			else {
+				randomx::releaseSharedSegment(segment, randomx::CacheSize);
+			}
+			removeSharedMemory(name);
+		}
+
+		return cache;
+	}
+
+	randomx_cache *randomx_attach_shared_cache(randomx_flags flags, const char *name, const void *key, size_t keySize, unsigned long timeoutMs) {
+		assert(name != nullptr);
+		assert(keySize == 0 || key != nullptr);
+
+		auto impl = randomx::selectArgonImpl(flags);
+		if (impl == nullptr) {
+			return nullptr;
+		}
+
+		uint8_t* segment = randomx::attachSharedSegment(name, randomx::FileKind::Cache, key, keySize, randomx::CacheSize, timeoutMs);
+		if (segment == nullptr) {
+			return nullptr;
+		}
+
+		randomx_cache *cache = nullptr;
+		try {
+			cache = new randomx_cache();
+			cache->argonImpl = impl;
+			cache->dealloc = &randomx::deallocCache<randomx::SharedMemoryAllocator>;
+			cache->memory = segment + randomx::FileDataOffset;
+			segment = nullptr;
+			cache->pageSize = getPageSize();
+			cache->jit = nullptr;
+			if (flags & RANDOMX_FLAG_JIT) {
+				cache->jit = new randomx::JitCompiler();
+				cache->initialize = &randomx::initCacheCompile;
+				cache->datasetInit = cache->jit->getDatasetInitFunc();
+			}
+			else {
+				cache->initialize = &randomx::initCache;
+				cache->datasetInit = &randomx::initDataset;
+			}
+			//other processes can write to the segment, so only the cache memory is taken from it
+			randomx::generateCachePrograms(cache, key, keySize);
+			cache->cacheKey.assign((const char *)key, keySize);
+			if (cache->jit != nullptr) {
+				randomx::compileCache(cache);
+			}
+		}
+		catch (std::exception &ex) {
+			if (segment != nullptr) {
+				randomx::releaseSharedSegment(segment, randomx::CacheSize);
+			}
+			if (cache != nullptr) {
+				randomx_release_cache(cache);
+				cache = nullptr;
+			}
+		}
+
+		return cache;
+	}
+
 	randomx_dataset *randomx_alloc_dataset(randomx_flags flags) {
 
 		//fail on 32-bit systems if DatasetSize is >= 4 GiB
@@ -162,11 +437,11 @@ extern "C" {
 			dataset = new randomx_dataset();
 			if (flags & RANDOMX_FLAG_LARGE_PAGES) {
 				dataset->dealloc = &randomx::deallocDataset<randomx::LargePageAllocator>;
-				dataset->memory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::DatasetSize);
+				dataset->memory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::DatasetSize, &dataset->pageSize);
 			}
 			else {
 				dataset->dealloc = &randomx::deallocDataset<randomx::DefaultAllocator>;
-				dataset->memory = (uint8_t*)randomx::DefaultAllocator::allocMemory(randomx::DatasetSize);
+				dataset->memory = (uint8_t*)randomx::DefaultAllocator::allocMemory(randomx::DatasetSize, &dataset->pageSize);
 			}
 		}
 		catch (std::exception &ex) {
@@ -183,6 +458,89 @@ extern "C" {
 		return dataset;
 	}
 
+	randomx_dataset *randomx_alloc_dataset_ex(randomx_flags flags, const randomx_allocator *allocator) {
+		if (allocator == nullptr) {
+			return randomx_alloc_dataset(flags);
+		}
+		assert(allocator->alloc != nullptr && allocator->free != nullptr);
+
+		//fail on 32-bit systems if DatasetSize is >= 4 GiB
+		if (randomx::DatasetSize > std::numeric_limits<size_t>::max()) {
+			return nullptr;
+		}
+
+		randomx_dataset *dataset = nullptr;
+
+		try {
+			dataset = new randomx_dataset();
+			dataset->allocator = *allocator;
+			dataset->dealloc = &randomx::deallocDataset<randomx::UserAllocator>;
+			dataset->memory = (uint8_t*)randomx::UserAllocator::allocMemory(*allocator, randomx::DatasetSize, randomx::CacheLineSize, RANDOMX_MEMORY_DATASET);
+		}
+		catch (std::exception &ex) {
+			if (dataset != nullptr) {
+				randomx_release_dataset(dataset);
+				dataset = nullptr;
+			}
+		}
+
+		return dataset;
+	}
+
+	unsigned randomx_numa_node_count() {
+		return randomx::numaNodeCount();
+	}
+
+	int randomx_numa_node_has_memory(unsigned node) {
+		return randomx::numaNodeHasMemory(node);
+	}
+
+	unsigned randomx_numa_node_of_cpu(unsigned cpu) {
+		return randomx::numaNodeOfCpu(cpu);
+	}
+
+	uint64_t randomx_numa_node_cpu_mask(unsigned node) {
+		return randomx::numaNodeCpuMask(node);
+	}
+
+	randomx_dataset *randomx_alloc_dataset_numa(randomx_flags flags, unsigned node) {
+		const unsigned nodeCount = randomx::numaNodeCount();
+		if (node >= nodeCount || !randomx::numaNodeHasMemory(node)) {
+			return nullptr;
+		}
+		if (nodeCount == 1) {
+			return randomx_alloc_dataset(flags);
+		}
+
+		if (randomx::DatasetSize > std::numeric_limits<size_t>::max()) {
+			return nullptr;
+		}
+
+		randomx_dataset *dataset = nullptr;
+
+		try {
+			dataset = new randomx_dataset();
+			randomx::NumaMemoryScope scope(node);
+			if (flags & RANDOMX_FLAG_LARGE_PAGES) {
+				dataset->dealloc = &randomx::deallocDataset<randomx::LargePageAllocator>;
+				dataset->memory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::DatasetSize, &dataset->pageSize);
+			}
+			else {
+				dataset->dealloc = &randomx::deallocDataset<randomx::PagedAllocator>;
+				dataset->memory = (uint8_t*)randomx::PagedAllocator::allocMemory(randomx::DatasetSize, &dataset->pageSize);
+			}
+			randomx::numaBindMemory(dataset->memory, randomx::DatasetSize, node);
+		}
+		catch (std::exception &ex) {
+			if (dataset != nullptr) {
+				randomx_release_dataset(dataset);
+				dataset = nullptr;
+			}
+		}
+
+		return dataset;
+	}
+
 	constexpr unsigned long DatasetItemCount = randomx::DatasetSize / RANDOMX_DATASET_ITEM_SIZE;
 
 	unsigned long randomx_dataset_item_count() {
@@ -211,127 +569,281 @@ extern "C" {
 		}
 	}
 
+	void randomx_init_dataset_parallel(randomx_dataset *dataset, randomx_cache *cache, unsigned threadCount, uint64_t affinityMask) {
+		assert(dataset != nullptr);
+		assert(cache != nullptr);
+		randomx::initDatasetParallel(dataset, cache, threadCount, affinityMask);
+	}
+
+	int randomx_init_dataset_lazy(randomx_dataset *dataset, randomx_cache *cache) {
+		assert(dataset != nullptr);
+		assert(cache != nullptr && cache->isInitialized());
+		try {
+			randomx::initDatasetLazy(dataset, cache);
+		}
+		catch (std::exception &ex) {
+			return 0;
+		}
+		return 1;
+	}
+
+	void randomx_fill_dataset_lazy(randomx_dataset *dataset, unsigned long startItem, unsigned long itemCount) {
+		assert(dataset != nullptr && dataset->lazy != nullptr);
+		assert(startItem < DatasetItemCount && itemCount <= DatasetItemCount);
+		assert(startItem + itemCount <= DatasetItemCount);
+		randomx::fillDatasetLazy(dataset, startItem, startItem + itemCount);
+	}
+
+	unsigned long randomx_dataset_lazy_ready_count(randomx_dataset *dataset) {
+		assert(dataset != nullptr && dataset->lazy != nullptr);
+		return dataset->lazy->readyCount.load();
+	}
+
 	void *randomx_get_dataset_memory(randomx_dataset *dataset) {
 		assert(dataset != nullptr);
 		return dataset->memory;
 	}
 
+	size_t randomx_get_dataset_page_size(randomx_dataset *dataset) {
+		assert(dataset != nullptr);
+		return dataset->pageSize;
+	}
+
 	void randomx_release_dataset(randomx_dataset *dataset) {
 		assert(dataset != nullptr);
 		dataset->dealloc(dataset);
+		delete dataset->lazy;
 		delete dataset;
 	}
 
+	int randomx_save_dataset(randomx_dataset *dataset, const void *key, size_t keySize, const char *path) {
+		assert(dataset != nullptr);
+		assert(keySize == 0 || key != nullptr);
+		assert(path != nullptr);
+
+		randomx::FileHeader header;
+		randomx::initFileHeader(header, randomx::FileKind::Dataset, key, keySize, randomx::DatasetSize);
+		return saveFileAtomic(path, &header, sizeof(header), randomx::FileDataOffset, dataset->memory, randomx::DatasetSize, randomx::fileSize(randomx::DatasetSize));
+	}
+
+	randomx_dataset *randomx_load_dataset(randomx_flags flags, const void *key, size_t keySize, const char *path) {
+		assert(keySize == 0 || key != nullptr);
+		assert(path != nullptr);
+
+		if (randomx::DatasetSize > std::numeric_limits<size_t>::max()) {
+			return nullptr;
+		}
+
+		randomx::FileHeader header;
+		if (!randomx::readFileHeader(path, header) || !randomx::checkFileHeader(header, randomx::FileKind::Dataset, key, keySize, randomx::DatasetSize)) {
+			return nullptr;
+		}
+
+		uint8_t* data = (uint8_t*)mapFileMemory(path, randomx::FileDataOffset, randomx::DatasetSize);
+		if (data == nullptr) {
+			return nullptr;
+		}
+
+		if (!(flags & RANDOMX_FLAG_LARGE_PAGES)) {
+			randomx_dataset *dataset = nullptr;
+			try {
+				dataset = new randomx_dataset();
+			}
+			catch (std::exception &ex) {
+				unmapFileMemory(data, randomx::DatasetSize);
+				return nullptr;
+			}
+			dataset->dealloc = &randomx::deallocDataset<randomx::MappedFileAllocator>;
+			dataset->memory = data;
+			dataset->pageSize = getPageSize();
+			return dataset;
+		}
+
+		randomx_dataset *dataset = randomx_alloc_dataset(flags);
+		if (dataset != nullptr) {
+			memcpy(dataset->memory, data, randomx::DatasetSize);
+		}
+		unmapFileMemory(data, randomx::DatasetSize);
+		return dataset;
+	}
+
+	randomx_dataset *randomx_create_shared_dataset(const char *name, randomx_cache *cache, unsigned threadCount) {
+		assert(name != nullptr);
+		assert(cache != nullptr && cache->isInitialized());
+
+		if (randomx::DatasetSize > std::numeric_limits<size_t>::max()) {
+			return nullptr;
+		}
+
+		uint8_t* segment = randomx::createSharedSegment(name, randomx::DatasetSize);
+		if (segment == nullptr) {
+			return nullptr;
+		}
+
+		randomx_dataset *dataset = nullptr;
+		try {
+			dataset = new randomx_dataset();
+		}
+		catch (std::exception &ex) {
+			randomx::releaseSharedSegment(segment, randomx::DatasetSize);
+			removeSharedMemory(name);
+			return nullptr;
+		}
+		dataset->dealloc = &randomx::deallocDataset<randomx::SharedMemoryAllocator>;
+		dataset->memory = segment + randomx::FileDataOffset;
+		dataset->pageSize = getPageSize();
+		randomx::initDatasetParallel(dataset, cache, threadCount, 0);
+		randomx::publishSharedSegment(segment, randomx::FileKind::Dataset, cache->cacheKey.data(), cache->cacheKey.size(), randomx::DatasetSize);
+		return dataset;
+	}
+
+	randomx_dataset *randomx_attach_shared_dataset(const char *name, const void *key, size_t keySize, unsigned long timeoutMs) {
+		assert(name != nullptr);
+		assert(keySize == 0 || key != nullptr);
+
+		if (randomx::DatasetSize > std::numeric_limits<size_t>::max()) {
+			return nullptr;
+		}
+
+		uint8_t* segment = randomx::attachSharedSegment(name, randomx::FileKind::Dataset, key, keySize, randomx::DatasetSize, timeoutMs);
+		if (segment == nullptr) {
+			return nullptr;
+		}
+
+		randomx_dataset *dataset = nullptr;
+		try {
+			dataset = new randomx_dataset();
+		}
+		catch (std::exception &ex) {
+			randomx::releaseSharedSegment(segment, randomx::DatasetSize);
+			return nullptr;
+		}
+		dataset->dealloc = &randomx::deallocDataset<randomx::SharedMemoryAllocator>;
+		dataset->memory = segment + randomx::FileDataOffset;
+		dataset->pageSize = getPageSize();
+		return dataset;
+	}
+
+	int randomx_remove_shared(const char *name) {
+		assert(name != nullptr);
+		return removeSharedMemory(name);
+	}
+
 	randomx_vm *randomx_create_vm(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset) {
+		return randomx_create_vm_ex(flags, cache, dataset, nullptr);
+	}
+
+	randomx_vm *randomx_create_vm_ex(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, const randomx_allocator *allocator) {
 		assert(cache != nullptr || (flags & RANDOMX_FLAG_FULL_MEM));
 		assert(cache == nullptr || cache->isInitialized());
 		assert(dataset != nullptr || !(flags & RANDOMX_FLAG_FULL_MEM));
+		assert(allocator == nullptr || (allocator->alloc != nullptr && allocator->free != nullptr));
 
 		randomx_vm *vm = nullptr;
 
 		try {
 			switch ((int)(flags & (RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES))) {
 				case RANDOMX_FLAG_DEFAULT:
-					vm = new randomx::InterpretedLightVmDefault(flags);
+					vm = new randomx::InterpretedLightVmDefault(flags, allocator);
 					break;
 
 				case RANDOMX_FLAG_FULL_MEM:
-					vm = new randomx::InterpretedVmDefault(flags);
+					vm = new randomx::InterpretedVmDefault(flags, allocator);
 					break;
 
 				case RANDOMX_FLAG_JIT:
 					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledLightVmDefaultSecure(flags);
+						vm = new randomx::CompiledLightVmDefaultSecure(flags, allocator);
 					}
 					else {
-						vm = new randomx::CompiledLightVmDefault(flags);
+						vm = new randomx::CompiledLightVmDefault(flags, allocator);
 					}
 					break;
 
 				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT:
 					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledVmDefaultSecure(flags);
+						vm = new randomx::CompiledVmDefaultSecure(flags, allocator);
 					}
 					else {
-						vm = new randomx::CompiledVmDefault(flags);
+						vm = new randomx::CompiledVmDefault(flags, allocator);
 					}
 					break;
 
 				case RANDOMX_FLAG_HARD_AES:
-					vm = new randomx::InterpretedLightVmHardAes(flags);
+					vm = new randomx::InterpretedLightVmHardAes(flags, allocator);
 					break;
 
 				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_HARD_AES:
-					vm = new randomx::InterpretedVmHardAes(flags);
+					vm = new randomx::InterpretedVmHardAes(flags, allocator);
 					break;
 
 				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES:
 					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledLightVmHardAesSecure(flags);
+						vm = new randomx::CompiledLightVmHardAesSecure(flags, allocator);
 					}
 					else {
-						vm = new randomx::CompiledLightVmHardAes(flags);
+						vm = new randomx::CompiledLightVmHardAes(flags, allocator);
 					}
 					break;
 
 				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES:
 					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledVmHardAesSecure(flags);
+						vm = new randomx::CompiledVmHardAesSecure(flags, allocator);
 					}
 					else {
-						vm = new randomx::CompiledVmHardAes(flags);
+						vm = new randomx::CompiledVmHardAes(flags, allocator);
 					}
 					break;
 
 				case RANDOMX_FLAG_LARGE_PAGES:
-					vm = new randomx::InterpretedLightVmLargePage(flags);
+					vm = new randomx::InterpretedLightVmLargePage(flags, allocator);
 					break;
 
 				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_LARGE_PAGES:
-					vm = new randomx::InterpretedVmLargePage(flags);
+					vm = new randomx::InterpretedVmLargePage(flags, allocator);
 					break;
 
 				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_LARGE_PAGES:
 					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledLightVmLargePageSecure(flags);
+						vm = new randomx::CompiledLightVmLargePageSecure(flags, allocator);
 					}
 					else {
-						vm = new randomx::CompiledLightVmLargePage(flags);
+						vm = new randomx::CompiledLightVmLargePage(flags, allocator);
 					}
 					break;
 
 				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_LARGE_PAGES:
 					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledVmLargePageSecure(flags);
+						vm = new randomx::CompiledVmLargePageSecure(flags, allocator);
 					}
 					else {
-						vm = new randomx::CompiledVmLargePage(flags);
+						vm = new randomx::CompiledVmLargePage(flags, allocator);
 					}
 					break;
 
 				case RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
-					vm = new randomx::InterpretedLightVmLargePageHardAes(flags);
+					vm = new randomx::InterpretedLightVmLargePageHardAes(flags, allocator);
 					break;
 
 				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
-					vm = new randomx::InterpretedVmLargePageHardAes(flags);
+					vm = new randomx::InterpretedVmLargePageHardAes(flags, allocator);
 					break;
 
 				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
 					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledLightVmLargePageHardAesSecure(flags);
+						vm = new randomx::CompiledLightVmLargePageHardAesSecure(flags, allocator);
 					}
 					else {
-						vm = new randomx::CompiledLightVmLargePageHardAes(flags);
+						vm = new randomx::CompiledLightVmLargePageHardAes(flags, allocator);
 					}
 					break;
 
 				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
 					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledVmLargePageHardAesSecure(flags);
+						vm = new randomx::CompiledVmLargePageHardAesSecure(flags, allocator);
 					}
 					else {
-						vm = new randomx::CompiledVmLargePageHardAes(flags);
+						vm = new randomx::CompiledVmLargePageHardAes(flags, allocator);
 					}
 					break;
 
@@ -372,6 +884,11 @@ extern "C" {
 		machine->setDataset(dataset);
 	}
 
+	size_t randomx_get_scratchpad_page_size(randomx_vm *machine) {
+		assert(machine != nullptr);
+		return machine->getScratchpadPageSize();
+	}
+
 	void randomx_destroy_vm(randomx_vm *machine) {
 		assert(machine != nullptr);
 		delete machine;
@@ -414,13 +931,17 @@ extern "C" {
 		machine->initScratchpad(machine->tempHash);
 	}
 
-	void randomx_calculate_hash_next(randomx_vm* machine, const void* nextInput, size_t nextInputSize, void* output) {
+	static void runPrograms(randomx_vm* machine) {
 		machine->resetRoundingMode();
 		for (uint32_t chain = 0; chain < RANDOMX_PROGRAM_COUNT - 1; ++chain) {
 			machine->run(machine->tempHash);
 			blake2b(machine->tempHash, sizeof(machine->tempHash), machine->getRegisterFile(), sizeof(randomx::RegisterFile), nullptr, 0);
 		}
 		machine->run(machine->tempHash);
+	}
+
+	void randomx_calculate_hash_next(randomx_vm* machine, const void* nextInput, size_t nextInputSize, void* output) {
+		runPrograms(machine);
 
 		// Finish current hash and fill the scratchpad for the next hash at the same time
 		blake2b(machine->tempHash, sizeof(machine->tempHash), nextInput, nextInputSize, nullptr, 0);
@@ -428,15 +949,64 @@ extern "C" {
 	}
 
 	void randomx_calculate_hash_last(randomx_vm* machine, void* output) {
-		machine->resetRoundingMode();
-		for (int chain = 0; chain < RANDOMX_PROGRAM_COUNT - 1; ++chain) {
-			machine->run(machine->tempHash);
-			blake2b(machine->tempHash, sizeof(machine->tempHash), machine->getRegisterFile(), sizeof(randomx::RegisterFile), nullptr, 0);
-		}
-		machine->run(machine->tempHash);
+		runPrograms(machine);
 		machine->getFinalResult(output, RANDOMX_HASH_SIZE);
 	}
 
+	// Input hashes don't depend on the VM, so equal-sized inputs are hashed 4 at a time
+	static void hashInputs(uint64_t (*inputHashes)[8], const void *const *inputs, const size_t *inputSizes, size_t count) {
+		if (count == 4 && inputSizes[0] == inputSizes[1] && inputSizes[0] == inputSizes[2] && inputSizes[0] == inputSizes[3]) {
+			void* const out[4] = { inputHashes[0], inputHashes[1], inputHashes[2], inputHashes[3] };
+			blake2b_4way(out, sizeof(inputHashes[0]), inputs, inputSizes[0]);
+			return;
+		}
+		for (size_t i = 0; i < count; ++i) {
+			blake2b(inputHashes[i], sizeof(inputHashes[i]), inputs[i], inputSizes[i], nullptr, 0);
+		}
+	}
+
+	void randomx_calculate_hash_batch(randomx_vm *machine, const void *const *inputs, const size_t *inputSizes, size_t count, void *output) {
+		assert(machine != nullptr);
+		assert(count == 0 || (inputs != nullptr && inputSizes != nullptr && output != nullptr));
+
+		if (count == 0) {
+			return;
+		}
+
+#ifdef USE_CSR_INTRINSICS
+		const unsigned int fpstate = _mm_getcsr();
+#else
+		fenv_t fpstate;
+		fegetenv(&fpstate);
+#endif
+
+		uint64_t inputHashes[4][8];
+		uint8_t* out = (uint8_t*)output;
+		for (size_t i = 0; i < count; ++i) {
+			assert(inputSizes[i] == 0 || inputs[i] != nullptr);
+			if (i % 4 == 0) {
+				hashInputs(inputHashes, inputs + i, inputSizes + i, std::min<size_t>(4, count - i));
+			}
+			if (i == 0) {
+				memcpy(machine->tempHash, inputHashes[0], sizeof(machine->tempHash));
+				machine->initScratchpad(machine->tempHash);
+				continue;
+			}
+			// Finish the previous hash and fill the scratchpad for this one at the same time
+			runPrograms(machine);
+			memcpy(machine->tempHash, inputHashes[i % 4], sizeof(machine->tempHash));
+			machine->hashAndFill(out, RANDOMX_HASH_SIZE, machine->tempHash);
+			out += RANDOMX_HASH_SIZE;
+		}
+		randomx_calculate_hash_last(machine, out);
+
+#ifdef USE_CSR_INTRINSICS
+		_mm_setcsr(fpstate);
+#else
+		fesetenv(&fpstate);
+#endif
+	}
+
 	void randomx_calculate_commitment(const void* input, size_t inputSize, const void* hash_in, void* com_out) {
 		assert(inputSize == 0 || input != nullptr);
 		assert(hash_in != nullptr);
@@ -447,4 +1017,166 @@ extern "C" {
 		blake2b_update(&state, hash_in, RANDOMX_HASH_SIZE);
 		blake2b_final(&state, com_out, RANDOMX_HASH_SIZE);
 	}
+
+	randomx_epoch_manager *randomx_create_epoch_manager(randomx_flags flags, unsigned threadCount, uint64_t affinityMask) {
+		randomx_epoch_manager *manager = nullptr;
+		try {
+			manager = new randomx_epoch_manager(flags, threadCount, affinityMask);
+		}
+		catch (std::exception &ex) {
+			manager = nullptr;
+		}
+		return manager;
+	}
+
+	void randomx_epoch_manager_register_vm(randomx_epoch_manager *manager, randomx_vm *machine) {
+		assert(manager != nullptr);
+		assert(machine != nullptr);
+		manager->registerVm(machine);
+	}
+
+	void randomx_epoch_manager_unregister_vm(randomx_epoch_manager *manager, randomx_vm *machine) {
+		assert(manager != nullptr);
+		assert(machine != nullptr);
+		manager->unregisterVm(machine);
+	}
+
+	int randomx_epoch_manager_prepare(randomx_epoch_manager *manager, const void *key, size_t keySize) {
+		assert(manager != nullptr);
+		assert(keySize == 0 || key != nullptr);
+		return manager->prepare(key, keySize);
+	}
+
+	int randomx_epoch_manager_is_ready(randomx_epoch_manager *manager) {
+		assert(manager != nullptr);
+		return manager->isReady();
+	}
+
+	int randomx_epoch_manager_switch(randomx_epoch_manager *manager) {
+		assert(manager != nullptr);
+		return manager->switchDataset();
+	}
+
+	randomx_dataset *randomx_epoch_manager_get_dataset(randomx_epoch_manager *manager) {
+		assert(manager != nullptr);
+		return manager->getDataset();
+	}
+
+	void randomx_destroy_epoch_manager(randomx_epoch_manager *manager) {
+		assert(manager != nullptr);
+		delete manager;
+	}
+
+	randomx_cache_manager *randomx_create_cache_manager(randomx_flags flags, unsigned capacity) {
+		if (randomx::selectArgonImpl(flags) == nullptr) {
+			return nullptr;
+		}
+		randomx_cache_manager *manager = nullptr;
+		try {
+			manager = new randomx_cache_manager(flags, capacity);
+		}
+		catch (std::exception &ex) {
+			manager = nullptr;
+		}
+		return manager;
+	}
+
+	randomx_cache *randomx_cache_manager_acquire(randomx_cache_manager *manager, const void *key, size_t keySize) {
+		assert(manager != nullptr);
+		assert(keySize == 0 || key != nullptr);
+		return manager->acquire(key, keySize);
+	}
+
+	randomx_cache *randomx_cache_manager_try_acquire(randomx_cache_manager *manager, const void *key, size_t keySize) {
+		assert(manager != nullptr);
+		assert(keySize == 0 || key != nullptr);
+		return manager->tryAcquire(key, keySize);
+	}
+
+	void randomx_cache_manager_release(randomx_cache_manager *manager, randomx_cache *cache) {
+		assert(manager != nullptr);
+		assert(cache != nullptr);
+		manager->release(cache);
+	}
+
+	void randomx_cache_manager_prefetch(randomx_cache_manager *manager, const void *key, size_t keySize) {
+		assert(manager != nullptr);
+		assert(keySize == 0 || key != nullptr);
+		manager->prefetch(key, keySize);
+	}
+
+	void randomx_destroy_cache_manager(randomx_cache_manager *manager) {
+		assert(manager != nullptr);
+		delete manager;
+	}
+
+	randomx_vm_pool *randomx_create_vm_pool(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, unsigned size) {
+		randomx_vm_pool *pool = nullptr;
+		try {
+			pool = new randomx_vm_pool(flags, cache, dataset, size);
+		}
+		catch (std::exception &ex) {
+			pool = nullptr;
+		}
+		return pool;
+	}
+
+	randomx_vm *randomx_vm_pool_acquire(randomx_vm_pool *pool) {
+		assert(pool != nullptr);
+		return pool->acquire();
+	}
+
+	randomx_vm *randomx_vm_pool_try_acquire(randomx_vm_pool *pool) {
+		assert(pool != nullptr);
+		return pool->tryAcquire();
+	}
+
+	void randomx_vm_pool_release(randomx_vm_pool *pool, randomx_vm *machine) {
+		assert(pool != nullptr);
+		assert(machine != nullptr);
+		pool->release(machine);
+	}
+
+	void randomx_vm_pool_get_stats(randomx_vm_pool *pool, randomx_vm_pool_stats *stats) {
+		assert(pool != nullptr);
+		assert(stats != nullptr);
+		pool->getStats(stats);
+	}
+
+	void randomx_destroy_vm_pool(randomx_vm_pool *pool) {
+		assert(pool != nullptr);
+		delete pool;
+	}
+
+	randomx_verify_service *randomx_create_verify_service(randomx_flags flags, unsigned threadCount, unsigned cacheCapacity) {
+		if (randomx::selectArgonImpl(flags) == nullptr) {
+			return nullptr;
+		}
+		randomx_verify_service *service = nullptr;
+		try {
+			service = new randomx_verify_service(flags, threadCount, cacheCapacity);
+		}
+		catch (std::exception &ex) {
+			service = nullptr;
+		}
+		return service;
+	}
+
+	void randomx_verify_service_submit(randomx_verify_service *service, const void *key, size_t keySize, const void *input, size_t inputSize, randomx_verify_callback *callback, void *userData) {
+		assert(service != nullptr);
+		assert(keySize == 0 || key != nullptr);
+		assert(inputSize == 0 || input != nullptr);
+		assert(callback != nullptr);
+		service->submit(key, keySize, input, inputSize, callback, userData);
+	}
+
+	void randomx_verify_service_wait(randomx_verify_service *service) {
+		assert(service != nullptr);
+		service->wait();
+	}
+
+	void randomx_destroy_verify_service(randomx_verify_service *service) {
+		assert(service != nullptr);
+		delete service;
+	}
 }
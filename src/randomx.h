@@ -48,13 +48,72 @@ typedef enum {
   RANDOMX_FLAG_SECURE = 16,
   RANDOMX_FLAG_ARGON2_SSSE3 = 32,
   RANDOMX_FLAG_ARGON2_AVX2 = 64,
-  RANDOMX_FLAG_ARGON2 = 96,
+  RANDOMX_FLAG_ARGON2 = 352,
   RANDOMX_FLAG_V2 = 128,
+  RANDOMX_FLAG_ARGON2_AVX512 = 256,
+  RANDOMX_FLAG_VAES = 512,
 } randomx_flags;
 
+typedef enum {
+  RANDOMX_KERNEL_AES = 0,
+  RANDOMX_KERNEL_SOFT_AES = 1,
+  RANDOMX_KERNEL_BLAKE2B = 2,
+  RANDOMX_KERNEL_ARGON2 = 3,
+  RANDOMX_KERNEL_SUPERSCALAR = 4,
+  RANDOMX_KERNEL_COUNT = 5,
+} randomx_kernel;
+
+typedef enum {
+  RANDOMX_MEMORY_CACHE = 0,
+  RANDOMX_MEMORY_DATASET = 1,
+  RANDOMX_MEMORY_SCRATCHPAD = 2,
+  RANDOMX_MEMORY_JIT = 3,
+} randomx_memory_kind;
+
+/**
+ * Memory allocation callbacks for randomx_alloc_cache_ex, randomx_alloc_dataset_ex
+ * and randomx_create_vm_ex.
+ *
+ * alloc must return a block of at least 'size' bytes aligned to 'alignment' (a power of 2)
+ * or NULL on failure. free is called with the same size and kind. Memory of the kind
+ * RANDOMX_MEMORY_JIT is aligned to the system page size and must allow its protection to be
+ * changed to executable (e.g. anonymous mappings; on macOS it must be mapped with MAP_JIT).
+ * The callbacks may be called from any thread. Small bookkeeping structures are always
+ * allocated from the C++ heap.
+*/
+typedef struct randomx_allocator {
+  void *(*alloc)(void *userData, size_t size, size_t alignment, randomx_memory_kind kind);
+  void (*free)(void *userData, void *ptr, size_t size, randomx_memory_kind kind);
+  void *userData;
+} randomx_allocator;
+
 typedef struct randomx_dataset randomx_dataset;
 typedef struct randomx_cache randomx_cache;
 typedef struct randomx_vm randomx_vm;
+typedef struct randomx_epoch_manager randomx_epoch_manager;
+typedef struct randomx_cache_manager randomx_cache_manager;
+typedef struct randomx_verify_service randomx_verify_service;
+typedef struct randomx_vm_pool randomx_vm_pool;
+
+/**
+ * Statistics of a randomx_vm_pool (see randomx_vm_pool_get_stats).
+*/
+typedef struct randomx_vm_pool_stats {
+  uint64_t hits;      /* acquisitions that found an available virtual machine */
+  uint64_t misses;    /* acquisitions that had to wait or failed (randomx_vm_pool_try_acquire) */
+  unsigned size;      /* number of virtual machines in the pool */
+  unsigned available; /* number of virtual machines that are not acquired */
+  size_t pageSize;    /* page size of the scratchpad slab in bytes */
+} randomx_vm_pool_stats;
+
+/**
+ * Called by a randomx_verify_service worker thread when a job is complete.
+ *
+ * @param userData is the value passed to randomx_verify_service_submit.
+ * @param hash is the RandomX hash of the input (RANDOMX_HASH_SIZE bytes, valid only during
+ *        the call), or NULL if a virtual machine could not be created with the selected flags.
+*/
+typedef void randomx_verify_callback(void *userData, const void *hash);
 
 
 #if defined(__cplusplus)
@@ -84,23 +143,47 @@ extern "C" {
  *            RANDOMX_FLAG_LARGE_PAGES
  *            RANDOMX_FLAG_FULL_MEM
  *            RANDOMX_FLAG_SECURE
+ *            RANDOMX_FLAG_VAES
  *         These flags must be added manually if desired.
  *         On OpenBSD RANDOMX_FLAG_SECURE is enabled by default in JIT mode as W^X is enforced by the OS.
  */
 RANDOMX_EXPORT randomx_flags randomx_get_flags(void);
 
+/**
+ * Reports which implementation of a kernel is used with the given flags on the current CPU.
+ * The selection is made once per process and is shared by all caches, datasets and VMs.
+ *
+ * @param kernel is one of:
+ *        RANDOMX_KERNEL_AES - scratchpad AES with RANDOMX_FLAG_HARD_AES, e.g. "AES-NI" or "VAES"
+ *                             (with RANDOMX_FLAG_VAES); "unsupported" if the CPU lacks it
+ *        RANDOMX_KERNEL_SOFT_AES - scratchpad AES without RANDOMX_FLAG_HARD_AES, e.g. "AVX2 vperm"
+ *                                  or "table"
+ *        RANDOMX_KERNEL_BLAKE2B - Blake2b compression function, e.g. "AVX2" or "reference"
+ *        RANDOMX_KERNEL_ARGON2 - Argon2 implementation selected by the RANDOMX_FLAG_ARGON2_* flags,
+ *                                e.g. "AVX-512" or "reference" ("unsupported" if the CPU lacks it)
+ *        RANDOMX_KERNEL_SUPERSCALAR - dataset item generation, e.g. "AVX-512 JIT", "JIT"
+ *                                     or "interpreter" (without RANDOMX_FLAG_JIT)
+ * @param flags is the flags used to create the cache and the virtual machines.
+ *
+ * @return Static string with the name of the implementation, NULL if kernel is not valid.
+*/
+RANDOMX_EXPORT const char *randomx_get_kernel_name(randomx_kernel kernel, randomx_flags flags);
+
 /**
  * Creates a randomx_cache structure and allocates memory for RandomX Cache.
  *
  * @param flags is any combination of these 2 flags (each flag can be set or not set):
- *        RANDOMX_FLAG_LARGE_PAGES - allocate memory in large pages
+ *        RANDOMX_FLAG_LARGE_PAGES - allocate memory in large pages, falls back to normal pages
+ *                                   (see randomx_get_cache_page_size)
  *        RANDOMX_FLAG_JIT - create cache structure with JIT compilation support; this makes
  *                           subsequent Dataset initialization faster
- *        Optionally, one of these two flags may be selected:
+ *        Optionally, one of these three flags may be selected:
  *        RANDOMX_FLAG_ARGON2_SSSE3 - optimized Argon2 for CPUs with the SSSE3 instruction set
  *                                   makes subsequent cache initialization faster
  *        RANDOMX_FLAG_ARGON2_AVX2 - optimized Argon2 for CPUs with the AVX2 instruction set
  *                                   makes subsequent cache initialization faster
+ *        RANDOMX_FLAG_ARGON2_AVX512 - optimized Argon2 for CPUs with the AVX-512F instruction set
+ *                                   makes subsequent cache initialization faster
  *
  * @return Pointer to an allocated randomx_cache structure.
  *         Returns NULL if:
@@ -110,6 +193,19 @@ RANDOMX_EXPORT randomx_flags randomx_get_flags(void);
  */
 RANDOMX_EXPORT randomx_cache *randomx_alloc_cache(randomx_flags flags);
 
+/**
+ * Same as randomx_alloc_cache, but the Cache memory and the JIT code buffer
+ * (with RANDOMX_FLAG_JIT) are obtained from the allocator callbacks.
+ *
+ * @param flags are the same as in randomx_alloc_cache. RANDOMX_FLAG_LARGE_PAGES is ignored
+ *        if allocator is not NULL.
+ * @param allocator is a pointer to the allocator callbacks, which are copied. If NULL,
+ *        this function is equivalent to randomx_alloc_cache.
+ *
+ * @return Pointer to an allocated randomx_cache structure, NULL if the allocation fails.
+*/
+RANDOMX_EXPORT randomx_cache *randomx_alloc_cache_ex(randomx_flags flags, const randomx_allocator *allocator);
+
 /**
  * Initializes the cache memory and SuperscalarHash using the provided key value.
  * Does nothing if called again with the same key value.
@@ -130,6 +226,19 @@ RANDOMX_EXPORT void randomx_init_cache(randomx_cache *cache, const void *key, si
 */
 RANDOMX_EXPORT void *randomx_get_cache_memory(randomx_cache *cache);
 
+/**
+ * Returns the size of the memory pages backing the cache structure.
+ *
+ * @param cache is a pointer to a previously allocated randomx_cache structure. Must not be NULL.
+ *
+ * @return The page size in bytes. With RANDOMX_FLAG_LARGE_PAGES, this is the largest page
+ *         size that could be allocated (1 GiB, the default huge page size or normal pages).
+ *         Transparent huge pages are only reported if the kernel actually backed the whole
+ *         allocation with them when it was populated; otherwise the normal page size is returned.
+ *         0 if the memory was obtained from a user allocator (randomx_alloc_cache_ex).
+*/
+RANDOMX_EXPORT size_t randomx_get_cache_page_size(randomx_cache *cache);
+
 /**
  * Releases all memory occupied by the randomx_cache structure.
  *
@@ -137,17 +246,160 @@ RANDOMX_EXPORT void *randomx_get_cache_memory(randomx_cache *cache);
 */
 RANDOMX_EXPORT void randomx_release_cache(randomx_cache* cache);
 
+/**
+ * Saves an initialized cache to a file, so it can be loaded by randomx_load_cache
+ * instead of being initialized again. The file stores the cache memory, a hash of the key
+ * and a fingerprint of the RandomX configuration. The SuperscalarHash programs are generated
+ * from the key when the cache is loaded.
+ *
+ * @param cache is a pointer to a randomx_cache structure initialized by randomx_init_cache.
+ *        Must not be NULL.
+ * @param path is the path of the file. The data is written to path + ".tmp", flushed to disk
+ *        and then renamed over an existing file. Must not be NULL.
+ *
+ * @return 1 on success, 0 if the cache is not initialized or the file could not be written.
+*/
+RANDOMX_EXPORT int randomx_save_cache(randomx_cache *cache, const char *path);
+
+/**
+ * Loads a cache saved by randomx_save_cache. Without RANDOMX_FLAG_LARGE_PAGES, the cache memory
+ * is memory-mapped copy-on-write from the file. The cache may be initialized with a different
+ * key by randomx_init_cache; the file is never modified.
+ *
+ * @param flags is the same as in randomx_alloc_cache.
+ * @param key is a pointer to the expected key. Must not be NULL if keySize > 0.
+ * @param keySize is the size of the key in bytes.
+ * @param path is the path of the file. Must not be NULL.
+ *
+ * @return Pointer to an initialized randomx_cache structure, which must be released with
+ *         randomx_release_cache. NULL is returned if the file cannot be read, if it was
+ *         saved with a different key or by a differently configured version of RandomX,
+ *         or if any of the selected flags is not supported.
+*/
+RANDOMX_EXPORT randomx_cache *randomx_load_cache(randomx_flags flags, const void *key, size_t keySize, const char *path);
+
+/**
+ * Creates a named shared memory segment (POSIX shm_open, or a named file mapping on Windows),
+ * allocates the cache in it and initializes it with the given key. Other processes can map
+ * the cache read-only by calling randomx_attach_shared_cache with the same name and key.
+ * The segment stores a hash of the key and a fingerprint of the RandomX configuration.
+ *
+ * @param flags is the same as in randomx_alloc_cache, except RANDOMX_FLAG_LARGE_PAGES is ignored.
+ * @param name is the name of the segment, e.g. "/randomx-cache". Must not be NULL.
+ * @param key is a pointer to memory which contains the key. Must not be NULL if keySize > 0.
+ * @param keySize is the size of the key in bytes.
+ *
+ * @return Pointer to an initialized randomx_cache structure, which must be released with
+ *         randomx_release_cache. The cache must not be initialized with a different key.
+ *         NULL is returned if a segment with the same name already exists, if it cannot be
+ *         created (e.g. there is not enough shared memory) or if any of the selected flags is
+ *         not supported.
+*/
+RANDOMX_EXPORT randomx_cache *randomx_create_shared_cache(randomx_flags flags, const char *name, const void *key, size_t keySize);
+
+/**
+ * Maps a cache created by randomx_create_shared_cache read-only. If the cache is still being
+ * initialized by its creator, waits until it is ready.
+ *
+ * @param flags is the same as in randomx_alloc_cache, except RANDOMX_FLAG_LARGE_PAGES is ignored.
+ * @param name is the name of the segment. Must not be NULL.
+ * @param key is a pointer to the expected key. Must not be NULL if keySize > 0.
+ * @param keySize is the size of the key in bytes.
+ * @param timeoutMs is the maximum time to wait for the segment to be created and initialized,
+ *        in milliseconds.
+ *
+ * @return Pointer to an initialized randomx_cache structure, which must be released with
+ *         randomx_release_cache. The cache must not be initialized with a different key.
+ *         NULL is returned on timeout, if the cache was initialized with a different key
+ *         or by a differently configured version of RandomX, or if any of the selected flags
+ *         is not supported. A segment whose creator exited before the cache was ready stays
+ *         unready and causes a timeout; it must be removed with randomx_remove_shared
+ *         before it can be created again.
+*/
+RANDOMX_EXPORT randomx_cache *randomx_attach_shared_cache(randomx_flags flags, const char *name, const void *key, size_t keySize, unsigned long timeoutMs);
+
 /**
  * Creates a randomx_dataset structure and allocates memory for RandomX Dataset.
  *
  * @param flags is the initialization flags. Only one flag is supported (can be set or not set):
- *        RANDOMX_FLAG_LARGE_PAGES - allocate memory in large pages
+ *        RANDOMX_FLAG_LARGE_PAGES - allocate memory in large pages; 1 GiB pages are tried first,
+ *                                   then the default huge pages and finally normal pages
+ *                                   (see randomx_get_dataset_page_size)
  *
  * @return Pointer to an allocated randomx_dataset structure.
  *         NULL is returned if memory allocation fails.
  */
 RANDOMX_EXPORT randomx_dataset *randomx_alloc_dataset(randomx_flags flags);
 
+/**
+ * Same as randomx_alloc_dataset, but the Dataset memory is obtained from the allocator callbacks.
+ *
+ * @param flags are the same as in randomx_alloc_dataset. RANDOMX_FLAG_LARGE_PAGES is ignored
+ *        if allocator is not NULL.
+ * @param allocator is a pointer to the allocator callbacks, which are copied. If NULL,
+ *        this function is equivalent to randomx_alloc_dataset.
+ *
+ * @return Pointer to an allocated randomx_dataset structure, NULL if the allocation fails.
+*/
+RANDOMX_EXPORT randomx_dataset *randomx_alloc_dataset_ex(randomx_flags flags, const randomx_allocator *allocator);
+
+/**
+ * Gets the number of NUMA node numbers. Node numbers can be sparse and some nodes may have
+ * no memory (see randomx_numa_node_has_memory).
+ *
+ * @return the highest NUMA node number + 1. 1 is returned if RandomX was built without NUMA
+ *         support or if NUMA is not available on the system.
+*/
+RANDOMX_EXPORT unsigned randomx_numa_node_count(void);
+
+/**
+ * Checks if a dataset can be allocated on a NUMA node.
+ *
+ * @param node is the NUMA node.
+ *
+ * @return 1 if the node has memory and the process is allowed to allocate from it (cpuset),
+ *         0 otherwise (memoryless nodes, node numbers that are not in use).
+*/
+RANDOMX_EXPORT int randomx_numa_node_has_memory(unsigned node);
+
+/**
+ * Gets the NUMA node of a CPU.
+ *
+ * @param cpu is the CPU number.
+ *
+ * @return the NUMA node of the CPU, or 0 if it is not known.
+*/
+RANDOMX_EXPORT unsigned randomx_numa_node_of_cpu(unsigned cpu);
+
+/**
+ * Gets the CPUs that belong to a NUMA node. The result can be passed as the affinity mask
+ * of randomx_init_dataset_parallel to initialize a dataset with the CPUs of its node.
+ *
+ * @param node is the NUMA node.
+ *
+ * @return a bitmask of the CPUs 0-63 that belong to the node. All bits are set if
+ *         NUMA is not available.
+*/
+RANDOMX_EXPORT uint64_t randomx_numa_node_cpu_mask(unsigned node);
+
+/**
+ * Creates a randomx_dataset structure and allocates memory for RandomX Dataset on the
+ * specified NUMA node. The memory is bound to the node before it is touched, so pages
+ * are placed on the node regardless of which threads initialize or copy the dataset.
+ * To keep one replica per node, allocate a dataset for each node with memory, initialize
+ * one of them, copy its memory (randomx_get_dataset_memory) to the others and attach each
+ * virtual machine to the replica of its node with randomx_vm_set_dataset.
+ *
+ * @param flags is the same as in randomx_alloc_dataset.
+ * @param node is the NUMA node. Must be less than randomx_numa_node_count().
+ *
+ * @return Pointer to an allocated randomx_dataset structure.
+ *         NULL is returned if memory allocation fails or if the node does not exist or has
+ *         no memory (see randomx_numa_node_has_memory).
+ *         Without NUMA support, this function is equivalent to randomx_alloc_dataset.
+*/
+RANDOMX_EXPORT randomx_dataset *randomx_alloc_dataset_numa(randomx_flags flags, unsigned node);
+
 /**
  * Gets the number of items contained in the dataset.
  *
@@ -168,6 +420,59 @@ RANDOMX_EXPORT unsigned long randomx_dataset_item_count(void);
 */
 RANDOMX_EXPORT void randomx_init_dataset(randomx_dataset *dataset, randomx_cache *cache, unsigned long startItem, unsigned long itemCount);
 
+/**
+ * Initializes all dataset items using multiple threads. The threads take the items
+ * in small chunks from a shared counter, so faster threads simply process more chunks
+ * and all threads finish at about the same time.
+ *
+ * @param dataset is a pointer to a previously allocated randomx_dataset structure. Must not be NULL.
+ * @param cache is a pointer to a previously allocated and initialized randomx_cache structure. Must not be NULL.
+ * @param threadCount is the number of threads. If 0, the number of hardware threads is used.
+ *        If 1 and affinityMask is 0, the dataset is initialized in the calling thread.
+ * @param affinityMask is a CPU bitmask. If non-zero, the i-th thread is pinned to the
+ *        i-th CPU that has its bit set (wrapping around if there are more threads than CPUs).
+*/
+RANDOMX_EXPORT void randomx_init_dataset_parallel(randomx_dataset *dataset, randomx_cache *cache, unsigned threadCount, uint64_t affinityMask);
+
+/**
+ * Prepares a dataset for lazy initialization. Dataset items are calculated on first access
+ * by light virtual machines (created without RANDOMX_FLAG_FULL_MEM) that were given both
+ * the cache and the dataset, so hashing can start immediately. The speed approaches the
+ * fast mode as the dataset fills up. Items may also be calculated in advance by
+ * randomx_fill_dataset_lazy, e.g. from background threads.
+ *
+ * The dataset stays lazy until it is released. Calling this function again (e.g. after
+ * the cache was initialized with a new key) invalidates all items. Virtual machines ignore
+ * the dataset while their cache is not the one it was prepared with.
+ *
+ * @param dataset is a pointer to a previously allocated randomx_dataset structure. Must not be NULL.
+ * @param cache is a pointer to a previously allocated and initialized randomx_cache structure.
+ *        It must remain valid while the dataset is used. Must not be NULL.
+ *
+ * @return 1 on success, 0 if memory for the item bitmap could not be allocated.
+*/
+RANDOMX_EXPORT int randomx_init_dataset_lazy(randomx_dataset *dataset, randomx_cache *cache);
+
+/**
+ * Calculates the dataset items that are not valid yet. This function is thread safe
+ * and may run concurrently with virtual machines that use the dataset.
+ *
+ * @param dataset is a pointer to a dataset prepared by randomx_init_dataset_lazy. Must not be NULL.
+ * @param startItem is the item number where filling should start.
+ * @param itemCount is the number of items that should be filled.
+*/
+RANDOMX_EXPORT void randomx_fill_dataset_lazy(randomx_dataset *dataset, unsigned long startItem, unsigned long itemCount);
+
+/**
+ * Gets the number of valid items of a lazy dataset.
+ *
+ * @param dataset is a pointer to a dataset prepared by randomx_init_dataset_lazy. Must not be NULL.
+ *
+ * @return the number of valid items. The dataset is complete when the result equals
+ *         randomx_dataset_item_count().
+*/
+RANDOMX_EXPORT unsigned long randomx_dataset_lazy_ready_count(randomx_dataset *dataset);
+
 /**
  * Returns a pointer to the internal memory buffer of the dataset structure. The size
  * of the internal memory buffer is randomx_dataset_item_count() * RANDOMX_DATASET_ITEM_SIZE.
@@ -178,6 +483,20 @@ RANDOMX_EXPORT void randomx_init_dataset(randomx_dataset *dataset, randomx_cache
 */
 RANDOMX_EXPORT void *randomx_get_dataset_memory(randomx_dataset *dataset);
 
+/**
+ * Returns the size of the memory pages backing the dataset structure.
+ *
+ * @param dataset is a pointer to a previously allocated randomx_dataset structure. Must not be NULL.
+ *
+ * @return The page size in bytes. With RANDOMX_FLAG_LARGE_PAGES, this is the largest page
+ *         size that could be allocated. If 1 GiB pages are used, the last 32 MiB of the dataset
+ *         are backed by the default huge pages (or normal pages if there are none left).
+ *         Transparent huge pages are only reported if the kernel actually backed the whole
+ *         allocation with them when it was populated; otherwise the normal page size is returned.
+ *         0 if the memory was obtained from a user allocator (randomx_alloc_dataset_ex).
+*/
+RANDOMX_EXPORT size_t randomx_get_dataset_page_size(randomx_dataset *dataset);
+
 /**
  * Releases all memory occupied by the randomx_dataset structure.
  *
@@ -185,23 +504,110 @@ RANDOMX_EXPORT void *randomx_get_dataset_memory(randomx_dataset *dataset);
 */
 RANDOMX_EXPORT void randomx_release_dataset(randomx_dataset *dataset);
 
+/**
+ * Saves a fully initialized dataset to a file, so it can be loaded by randomx_load_dataset
+ * instead of being initialized again. The file stores a hash of the key and a fingerprint
+ * of the RandomX configuration that the dataset was built with.
+ *
+ * @param dataset is a pointer to a randomx_dataset structure. Must not be NULL.
+ * @param key is a pointer to the key the dataset was initialized with (the key of the cache
+ *        passed to randomx_init_dataset). Must not be NULL if keySize > 0.
+ * @param keySize is the size of the key in bytes.
+ * @param path is the path of the file. The data is written to path + ".tmp", flushed to disk
+ *        and then renamed over an existing file, so readers never see a partial file.
+ *        Must not be NULL.
+ *
+ * @return 1 on success, 0 if the file could not be written (the temporary file is removed).
+*/
+RANDOMX_EXPORT int randomx_save_dataset(randomx_dataset *dataset, const void *key, size_t keySize, const char *path);
+
+/**
+ * Loads a dataset saved by randomx_save_dataset. Without RANDOMX_FLAG_LARGE_PAGES, the file
+ * is memory-mapped copy-on-write, so the dataset pages are shared with the page cache and
+ * changes made to the dataset memory are never written back to the file.
+ *
+ * @param flags is the initialization flags. Only one flag is supported (can be set or not set):
+ *        RANDOMX_FLAG_LARGE_PAGES - copy the file contents to memory allocated in large pages
+ * @param key is a pointer to the expected key. Must not be NULL if keySize > 0.
+ * @param keySize is the size of the key in bytes.
+ * @param path is the path of the file. Must not be NULL.
+ *
+ * @return Pointer to a randomx_dataset structure, which must be released with randomx_release_dataset.
+ *         NULL is returned if the file cannot be read, if it was saved with a different key
+ *         or by a differently configured version of RandomX, or if memory allocation fails.
+*/
+RANDOMX_EXPORT randomx_dataset *randomx_load_dataset(randomx_flags flags, const void *key, size_t keySize, const char *path);
+
+/**
+ * Creates a named shared memory segment, allocates the dataset in it and initializes the whole
+ * dataset from the cache. Other processes can map the dataset read-only by calling
+ * randomx_attach_shared_dataset with the same name and the key of the cache.
+ *
+ * @param name is the name of the segment, e.g. "/randomx-dataset". Must not be NULL.
+ * @param cache is a pointer to a randomx_cache structure initialized by randomx_init_cache. Must not be NULL.
+ * @param threadCount is the number of threads used for the initialization (same as in
+ *        randomx_init_dataset_parallel). 0 means one thread per logical CPU.
+ *
+ * @return Pointer to an initialized randomx_dataset structure, which must be released with
+ *         randomx_release_dataset. The dataset must not be initialized again.
+ *         NULL is returned if a segment with the same name already exists or if it cannot be
+ *         created (e.g. there is not enough shared memory).
+*/
+RANDOMX_EXPORT randomx_dataset *randomx_create_shared_dataset(const char *name, randomx_cache *cache, unsigned threadCount);
+
+/**
+ * Maps a dataset created by randomx_create_shared_dataset read-only. If the dataset is still
+ * being initialized by its creator, waits until it is ready.
+ *
+ * @param name is the name of the segment. Must not be NULL.
+ * @param key is a pointer to the expected key. Must not be NULL if keySize > 0.
+ * @param keySize is the size of the key in bytes.
+ * @param timeoutMs is the maximum time to wait for the segment to be created and initialized,
+ *        in milliseconds.
+ *
+ * @return Pointer to a read-only randomx_dataset structure, which must be released with
+ *         randomx_release_dataset. It can be passed to randomx_create_vm, but not to
+ *         randomx_init_dataset. NULL is returned on timeout or if the dataset was initialized
+ *         with a different key or by a differently configured version of RandomX. A segment
+ *         whose creator exited before the dataset was ready stays unready and causes a
+ *         timeout; it must be removed with randomx_remove_shared before it can be created again.
+*/
+RANDOMX_EXPORT randomx_dataset *randomx_attach_shared_dataset(const char *name, const void *key, size_t keySize, unsigned long timeoutMs);
+
+/**
+ * Removes the name of a segment created by randomx_create_shared_cache or
+ * randomx_create_shared_dataset, so it can be created again, e.g. with a new key or after
+ * its creator exited before the segment was ready.
+ * Caches and datasets that are already attached remain valid until they are released.
+ * On Windows, the segment is removed automatically when it is no longer mapped.
+ *
+ * @param name is the name of the segment. Must not be NULL.
+ *
+ * @return 1 on success, 0 if the segment does not exist.
+*/
+RANDOMX_EXPORT int randomx_remove_shared(const char *name);
+
 /**
  * Creates and initializes a RandomX virtual machine.
  *
- * @param flags is any combination of these 5 flags (each flag can be set or not set):
+ * @param flags is any combination of these 6 flags (each flag can be set or not set):
  *        RANDOMX_FLAG_LARGE_PAGES - allocate scratchpad memory in large pages
  *        RANDOMX_FLAG_HARD_AES - virtual machine will use hardware accelerated AES
  *        RANDOMX_FLAG_FULL_MEM - virtual machine will use the full dataset
  *        RANDOMX_FLAG_JIT - virtual machine will use a JIT compiler
  *        RANDOMX_FLAG_SECURE - when combined with RANDOMX_FLAG_JIT, the JIT pages are never
  *                              writable and executable at the same time (W^X policy)
+ *        RANDOMX_FLAG_VAES - when combined with RANDOMX_FLAG_HARD_AES, the scratchpad is hashed
+ *                            and filled with 256-bit VAES instructions. This is opt-in because
+ *                            it was measured to be no faster than AES-NI.
  *        The numeric values of the first 4 flags are ordered so that a higher value will provide
  *        faster hash calculation and a lower numeric value will provide higher portability.
  *        Using RANDOMX_FLAG_DEFAULT (all flags not set) works on all platforms, but is the slowest.
  * @param cache is a pointer to an initialized randomx_cache structure. Can be
  *        NULL if RANDOMX_FLAG_FULL_MEM is set.
  * @param dataset is a pointer to a randomx_dataset structure. Can be NULL
- *        if RANDOMX_FLAG_FULL_MEM is not set.
+ *        if RANDOMX_FLAG_FULL_MEM is not set. If RANDOMX_FLAG_FULL_MEM is not set,
+ *        only a dataset prepared by randomx_init_dataset_lazy is used.
  *
  * @return Pointer to an initialized randomx_vm structure.
  *         Returns NULL if:
@@ -212,6 +618,17 @@ RANDOMX_EXPORT void randomx_release_dataset(randomx_dataset *dataset);
 */
 RANDOMX_EXPORT randomx_vm *randomx_create_vm(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset);
 
+/**
+ * Same as randomx_create_vm, but the Scratchpad and the JIT code buffer (with RANDOMX_FLAG_JIT)
+ * are obtained from the allocator callbacks.
+ *
+ * @param flags are the same as in randomx_create_vm. RANDOMX_FLAG_LARGE_PAGES is ignored
+ *        if allocator is not NULL.
+ * @param allocator is a pointer to the allocator callbacks, which are copied. If NULL,
+ *        this function is equivalent to randomx_create_vm.
+*/
+RANDOMX_EXPORT randomx_vm *randomx_create_vm_ex(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, const randomx_allocator *allocator);
+
 /**
  * Reinitializes a virtual machine with a new Cache. This function should be called anytime
  * the Cache is reinitialized with a new key. Does nothing if called with a Cache containing
@@ -232,6 +649,16 @@ RANDOMX_EXPORT void randomx_vm_set_cache(randomx_vm *machine, randomx_cache* cac
 */
 RANDOMX_EXPORT void randomx_vm_set_dataset(randomx_vm *machine, randomx_dataset *dataset);
 
+/**
+ * Returns the size of the memory pages backing the scratchpad of a virtual machine.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ *
+ * @return The page size in bytes, determined in the same way as randomx_get_cache_page_size.
+ *         0 if the scratchpad was obtained from a user allocator (randomx_create_vm_ex).
+*/
+RANDOMX_EXPORT size_t randomx_get_scratchpad_page_size(randomx_vm *machine);
+
 /**
  * Releases all memory occupied by the randomx_vm structure.
  *
@@ -271,6 +698,24 @@ RANDOMX_EXPORT void randomx_calculate_hash_first(randomx_vm* machine, const void
 RANDOMX_EXPORT void randomx_calculate_hash_next(randomx_vm* machine, const void* nextInput, size_t nextInputSize, void* output);
 RANDOMX_EXPORT void randomx_calculate_hash_last(randomx_vm* machine, void* output);
 
+/**
+ * Calculates RandomX hashes of an array of inputs. This is equivalent to calling
+ * randomx_calculate_hash for each input, but the scratchpad fill of each hash is
+ * pipelined with the finalization of the previous one (same as randomx_calculate_hash_next)
+ * and the floating point environment is saved and restored only once per call.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param inputs is an array of count pointers to memory to be hashed. Must not be NULL
+ *        unless count is 0.
+ * @param inputSizes is an array of count input sizes in bytes. Must not be NULL
+ *        unless count is 0.
+ * @param count is the number of inputs.
+ * @param output is a pointer to memory where the hashes will be stored. Must not be NULL
+ *        unless count is 0 and at least count * RANDOMX_HASH_SIZE bytes must be available
+ *        for writing. The hash of inputs[i] is stored at offset i * RANDOMX_HASH_SIZE.
+*/
+RANDOMX_EXPORT void randomx_calculate_hash_batch(randomx_vm *machine, const void *const *inputs, const size_t *inputSizes, size_t count, void *output);
+
 /**
  * Calculate a RandomX commitment from a RandomX hash and its input.
  *
@@ -282,6 +727,266 @@ RANDOMX_EXPORT void randomx_calculate_hash_last(randomx_vm* machine, void* outpu
 */
 RANDOMX_EXPORT void randomx_calculate_commitment(const void* input, size_t inputSize, const void* hash_in, void* com_out);
 
+/**
+ * Creates an epoch manager, which builds the dataset for the next key in the background
+ * while virtual machines keep hashing with the current dataset, and then switches all
+ * registered virtual machines to the new dataset. After the first switch, two datasets are
+ * kept: the current one and the previous one, which is reused to build the next dataset.
+ *
+ * @param flags is the flags used to allocate the cache and the datasets (see randomx_alloc_cache
+ *        and randomx_alloc_dataset).
+ * @param threadCount is the number of threads used to build a dataset (see randomx_init_dataset_parallel).
+ *        The threads run at the lowest scheduling priority.
+ * @param affinityMask is the CPU bitmask for the build threads (see randomx_init_dataset_parallel).
+ *
+ * @return Pointer to an initialized randomx_epoch_manager structure.
+ *         NULL is returned if memory allocation fails or if any of the selected flags is not supported.
+*/
+RANDOMX_EXPORT randomx_epoch_manager *randomx_create_epoch_manager(randomx_flags flags, unsigned threadCount, uint64_t affinityMask);
+
+/**
+ * Registers a virtual machine with the epoch manager. The virtual machine must have been created
+ * with RANDOMX_FLAG_FULL_MEM. If the epoch manager has a current dataset, it is set to the virtual
+ * machine immediately.
+ *
+ * @param manager is a pointer to a randomx_epoch_manager structure. Must not be NULL.
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_epoch_manager_register_vm(randomx_epoch_manager *manager, randomx_vm *machine);
+
+/**
+ * Unregisters a virtual machine. Must be called before the virtual machine is destroyed.
+ *
+ * @param manager is a pointer to a randomx_epoch_manager structure. Must not be NULL.
+ * @param machine is a pointer to a registered randomx_vm structure. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_epoch_manager_unregister_vm(randomx_epoch_manager *manager, randomx_vm *machine);
+
+/**
+ * Starts building the dataset for a new key in the background. A build that is already
+ * running is aborted.
+ *
+ * @param manager is a pointer to a randomx_epoch_manager structure. Must not be NULL.
+ * @param key is a pointer to memory which contains the key. Must not be NULL if keySize > 0.
+ * @param keySize is the number of bytes of the key.
+ *
+ * @return 1 if the build was started, 0 if the dataset could not be allocated.
+*/
+RANDOMX_EXPORT int randomx_epoch_manager_prepare(randomx_epoch_manager *manager, const void *key, size_t keySize);
+
+/**
+ * Checks whether the dataset for the key passed to randomx_epoch_manager_prepare is complete.
+ *
+ * @param manager is a pointer to a randomx_epoch_manager structure. Must not be NULL.
+ *
+ * @return 1 if the new dataset is ready, 0 otherwise.
+*/
+RANDOMX_EXPORT int randomx_epoch_manager_is_ready(randomx_epoch_manager *manager);
+
+/**
+ * Switches all registered virtual machines to the dataset built by randomx_epoch_manager_prepare
+ * (waiting for the build to complete). The previous dataset is kept for the next build.
+ *
+ * Note: None of the registered virtual machines may calculate a hash during the call.
+ * The caller chooses the moment of the switch, typically by pausing its hashing threads
+ * once randomx_epoch_manager_is_ready returns 1.
+ *
+ * @param manager is a pointer to a randomx_epoch_manager structure. Must not be NULL.
+ *
+ * @return 1 if the dataset was switched, 0 if no build was prepared.
+*/
+RANDOMX_EXPORT int randomx_epoch_manager_switch(randomx_epoch_manager *manager);
+
+/**
+ * Gets the current dataset, i.e. the dataset used by the registered virtual machines.
+ *
+ * @param manager is a pointer to a randomx_epoch_manager structure. Must not be NULL.
+ *
+ * @return Pointer to the current dataset (owned by the epoch manager) or NULL before the first switch.
+*/
+RANDOMX_EXPORT randomx_dataset *randomx_epoch_manager_get_dataset(randomx_epoch_manager *manager);
+
+/**
+ * Aborts a running build and releases the epoch manager and its datasets. Registered virtual
+ * machines must not calculate hashes afterwards until they are given another dataset.
+ *
+ * @param manager is a pointer to a randomx_epoch_manager structure.
+*/
+RANDOMX_EXPORT void randomx_destroy_epoch_manager(randomx_epoch_manager *manager);
+
+/**
+ * Creates a cache manager, which maps keys to reference-counted caches. The manager keeps
+ * the most recently used caches, so the caches for the current and the previous key can be
+ * used at the same time, and it can initialize the cache for an announced key in the background.
+ *
+ * @param flags is the flags used to allocate the caches (see randomx_alloc_cache).
+ * @param capacity is the number of caches to keep. Caches that are still acquired are never
+ *        released, so more caches may exist temporarily.
+ *
+ * @return Pointer to an initialized randomx_cache_manager structure.
+ *         NULL is returned if any of the selected flags is not supported or a thread cannot be created.
+*/
+RANDOMX_EXPORT randomx_cache_manager *randomx_create_cache_manager(randomx_flags flags, unsigned capacity);
+
+/**
+ * Acquires the cache for a key. If the manager does not have it, the cache is initialized
+ * by the calling thread. If it is being initialized by another thread, this function waits.
+ * The returned cache must not be reinitialized by the caller.
+ *
+ * @param manager is a pointer to a randomx_cache_manager structure. Must not be NULL.
+ * @param key is a pointer to memory which contains the key. Must not be NULL if keySize > 0.
+ * @param keySize is the number of bytes of the key.
+ *
+ * @return Pointer to an initialized cache, which must be released with randomx_cache_manager_release.
+ *         NULL is returned if memory allocation fails.
+*/
+RANDOMX_EXPORT randomx_cache *randomx_cache_manager_acquire(randomx_cache_manager *manager, const void *key, size_t keySize);
+
+/**
+ * Acquires the cache for a key if it is ready. This function never waits for a cache to be
+ * initialized, so it can be called from hashing threads.
+ *
+ * @param manager is a pointer to a randomx_cache_manager structure. Must not be NULL.
+ * @param key is a pointer to memory which contains the key. Must not be NULL if keySize > 0.
+ * @param keySize is the number of bytes of the key.
+ *
+ * @return Pointer to an initialized cache, which must be released with randomx_cache_manager_release,
+ *         or NULL if the cache is not ready.
+*/
+RANDOMX_EXPORT randomx_cache *randomx_cache_manager_try_acquire(randomx_cache_manager *manager, const void *key, size_t keySize);
+
+/**
+ * Releases a cache acquired from the manager.
+ *
+ * @param manager is a pointer to a randomx_cache_manager structure. Must not be NULL.
+ * @param cache is a pointer to a cache returned by randomx_cache_manager_acquire or
+ *        randomx_cache_manager_try_acquire. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_cache_manager_release(randomx_cache_manager *manager, randomx_cache *cache);
+
+/**
+ * Initializes the cache for a key in a background thread. The function returns immediately.
+ *
+ * @param manager is a pointer to a randomx_cache_manager structure. Must not be NULL.
+ * @param key is a pointer to memory which contains the key. Must not be NULL if keySize > 0.
+ * @param keySize is the number of bytes of the key.
+*/
+RANDOMX_EXPORT void randomx_cache_manager_prefetch(randomx_cache_manager *manager, const void *key, size_t keySize);
+
+/**
+ * Releases the cache manager and all its caches. All acquired caches must be released first.
+ *
+ * @param manager is a pointer to a randomx_cache_manager structure.
+*/
+RANDOMX_EXPORT void randomx_destroy_cache_manager(randomx_cache_manager *manager);
+
+/**
+ * Creates a pool of virtual machines, which can be acquired and released without allocating
+ * memory. The scratchpads of all virtual machines are carved out of a single slab allocated
+ * in large pages if possible, so hashing does not cause page faults and uses fewer TLB entries.
+ *
+ * @param flags is the flags used to create the virtual machines (see randomx_create_vm).
+ *        RANDOMX_FLAG_LARGE_PAGES is ignored; the slab always uses large pages if available.
+ * @param cache is the cache of the virtual machines (see randomx_create_vm).
+ * @param dataset is the dataset of the virtual machines (see randomx_create_vm).
+ * @param size is the number of virtual machines. At least one is created.
+ *
+ * @return Pointer to an initialized randomx_vm_pool structure.
+ *         NULL is returned if memory allocation fails or any of the selected flags is not supported.
+*/
+RANDOMX_EXPORT randomx_vm_pool *randomx_create_vm_pool(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, unsigned size);
+
+/**
+ * Acquires a virtual machine from the pool. If all of them are acquired, this function waits
+ * until one is released. The cache and the dataset of the virtual machine may be changed by
+ * randomx_vm_set_cache and randomx_vm_set_dataset; the change persists after it is released.
+ *
+ * @param pool is a pointer to a randomx_vm_pool structure. Must not be NULL.
+ *
+ * @return Pointer to a virtual machine, which must be released with randomx_vm_pool_release.
+*/
+RANDOMX_EXPORT randomx_vm *randomx_vm_pool_acquire(randomx_vm_pool *pool);
+
+/**
+ * Acquires a virtual machine from the pool if one is available. This function never waits.
+ *
+ * @param pool is a pointer to a randomx_vm_pool structure. Must not be NULL.
+ *
+ * @return Pointer to a virtual machine, which must be released with randomx_vm_pool_release,
+ *         or NULL if all virtual machines are acquired.
+*/
+RANDOMX_EXPORT randomx_vm *randomx_vm_pool_try_acquire(randomx_vm_pool *pool);
+
+/**
+ * Returns a virtual machine to the pool.
+ *
+ * @param pool is a pointer to a randomx_vm_pool structure. Must not be NULL.
+ * @param machine is a pointer to a virtual machine acquired from the pool. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_vm_pool_release(randomx_vm_pool *pool, randomx_vm *machine);
+
+/**
+ * Reads the statistics of the pool.
+ *
+ * @param pool is a pointer to a randomx_vm_pool structure. Must not be NULL.
+ * @param stats is a pointer to the structure to be filled. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_vm_pool_get_stats(randomx_vm_pool *pool, randomx_vm_pool_stats *stats);
+
+/**
+ * Releases the pool and all its virtual machines.
+ *
+ * Note: All virtual machines must be released first (see randomx_vm_pool_release). Their
+ * scratchpads are part of the pool's memory, so a virtual machine that is still acquired
+ * must not be used after the pool is destroyed.
+ *
+ * @param pool is a pointer to a randomx_vm_pool structure.
+*/
+RANDOMX_EXPORT void randomx_destroy_vm_pool(randomx_vm_pool *pool);
+
+/**
+ * Creates a verification service, which calculates hashes of submitted jobs asynchronously
+ * on a pool of worker threads. Each worker uses its own light virtual machine. The caches
+ * are shared by all workers (see randomx_create_cache_manager).
+ *
+ * @param flags is the flags used to create the caches and the virtual machines (see randomx_alloc_cache
+ *        and randomx_create_vm). RANDOMX_FLAG_FULL_MEM is ignored.
+ * @param threadCount is the number of worker threads. If 0, the number of hardware threads is used.
+ * @param cacheCapacity is the number of caches to keep (see randomx_create_cache_manager).
+ *
+ * @return Pointer to an initialized randomx_verify_service structure.
+ *         NULL is returned if any of the selected flags is not supported or threads cannot be created.
+*/
+RANDOMX_EXPORT randomx_verify_service *randomx_create_verify_service(randomx_flags flags, unsigned threadCount, unsigned cacheCapacity);
+
+/**
+ * Submits a job to the verification service. The key and the input are copied, so the memory
+ * can be reused when the function returns. The callback is called from a worker thread.
+ *
+ * @param service is a pointer to a randomx_verify_service structure. Must not be NULL.
+ * @param key is a pointer to memory which contains the cache key. Must not be NULL if keySize > 0.
+ * @param keySize is the number of bytes of the key.
+ * @param input is a pointer to memory to be hashed. Must not be NULL if inputSize > 0.
+ * @param inputSize is the number of bytes to be hashed.
+ * @param callback is the function called with the result. Must not be NULL.
+ * @param userData is passed to the callback.
+*/
+RANDOMX_EXPORT void randomx_verify_service_submit(randomx_verify_service *service, const void *key, size_t keySize, const void *input, size_t inputSize, randomx_verify_callback *callback, void *userData);
+
+/**
+ * Waits until all submitted jobs are complete and their callbacks have returned.
+ *
+ * @param service is a pointer to a randomx_verify_service structure. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_verify_service_wait(randomx_verify_service *service);
+
+/**
+ * Completes all submitted jobs and releases the verification service.
+ *
+ * @param service is a pointer to a randomx_verify_service structure.
+*/
+RANDOMX_EXPORT void randomx_destroy_verify_service(randomx_verify_service *service);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -323,7 +323,35 @@ extern "C" alignas(16) const uint8_t randomx_aes_lut_dec_index[4][32] = {
 	{ 7, 255, 255, 255, 11, 255, 255, 255, 15, 255, 255, 255, 3, 255, 255, 255, 23, 255, 255, 255, 27, 255, 255, 255, 31, 255, 255, 255, 19, 255, 255, 255 }
 };
 
-rx_vec_i128 soft_aesenc(rx_vec_i128 in, rx_vec_i128 key) {
+extern "C" alignas(16) const uint8_t randomx_aes_vperm[17][16] = {
+	//GF(2^4) reciprocals, 1/0 is mapped to 0x80 so that PSHUFB returns 0
+	{ 0x80, 0x01, 0x09, 0x0e, 0x0d, 0x0b, 0x07, 0x06, 0x0f, 0x02, 0x0c, 0x05, 0x0a, 0x04, 0x03, 0x08 },
+	{ 0x80, 0x0f, 0x0e, 0x05, 0x07, 0x03, 0x0b, 0x04, 0x0a, 0x0d, 0x08, 0x06, 0x0c, 0x09, 0x02, 0x01 },
+	//AESENC: input basis change (low, high nibble), S-box output (low, high half of the tower)
+	{ 0x00, 0x01, 0x30, 0x31, 0x66, 0x67, 0x56, 0x57, 0x6c, 0x6d, 0x5c, 0x5d, 0x0a, 0x0b, 0x3a, 0x3b },
+	{ 0x00, 0xbc, 0x25, 0x99, 0xb4, 0x08, 0x91, 0x2d, 0x95, 0x29, 0xb0, 0x0c, 0x21, 0x9d, 0x04, 0xb8 },
+	{ 0x00, 0x2d, 0x7e, 0x26, 0xeb, 0x9e, 0x58, 0x75, 0x0b, 0xe0, 0xc6, 0xb8, 0xb3, 0x95, 0xcd, 0x53 },
+	{ 0x00, 0x60, 0x65, 0x32, 0x3e, 0x09, 0x57, 0x37, 0x52, 0x6c, 0x5e, 0x3b, 0x69, 0x5b, 0x0c, 0x05 },
+	//AESDEC: same as above for the inverse S-box
+	{ 0x67, 0x8f, 0x28, 0xc0, 0x2f, 0xc7, 0x60, 0x88, 0x5f, 0xb7, 0x10, 0xf8, 0x17, 0xff, 0x58, 0xb0 },
+	{ 0x00, 0xd6, 0xd9, 0x0f, 0x19, 0xcf, 0xc0, 0x16, 0x42, 0x94, 0x9b, 0x4d, 0x5b, 0x8d, 0x82, 0x54 },
+	{ 0x00, 0x78, 0x90, 0xf4, 0x72, 0x6e, 0x64, 0x1c, 0x8c, 0xfe, 0x0a, 0x9a, 0x16, 0xe2, 0x86, 0xe8 },
+	{ 0x00, 0xdb, 0xb8, 0x79, 0x02, 0x18, 0xc1, 0x1a, 0xa2, 0xa0, 0xd9, 0x61, 0xc3, 0xba, 0x7b, 0x63 },
+	//low nibble mask
+	{ 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f },
+	//ShiftRows, InvShiftRows
+	{ 0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11 },
+	{ 0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3 },
+	//rotate each column by 1 and 2 bytes
+	{ 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12 },
+	{ 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 },
+	//xtime reduction polynomial
+	{ 0x1b, 0x1b, 0x1b, 0x1b, 0x1b, 0x1b, 0x1b, 0x1b, 0x1b, 0x1b, 0x1b, 0x1b, 0x1b, 0x1b, 0x1b, 0x1b },
+	//S-box affine constant
+	{ 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63 },
+};
+
+rx_vec_i128 soft_aesenc_table(rx_vec_i128 in, rx_vec_i128 key) {
 	uint32_t s0, s1, s2, s3;
 
 	s0 = rx_vec_i128_w(in);
@@ -346,7 +374,7 @@ rx_vec_i128 soft_aesenc(rx_vec_i128 in, rx_vec_i128 key) {
 #define lutDec2 randomx_aes_lut_dec[2]
 #define lutDec3 randomx_aes_lut_dec[3]
 
-rx_vec_i128 soft_aesdec(rx_vec_i128 in, rx_vec_i128 key) {
+rx_vec_i128 soft_aesdec_table(rx_vec_i128 in, rx_vec_i128 key) {
 	uint32_t s0, s1, s2, s3;
 
 	s0 = rx_vec_i128_w(in);
@@ -363,3 +391,53 @@ rx_vec_i128 soft_aesdec(rx_vec_i128 in, rx_vec_i128 key) {
 
 	return rx_xor_vec_i128(out, key);
 }
+
+namespace randomx {
+
+	static SoftAesImpl defaultSoftAesImpl() {
+#ifdef RANDOMX_HAVE_SOFT_AES_VPERM
+		if (soft_aes_vperm_supported()) {
+			return SoftAesImpl::Vperm;
+		}
+#endif
+		return SoftAesImpl::Table;
+	}
+
+	static SoftAesImpl softAesImpl = defaultSoftAesImpl();
+
+	SoftAesImpl getSoftAesImpl() {
+		return softAesImpl;
+	}
+
+	bool setSoftAesImpl(SoftAesImpl impl) {
+#ifdef RANDOMX_HAVE_SOFT_AES_VPERM
+		if (impl == SoftAesImpl::Vperm && !soft_aes_vperm_supported()) {
+			return false;
+		}
+#else
+		if (impl == SoftAesImpl::Vperm) {
+			return false;
+		}
+#endif
+		softAesImpl = impl;
+		return true;
+	}
+}
+
+rx_vec_i128 soft_aesenc(rx_vec_i128 in, rx_vec_i128 key) {
+#ifdef RANDOMX_HAVE_SOFT_AES_VPERM
+	if (randomx::softAesImpl == randomx::SoftAesImpl::Vperm) {
+		return soft_aesenc_vperm(in, key);
+	}
+#endif
+	return soft_aesenc_table(in, key);
+}
+
+rx_vec_i128 soft_aesdec(rx_vec_i128 in, rx_vec_i128 key) {
+#ifdef RANDOMX_HAVE_SOFT_AES_VPERM
+	if (randomx::softAesImpl == randomx::SoftAesImpl::Vperm) {
+		return soft_aesdec_vperm(in, key);
+	}
+#endif
+	return soft_aesdec_table(in, key);
+}
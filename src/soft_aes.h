@@ -37,10 +37,43 @@ extern "C" const uint32_t randomx_aes_lut_dec[4][256];
 extern "C" const uint8_t randomx_aes_lut_enc_index[4][32];
 extern "C" const uint8_t randomx_aes_lut_dec_index[4][32];
 
+#if defined(_M_X64) || defined(__x86_64__)
+#define RANDOMX_HAVE_SOFT_AES_VPERM
+#endif
+
+//nibble tables and shuffle masks of the constant-time implementation (see soft_aes_vperm.hpp)
+extern "C" const uint8_t randomx_aes_vperm[17][16];
+
+namespace randomx {
+
+	enum class SoftAesImpl {
+		Table, //T-tables, fastest portable code, memory access pattern depends on the data
+		Vperm, //SSSE3 byte shuffles, constant-time
+	};
+
+	//Vperm is the default when the CPU supports SSSE3
+	SoftAesImpl getSoftAesImpl();
+
+	//returns false if the implementation is not supported by this CPU
+	bool setSoftAesImpl(SoftAesImpl impl);
+}
+
 rx_vec_i128 soft_aesenc(rx_vec_i128 in, rx_vec_i128 key);
 
 rx_vec_i128 soft_aesdec(rx_vec_i128 in, rx_vec_i128 key);
 
+rx_vec_i128 soft_aesenc_table(rx_vec_i128 in, rx_vec_i128 key);
+
+rx_vec_i128 soft_aesdec_table(rx_vec_i128 in, rx_vec_i128 key);
+
+#ifdef RANDOMX_HAVE_SOFT_AES_VPERM
+rx_vec_i128 soft_aesenc_vperm(rx_vec_i128 in, rx_vec_i128 key);
+
+rx_vec_i128 soft_aesdec_vperm(rx_vec_i128 in, rx_vec_i128 key);
+
+bool soft_aes_vperm_supported();
+#endif
+
 template<bool soft>
 inline rx_vec_i128 aesenc(rx_vec_i128 in, rx_vec_i128 key) {
 	return soft ? soft_aesenc(in, key) : rx_aesenc_vec_i128(in, key);
@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "soft_aes.h"
+#include "cpu.hpp"
+
+#if defined(_MSC_VER) //MSVC doesn't define SSSE3
+#define __SSSE3__
+#endif
+
+#if defined(__SSSE3__)
+
+#include "soft_aes_vperm.hpp"
+
+bool soft_aes_vperm_supported() {
+	//may be called during static initialization, so randomx::cpu cannot be used
+	static const randomx::Cpu cpu;
+	return cpu.hasSsse3();
+}
+
+rx_vec_i128 soft_aesenc_vperm(rx_vec_i128 in, rx_vec_i128 key) {
+	return randomx::vpermAesEnc<__m128i>(in, key);
+}
+
+rx_vec_i128 soft_aesdec_vperm(rx_vec_i128 in, rx_vec_i128 key) {
+	return randomx::vpermAesDec<__m128i>(in, key);
+}
+
+#else
+
+//the compiler doesn't support SSSE3
+
+bool soft_aes_vperm_supported() {
+	return false;
+}
+
+rx_vec_i128 soft_aesenc_vperm(rx_vec_i128 in, rx_vec_i128 key) {
+	return soft_aesenc_table(in, key);
+}
+
+rx_vec_i128 soft_aesdec_vperm(rx_vec_i128 in, rx_vec_i128 key) {
+	return soft_aesdec_table(in, key);
+}
+
+#endif
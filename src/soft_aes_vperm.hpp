@@ -0,0 +1,154 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "soft_aes.h"
+
+#include <immintrin.h>
+
+/*
+	Constant-time AES rounds built from byte shuffles (vector permute AES).
+
+	SubBytes computes the GF(2^8) inverse in a GF(2^4)^2 tower field:
+	a nibble-indexed linear map moves the byte into tower coordinates,
+	the inverse is built from 4-bit reciprocal tables and a second pair
+	of nibble tables maps it back (through the AES affine transform).
+	No memory address depends on the data, unlike the T-table code.
+
+	This header must only be included by files compiled with SSSE3
+	(128-bit rounds) or AVX2 (256-bit rounds, 2 independent states).
+	All functions have internal linkage so that the copies compiled
+	with different instruction sets are never merged by the linker.
+*/
+
+namespace randomx {
+
+	enum VpermTable {
+		VpermInv,
+		VpermInvA,
+		VpermEncIn0,
+		VpermEncIn1,
+		VpermEncOut0,
+		VpermEncOut1,
+		VpermDecIn0,
+		VpermDecIn1,
+		VpermDecOut0,
+		VpermDecOut1,
+		VpermMask0F,
+		VpermShiftRows,
+		VpermInvShiftRows,
+		VpermRotate1,
+		VpermRotate2,
+		VpermConst1B,
+		VpermConst63,
+	};
+
+	template<typename V> static V vpermTable(VpermTable t);
+	template<typename V> static V vpermShuffle(V table, V index);
+
+	template<> FORCE_INLINE __m128i vpermTable<__m128i>(VpermTable t) {
+		return _mm_load_si128((const __m128i*)randomx_aes_vperm[t]);
+	}
+
+	template<> FORCE_INLINE __m128i vpermShuffle<__m128i>(__m128i table, __m128i index) {
+		return _mm_shuffle_epi8(table, index);
+	}
+
+	static FORCE_INLINE __m128i vpermXor(__m128i a, __m128i b) { return _mm_xor_si128(a, b); }
+	static FORCE_INLINE __m128i vpermAnd(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+	static FORCE_INLINE __m128i vpermShr4(__m128i a) { return _mm_srli_epi16(a, 4); }
+	static FORCE_INLINE __m128i vpermXtimeMask(__m128i a) { return _mm_cmpgt_epi8(_mm_setzero_si128(), a); }
+	static FORCE_INLINE __m128i vpermAdd(__m128i a, __m128i b) { return _mm_add_epi8(a, b); }
+
+#if defined(__AVX2__)
+	template<> FORCE_INLINE __m256i vpermTable<__m256i>(VpermTable t) {
+		return _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)randomx_aes_vperm[t]));
+	}
+
+	template<> FORCE_INLINE __m256i vpermShuffle<__m256i>(__m256i table, __m256i index) {
+		return _mm256_shuffle_epi8(table, index);
+	}
+
+	static FORCE_INLINE __m256i vpermXor(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+	static FORCE_INLINE __m256i vpermAnd(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+	static FORCE_INLINE __m256i vpermShr4(__m256i a) { return _mm256_srli_epi16(a, 4); }
+	static FORCE_INLINE __m256i vpermXtimeMask(__m256i a) { return _mm256_cmpgt_epi8(_mm256_setzero_si256(), a); }
+	static FORCE_INLINE __m256i vpermAdd(__m256i a, __m256i b) { return _mm256_add_epi8(a, b); }
+#endif
+
+	template<typename V>
+	static FORCE_INLINE V vpermSubBytes(V x, VpermTable in0, VpermTable in1, VpermTable out0, VpermTable out1) {
+		const V mask0F = vpermTable<V>(VpermMask0F);
+		const V inv = vpermTable<V>(VpermInv);
+		V lo = vpermAnd(x, mask0F);
+		V hi = vpermAnd(vpermShr4(x), mask0F);
+		V t = vpermXor(vpermShuffle(vpermTable<V>(in0), lo), vpermShuffle(vpermTable<V>(in1), hi));
+		V k = vpermAnd(t, mask0F);
+		V i = vpermAnd(vpermShr4(t), mask0F);
+		V ak = vpermShuffle(vpermTable<V>(VpermInvA), k);
+		V j = vpermXor(i, k);
+		V iak = vpermXor(vpermShuffle(inv, i), ak);
+		V jak = vpermXor(vpermShuffle(inv, j), ak);
+		V io = vpermXor(vpermShuffle(inv, iak), j);
+		V jo = vpermXor(vpermShuffle(inv, jak), i);
+		return vpermXor(vpermShuffle(vpermTable<V>(out0), io), vpermShuffle(vpermTable<V>(out1), jo));
+	}
+
+	template<typename V>
+	static FORCE_INLINE V vpermXtime(V x) {
+		return vpermXor(vpermAdd(x, x), vpermAnd(vpermXtimeMask(x), vpermTable<V>(VpermConst1B)));
+	}
+
+	template<typename V>
+	static FORCE_INLINE V vpermMixColumns(V a) {
+		V r1 = vpermShuffle(a, vpermTable<V>(VpermRotate1));
+		V t = vpermXor(a, r1);
+		return vpermXor(vpermXor(vpermXtime(t), r1), vpermShuffle(t, vpermTable<V>(VpermRotate2)));
+	}
+
+	//same result as the AESENC instruction
+	template<typename V>
+	static FORCE_INLINE V vpermAesEnc(V in, V key) {
+		V s = vpermShuffle(in, vpermTable<V>(VpermShiftRows));
+		s = vpermSubBytes(s, VpermEncIn0, VpermEncIn1, VpermEncOut0, VpermEncOut1);
+		//the 0x63 affine constant commutes with MixColumns
+		return vpermXor(vpermMixColumns(s), vpermXor(key, vpermTable<V>(VpermConst63)));
+	}
+
+	//same result as the AESDEC instruction
+	template<typename V>
+	static FORCE_INLINE V vpermAesDec(V in, V key) {
+		V s = vpermShuffle(in, vpermTable<V>(VpermInvShiftRows));
+		s = vpermSubBytes(s, VpermDecIn0, VpermDecIn1, VpermDecOut0, VpermDecOut1);
+		//InvMixColumns = MixColumns after multiplying (a0 ^ a2) and (a1 ^ a3) by 4
+		V w = vpermXor(s, vpermShuffle(s, vpermTable<V>(VpermRotate2)));
+		s = vpermXor(s, vpermXtime(vpermXtime(w)));
+		return vpermXor(vpermMixColumns(s), key);
+	}
+}
@@ -900,4 +900,68 @@ namespace randomx {
 			}
 		}
 	}
+
+	void executeSuperscalarInterleaved(int_reg_t(&r)[2][8], SuperscalarProgram& prog, std::vector<uint64_t> *reciprocals) {
+		int_reg_t* a = r[0];
+		int_reg_t* b = r[1];
+		for (unsigned j = 0; j < prog.getSize(); ++j) {
+			Instruction& instr = prog(j);
+			const unsigned dst = instr.dst;
+			const unsigned src = instr.src;
+			switch ((SuperscalarInstructionType)instr.opcode)
+			{
+			case SuperscalarInstructionType::ISUB_R:
+				a[dst] -= a[src];
+				b[dst] -= b[src];
+				break;
+			case SuperscalarInstructionType::IXOR_R:
+				a[dst] ^= a[src];
+				b[dst] ^= b[src];
+				break;
+			case SuperscalarInstructionType::IADD_RS: {
+				const unsigned shift = instr.getModShift();
+				a[dst] += a[src] << shift;
+				b[dst] += b[src] << shift;
+			} break;
+			case SuperscalarInstructionType::IMUL_R:
+				a[dst] *= a[src];
+				b[dst] *= b[src];
+				break;
+			case SuperscalarInstructionType::IROR_C: {
+				const uint32_t count = instr.getImm32();
+				a[dst] = rotr(a[dst], count);
+				b[dst] = rotr(b[dst], count);
+			} break;
+			case SuperscalarInstructionType::IADD_C7:
+			case SuperscalarInstructionType::IADD_C8:
+			case SuperscalarInstructionType::IADD_C9: {
+				const uint64_t imm = signExtend2sCompl(instr.getImm32());
+				a[dst] += imm;
+				b[dst] += imm;
+			} break;
+			case SuperscalarInstructionType::IXOR_C7:
+			case SuperscalarInstructionType::IXOR_C8:
+			case SuperscalarInstructionType::IXOR_C9: {
+				const uint64_t imm = signExtend2sCompl(instr.getImm32());
+				a[dst] ^= imm;
+				b[dst] ^= imm;
+			} break;
+			case SuperscalarInstructionType::IMULH_R:
+				a[dst] = mulh(a[dst], a[src]);
+				b[dst] = mulh(b[dst], b[src]);
+				break;
+			case SuperscalarInstructionType::ISMULH_R:
+				a[dst] = smulh(a[dst], a[src]);
+				b[dst] = smulh(b[dst], b[src]);
+				break;
+			case SuperscalarInstructionType::IMUL_RCP: {
+				const uint64_t rcp = reciprocals != nullptr ? (*reciprocals)[instr.getImm32()] : randomx_reciprocal(instr.getImm32());
+				a[dst] *= rcp;
+				b[dst] *= rcp;
+			} break;
+			default:
+				UNREACHABLE;
+			}
+		}
+	}
 }
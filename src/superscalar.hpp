@@ -57,4 +57,6 @@ namespace randomx {
 
 	void generateSuperscalar(SuperscalarProgram& prog, Blake2Generator& gen);
 	void executeSuperscalar(uint64_t(&r)[8], SuperscalarProgram& prog, std::vector<uint64_t> *reciprocals = nullptr);
+	//executes the program for two independent register files, interleaving their dependency chains
+	void executeSuperscalarInterleaved(uint64_t(&r)[2][8], SuperscalarProgram& prog, std::vector<uint64_t> *reciprocals = nullptr);
 }
\ No newline at end of file
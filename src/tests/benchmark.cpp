@@ -32,8 +32,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <exception>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include "stopwatch.hpp"
 #include "utility.hpp"
 #include "../randomx.h"
@@ -41,11 +43,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../blake2/endian.h"
 #include "../common.hpp"
 #include "../jit_compiler.hpp"
+#include "../aes_hash.hpp"
+#include "../aes_hash_vaes.hpp"
+#include "../cpu.hpp"
+#include "../soft_aes.h"
 #ifdef _WIN32
 #include <windows.h>
 #include <versionhelpers.h>
 #endif
-#include "affinity.hpp"
+#include "../affinity.hpp"
 
 const uint8_t blockTemplate_[] = {
 		0x07, 0x07, 0xf7, 0xa4, 0xf0, 0xd6, 0x05, 0xb3, 0x03, 0x26, 0x08, 0x16, 0xba, 0x3f, 0x10, 0x90, 0x2e, 0x1a, 0x14,
@@ -87,17 +93,27 @@ void printUsage(const char* executable) {
 	std::cout << "  --secure      W^X policy for JIT pages (default: off)" << std::endl;
 	std::cout << "  --largePages  use large pages (default: small pages)" << std::endl;
 	std::cout << "  --softAes     use software AES (default: hardware AES)" << std::endl;
+	std::cout << "  --aesTable    use table-based software AES (default: constant-time if supported)" << std::endl;
+	std::cout << "  --vaes        use 256-bit VAES for hardware AES (default: AES-NI)" << std::endl;
 	std::cout << "  --threads T   use T threads (default: 1)" << std::endl;
 	std::cout << "  --affinity A  thread affinity bitmask (default: 0)" << std::endl;
+	std::cout << "  --numa        one dataset replica per NUMA node with memory (use with --affinity, not with --dataset)" << std::endl;
+	std::cout << "  --lazy        calculate dataset items on first access (use with --mine)" << std::endl;
 	std::cout << "  --init Q      initialize dataset with Q threads (default: 1)" << std::endl;
+	std::cout << "  --dataset F   load the dataset from file F or save it after initialization" << std::endl;
+	std::cout << "  --cache F     load the cache from file F or save it after initialization" << std::endl;
 	std::cout << "  --nonces N    run N nonces (default: 1000)" << std::endl;
 	std::cout << "  --seed S      seed for cache initialization (default: 0)" << std::endl;
 	std::cout << "  --ssse3       use optimized Argon2 for SSSE3 CPUs" << std::endl;
 	std::cout << "  --avx2        use optimized Argon2 for AVX2 CPUs" << std::endl;
+	std::cout << "  --avx512      use optimized Argon2 for AVX-512 CPUs" << std::endl;
 	std::cout << "  --auto        select the best options for the current CPU" << std::endl;
 	std::cout << "  --noBatch     calculate hashes one by one (default: batch)" << std::endl;
+	std::cout << "  --batch N     calculate hashes in arrays of N inputs (default: off)" << std::endl;
 	std::cout << "  --commit      calculate commitments instead of hashes (default: hashes)" << std::endl;
 	std::cout << "  --v2          calculate RandomX v2 hashes" << std::endl;
+	std::cout << "  --verify-service  verify nonces with an asynchronous verification service, one job per thread in flight (implies --verify)" << std::endl;
+	std::cout << "  --aes         benchmark the scratchpad AES fill and hash functions" << std::endl;
 }
 
 struct MemoryException : public std::exception {
@@ -113,16 +129,25 @@ struct DatasetAllocException : public MemoryException {
 	}
 };
 
-using MineFunc = void(randomx_vm * vm, std::atomic<uint32_t> & atomicNonce, AtomicHash & result, uint32_t noncesCount, int thread, int cpuid);
+std::string pageSizeToString(size_t size) {
+	if (size >= 1024 * 1024 * 1024)
+		return std::to_string(size >> 30) + " GiB";
+	if (size >= 1024 * 1024)
+		return std::to_string(size >> 20) + " MiB";
+	return std::to_string(size >> 10) + " KiB";
+}
+
+using MineFunc = void(randomx_vm * vm, std::atomic<uint32_t> & atomicNonce, AtomicHash & result, uint32_t noncesCount, uint32_t batchSize, int thread, int cpuid);
 
 template<bool batch, bool commit>
-void mine(randomx_vm* vm, std::atomic<uint32_t>& atomicNonce, AtomicHash& result, uint32_t noncesCount, int thread, int cpuid = -1) {
+void mine(randomx_vm* vm, std::atomic<uint32_t>& atomicNonce, AtomicHash& result, uint32_t noncesCount, uint32_t batchSize, int thread, int cpuid = -1) {
 	if (cpuid >= 0) {
-		int rc = set_thread_affinity(cpuid);
+		int rc = randomx::set_thread_affinity(cpuid);
 		if (rc) {
 			std::cerr << "Failed to set thread affinity for thread " << thread << " (error=" << rc << ")" << std::endl;
 		}
 	}
+	(void)batchSize; //only used by mineArray
 	uint64_t hash[RANDOMX_HASH_SIZE / sizeof(uint64_t)];
 	uint8_t blockTemplate[sizeof(blockTemplate_)];
 	memcpy(blockTemplate, blockTemplate_, sizeof(blockTemplate));
@@ -150,12 +175,192 @@ void mine(randomx_vm* vm, std::atomic<uint32_t>& atomicNonce, AtomicHash& result
 	}
 }
 
+template<bool commit>
+void mineArray(randomx_vm* vm, std::atomic<uint32_t>& atomicNonce, AtomicHash& result, uint32_t noncesCount, uint32_t batchSize, int thread, int cpuid = -1) {
+	if (cpuid >= 0) {
+		int rc = randomx::set_thread_affinity(cpuid);
+		if (rc) {
+			std::cerr << "Failed to set thread affinity for thread " << thread << " (error=" << rc << ")" << std::endl;
+		}
+	}
+	std::vector<uint8_t> blockTemplates(batchSize * sizeof(blockTemplate_));
+	std::vector<const void*> inputs(batchSize);
+	std::vector<size_t> inputSizes(batchSize, sizeof(blockTemplate_));
+	std::vector<uint64_t> hashes(batchSize * RANDOMX_HASH_SIZE / sizeof(uint64_t));
+	for (uint32_t i = 0; i < batchSize; ++i) {
+		inputs[i] = &blockTemplates[i * sizeof(blockTemplate_)];
+		memcpy(&blockTemplates[i * sizeof(blockTemplate_)], blockTemplate_, sizeof(blockTemplate_));
+	}
+	auto nonce = atomicNonce.fetch_add(batchSize);
+
+	while (nonce < noncesCount) {
+		uint32_t count = std::min(batchSize, noncesCount - nonce);
+		for (uint32_t i = 0; i < count; ++i) {
+			store32(&blockTemplates[i * sizeof(blockTemplate_) + 39], nonce + i);
+		}
+		randomx_calculate_hash_batch(vm, inputs.data(), inputSizes.data(), count, hashes.data());
+		for (uint32_t i = 0; i < count; ++i) {
+			uint64_t* hash = &hashes[i * RANDOMX_HASH_SIZE / sizeof(uint64_t)];
+			if (commit) {
+				randomx_calculate_commitment(inputs[i], inputSizes[i], hash, hash);
+			}
+			result.xorWith(hash);
+		}
+		nonce = atomicNonce.fetch_add(batchSize);
+	}
+}
+
+struct VerifyLoop;
+
+struct VerifyJob {
+	std::chrono::steady_clock::time_point submitted;
+	double latency;
+	VerifyLoop* loop;
+};
+
+//Keeps one job per worker thread in flight, so the latency of a job does not include
+//the time it spends queued behind the other nonces.
+struct VerifyLoop {
+	VerifyLoop(randomx_verify_service* service, const char* seed, size_t seedSize, AtomicHash& result, uint32_t noncesCount)
+		: service(service), seed(seed), seedSize(seedSize), result(result), jobs(noncesCount), nextNonce(0) {}
+	void submit(uint32_t nonce);
+	static void callback(void* userData, const void* hash);
+
+	randomx_verify_service* const service;
+	const char* const seed;
+	const size_t seedSize;
+	AtomicHash& result;
+	std::vector<VerifyJob> jobs;
+	std::atomic<uint32_t> nextNonce;
+};
+
+void VerifyLoop::submit(uint32_t nonce) {
+	uint8_t blockTemplate[sizeof(blockTemplate_)];
+	memcpy(blockTemplate, blockTemplate_, sizeof(blockTemplate));
+	store32(blockTemplate + 39, nonce);
+	VerifyJob& job = jobs[nonce];
+	job.loop = this;
+	job.submitted = std::chrono::steady_clock::now();
+	randomx_verify_service_submit(service, seed, seedSize, blockTemplate, sizeof(blockTemplate), &VerifyLoop::callback, &job);
+}
+
+void VerifyLoop::callback(void* userData, const void* hash) {
+	VerifyJob* job = (VerifyJob*)userData;
+	VerifyLoop* loop = job->loop;
+	job->latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - job->submitted).count();
+	if (hash != nullptr) {
+		uint64_t h[RANDOMX_HASH_SIZE / sizeof(uint64_t)];
+		memcpy(h, hash, sizeof(h));
+		loop->result.xorWith(h);
+	}
+	//the next job is submitted before this one is counted as finished,
+	//so randomx_verify_service_wait returns only after the last nonce
+	uint32_t nonce = loop->nextNonce.fetch_add(1);
+	if (nonce < loop->jobs.size()) {
+		loop->submit(nonce);
+	}
+}
+
+void verifyService(randomx_flags flags, const char* seed, size_t seedSize, AtomicHash& result, uint32_t noncesCount, int threadCount) {
+	randomx_verify_service* service = randomx_create_verify_service(flags, threadCount, 1);
+	if (service == nullptr) {
+		throw std::runtime_error("Cannot create the verification service");
+	}
+
+	//the first job initializes the cache
+	AtomicHash warmupResult;
+	VerifyLoop warmup(service, seed, seedSize, warmupResult, 1);
+	warmup.nextNonce = 1;
+	Stopwatch sw(true);
+	warmup.submit(0);
+	randomx_verify_service_wait(service);
+	std::cout << "Memory initialized in " << sw.getElapsed() << " s" << std::endl;
+
+	VerifyLoop loop(service, seed, seedSize, result, noncesCount);
+	uint32_t inFlight = std::min<uint32_t>(noncesCount, std::max(threadCount, 1));
+	loop.nextNonce = inFlight;
+	std::cout << "Running benchmark (" << noncesCount << " nonces) ..." << std::endl;
+	sw.restart();
+	for (uint32_t nonce = 0; nonce < inFlight; ++nonce) {
+		loop.submit(nonce);
+	}
+	randomx_verify_service_wait(service);
+	double elapsed = sw.getElapsed();
+	randomx_destroy_verify_service(service);
+
+	std::vector<double> latencies(noncesCount);
+	for (uint32_t i = 0; i < noncesCount; ++i) {
+		latencies[i] = loop.jobs[i].latency;
+	}
+	std::sort(latencies.begin(), latencies.end());
+	std::cout << "Calculated result: ";
+	result.print(std::cout);
+	std::cout << "Performance: " << noncesCount / elapsed << " jobs per second" << std::endl;
+	if (noncesCount > 0) {
+		std::cout << "Latency: p50 " << 1000 * latencies[(noncesCount - 1) / 2] << " ms, p99 " << 1000 * latencies[(noncesCount - 1) * 99 / 100] << " ms" << std::endl;
+	}
+}
+
+template<typename Func>
+void aesBenchmarkRun(const char* name, Func func) {
+	constexpr int iterations = 1000;
+	func();
+	Stopwatch sw(true);
+	for (int i = 0; i < iterations; ++i) {
+		func();
+	}
+	double elapsed = sw.getElapsed();
+	std::cout << "  " << std::left << std::setw(30) << name << std::right << std::fixed << std::setprecision(1)
+		<< 1e6 * elapsed / iterations << " us (" << iterations * (double)randomx::ScratchpadSize / elapsed / (1 << 30) << " GiB/s)" << std::endl;
+	std::cout.unsetf(std::ios_base::floatfield);
+}
+
+void aesBenchmark() {
+	std::vector<uint8_t> buffer(randomx::ScratchpadSize + 64);
+	uint8_t* scratchpad = buffer.data() + (64 - ((uintptr_t)buffer.data() % 64)) % 64;
+	alignas(16) uint8_t state[64] = {};
+	alignas(16) uint8_t hash[64];
+	std::cout << "AES microbenchmark (" << randomx::ScratchpadSize / 1024 << " KiB per call):" << std::endl;
+	aesBenchmarkRun("fillAes1Rx4 (128-bit)", [&]() { fillAes1Rx4Vec128<false>(state, randomx::ScratchpadSize, scratchpad); });
+	aesBenchmarkRun("fillAes4Rx4 (128-bit)", [&]() { fillAes4Rx4Vec128<false>(state, randomx::ScratchpadSize, scratchpad); });
+	aesBenchmarkRun("hashAes1Rx4 (128-bit)", [&]() { hashAes1Rx4Vec128<false>(scratchpad, randomx::ScratchpadSize, hash); });
+	aesBenchmarkRun("hashAndFillAes1Rx4 (128-bit)", [&]() { hashAndFillAes1Rx4Vec128<false>(scratchpad, randomx::ScratchpadSize, hash, state); });
+#ifdef RANDOMX_HAVE_VAES
+	if (randomx::cpu.hasVaes()) {
+		aesBenchmarkRun("fillAes1Rx4 (VAES)", [&]() { fillAes1Rx4_vaes(state, randomx::ScratchpadSize, scratchpad); });
+		aesBenchmarkRun("fillAes4Rx4 (VAES)", [&]() { fillAes4Rx4_vaes(state, randomx::ScratchpadSize, scratchpad); });
+		aesBenchmarkRun("hashAes1Rx4 (VAES)", [&]() { hashAes1Rx4_vaes(scratchpad, randomx::ScratchpadSize, hash); });
+		aesBenchmarkRun("hashAndFillAes1Rx4 (VAES)", [&]() { hashAndFillAes1Rx4_vaes(scratchpad, randomx::ScratchpadSize, hash, state); });
+	}
+	else {
+		std::cout << "  VAES is not supported by this CPU" << std::endl;
+	}
+#endif
+	randomx::SoftAesImpl impl = randomx::getSoftAesImpl();
+	randomx::setSoftAesImpl(randomx::SoftAesImpl::Table);
+	aesBenchmarkRun("fillAes1Rx4 (soft, tables)", [&]() { fillAes1Rx4Vec128<true>(state, randomx::ScratchpadSize, scratchpad); });
+	aesBenchmarkRun("hashAes1Rx4 (soft, tables)", [&]() { hashAes1Rx4Vec128<true>(scratchpad, randomx::ScratchpadSize, hash); });
+#ifdef RANDOMX_HAVE_SOFT_AES_VPERM
+	if (randomx::setSoftAesImpl(randomx::SoftAesImpl::Vperm)) {
+		aesBenchmarkRun("fillAes1Rx4 (soft, SSSE3)", [&]() { fillAes1Rx4Vec128<true>(state, randomx::ScratchpadSize, scratchpad); });
+		aesBenchmarkRun("hashAes1Rx4 (soft, SSSE3)", [&]() { hashAes1Rx4Vec128<true>(scratchpad, randomx::ScratchpadSize, hash); });
+		if (randomx::cpu.hasAvx2()) {
+			aesBenchmarkRun("fillAes1Rx4 (soft, AVX2)", [&]() { fillAes1Rx4_soft_avx2(state, randomx::ScratchpadSize, scratchpad); });
+			aesBenchmarkRun("hashAes1Rx4 (soft, AVX2)", [&]() { hashAes1Rx4_soft_avx2(scratchpad, randomx::ScratchpadSize, hash); });
+		}
+	}
+#endif
+	randomx::setSoftAesImpl(impl);
+}
+
 int main(int argc, char** argv) {
 	bool softAes, miningMode, verificationMode, help, largePages, jit, secure, commit, v2;
-	bool ssse3, avx2, autoFlags, noBatch;
-	int noncesCount, threadCount, initThreadCount;
+	bool ssse3, avx2, avx512, autoFlags, noBatch, numa, verifyServiceMode, lazy, aes, aesTable, vaes;
+	int noncesCount, threadCount, initThreadCount, batchSize;
 	uint64_t threadAffinity;
 	int32_t seedValue;
+	const char* datasetFile;
+	const char* cacheFile;
 	char seed[4];
 
 	readOption("--softAes", argc, argv, softAes);
@@ -175,10 +380,24 @@ int main(int argc, char** argv) {
 	readOption("--secure", argc, argv, secure);
 	readOption("--ssse3", argc, argv, ssse3);
 	readOption("--avx2", argc, argv, avx2);
+	readOption("--avx512", argc, argv, avx512);
 	readOption("--auto", argc, argv, autoFlags);
 	readOption("--noBatch", argc, argv, noBatch);
+	readIntOption("--batch", argc, argv, batchSize, 0);
+	readStringOption("--dataset", argc, argv, datasetFile, nullptr);
+	readStringOption("--cache", argc, argv, cacheFile, nullptr);
 	readOption("--commit", argc, argv, commit);
 	readOption("--v2", argc, argv, v2);
+	readOption("--numa", argc, argv, numa);
+	readOption("--verify-service", argc, argv, verifyServiceMode);
+	readOption("--lazy", argc, argv, lazy);
+	readOption("--aes", argc, argv, aes);
+	readOption("--aesTable", argc, argv, aesTable);
+	readOption("--vaes", argc, argv, vaes);
+	if (verifyServiceMode) {
+		verificationMode = true;
+		miningMode = false;
+	}
 
 	store32(&seed, seedValue);
 
@@ -189,18 +408,33 @@ int main(int argc, char** argv) {
 		return 0;
 	}
 
+	if (aesTable) {
+		randomx::setSoftAesImpl(randomx::SoftAesImpl::Table);
+	}
+
+	if (aes) {
+		aesBenchmark();
+		return 0;
+	}
+
 	if (!miningMode && !verificationMode) {
 		std::cout << "Please select either the fast mode (--mine) or the slow mode (--verify)" << std::endl;
 		std::cout << "Run '" << argv[0] << " --help' to see all supported options" << std::endl;
 		return 0;
 	}
 
+	if (miningMode && numa && datasetFile != nullptr) {
+		std::cout << "--numa cannot be combined with --dataset" << std::endl;
+		return 1;
+	}
+
 	std::atomic<uint32_t> atomicNonce(0);
 	AtomicHash result;
 	std::vector<randomx_vm*> vms;
+	std::vector<randomx_dataset*> datasets;
 	std::vector<std::thread> threads;
-	randomx_dataset* dataset;
-	randomx_cache* cache;
+	randomx_dataset* dataset = nullptr;
+	randomx_cache* cache = nullptr;
 	randomx_flags flags;
 
 	if (autoFlags) {
@@ -215,6 +449,9 @@ int main(int argc, char** argv) {
 		if (avx2) {
 			flags |= RANDOMX_FLAG_ARGON2_AVX2;
 		}
+		if (avx512) {
+			flags |= RANDOMX_FLAG_ARGON2_AVX512;
+		}
 		if (!softAes) {
 			flags |= RANDOMX_FLAG_HARD_AES;
 		}
@@ -242,7 +479,23 @@ int main(int argc, char** argv) {
 		flags |= RANDOMX_FLAG_V2;
 	}
 
-	if (flags & RANDOMX_FLAG_ARGON2_AVX2) {
+	if (vaes) {
+		flags |= RANDOMX_FLAG_VAES;
+	}
+
+	if (*randomx::cpu.getVendor() != '\0') {
+		std::cout << " - CPU: " << randomx::cpu.getVendor() << " family " << randomx::cpu.getFamily() << " model " << randomx::cpu.getModel() << std::endl;
+	}
+	std::cout << " - kernels: AES " << randomx_get_kernel_name(RANDOMX_KERNEL_AES, flags);
+	std::cout << ", soft AES " << randomx_get_kernel_name(RANDOMX_KERNEL_SOFT_AES, flags);
+	std::cout << ", Blake2b " << randomx_get_kernel_name(RANDOMX_KERNEL_BLAKE2B, flags);
+	std::cout << ", Argon2 " << randomx_get_kernel_name(RANDOMX_KERNEL_ARGON2, flags);
+	std::cout << ", superscalar " << randomx_get_kernel_name(RANDOMX_KERNEL_SUPERSCALAR, flags) << std::endl;
+
+	if (flags & RANDOMX_FLAG_ARGON2_AVX512) {
+		std::cout << " - Argon2 implementation: AVX-512" << std::endl;
+	}
+	else if (flags & RANDOMX_FLAG_ARGON2_AVX2) {
 		std::cout << " - Argon2 implementation: AVX2" << std::endl;
 	}
 	else if (flags & RANDOMX_FLAG_ARGON2_SSSE3) {
@@ -273,8 +526,11 @@ int main(int argc, char** argv) {
 	if (flags & RANDOMX_FLAG_HARD_AES) {
 		std::cout << " - hardware AES mode" << std::endl;
 	}
+	else if (randomx::getSoftAesImpl() == randomx::SoftAesImpl::Vperm) {
+		std::cout << " - software AES mode (constant-time)" << std::endl;
+	}
 	else {
-		std::cout << " - software AES mode" << std::endl;
+		std::cout << " - software AES mode (tables)" << std::endl;
 	}
 
 	if (flags & RANDOMX_FLAG_LARGE_PAGES) {
@@ -285,12 +541,44 @@ int main(int argc, char** argv) {
 	}
 
 	if (threadAffinity) {
-		std::cout << " - thread affinity (" << mask_to_string(threadAffinity) << ")" << std::endl;
+		std::cout << " - thread affinity (" << randomx::mask_to_string(threadAffinity) << ")" << std::endl;
+	}
+
+	if (miningMode && lazy) {
+		std::cout << " - lazy dataset (" << initThreadCount << " filler thread" << (initThreadCount > 1 ? "s)" : ")") << std::endl;
+		numa = false;
 	}
 
-	MineFunc* func;
+	//one replica per node that has memory, CPUs of memoryless nodes use the first replica
+	std::vector<unsigned> numaNodes;
+	if (miningMode && numa) {
+		for (unsigned node = 0; node < randomx_numa_node_count(); ++node) {
+			if (randomx_numa_node_has_memory(node)) {
+				numaNodes.push_back(node);
+			}
+		}
+		if (numaNodes.empty()) {
+			numaNodes.push_back(0);
+		}
+		std::cout << " - NUMA mode (" << numaNodes.size() << " node" << (numaNodes.size() > 1 ? "s)" : ")") << std::endl;
+	}
+
+	MineFunc* func = nullptr;
 
-	if (noBatch) {
+	if (verifyServiceMode) {
+		std::cout << " - verification service (" << threadCount << " worker" << (threadCount > 1 ? "s)" : ")") << std::endl;
+	}
+	else if (batchSize > 0) {
+		std::cout << " - batch mode (" << batchSize << " inputs per call)" << std::endl;
+		if (commit) {
+			std::cout << " - hash commitments" << std::endl;
+			func = &mineArray<true>;
+		}
+		else {
+			func = &mineArray<false>;
+		}
+	}
+	else if (noBatch) {
 		if (commit) {
 			std::cout << " - hash commitments" << std::endl;
 			func = &mine<false, true>;
@@ -312,7 +600,7 @@ int main(int argc, char** argv) {
 	}
 
 	std::cout << "Initializing";
-	if (miningMode)
+	if (miningMode && !lazy)
 		std::cout << " (" << initThreadCount << " thread" << (initThreadCount > 1 ? "s)" : ")");
 	std::cout << " ..." << std::endl;
 
@@ -326,43 +614,84 @@ int main(int argc, char** argv) {
 		if (!(flags & RANDOMX_FLAG_JIT) && RANDOMX_HAVE_COMPILER) {
 			std::cout << "WARNING: You are using the interpreter mode. Use --jit for optimal performance." << std::endl;
 		}
+		if (verifyServiceMode) {
+			verifyService(flags, seed, sizeof(seed), result, noncesCount, threadCount);
+			if (noncesCount == 1000 && seedValue == 0) {
+				const char* r = v2 ? "b85d79e080b10b6ad28c2e6c993601a1361917dba979e03a0a8f7248aaf4ba52" : "10b649a3f15c7c7f88277812f2e74b337a0f20ce909af09199cccb960771cfa1";
+				std::cout << "Reference result:  " << r << std::endl;
+			}
+			return 0;
+		}
 
 		Stopwatch sw(true);
-		cache = randomx_alloc_cache(flags);
-		if (cache == nullptr) {
-			throw CacheAllocException();
+		if (miningMode && datasetFile != nullptr && !numa && !lazy) {
+			dataset = randomx_load_dataset(flags, &seed, sizeof(seed), datasetFile);
+			if (dataset != nullptr) {
+				std::cout << " - dataset loaded from " << datasetFile << std::endl;
+			}
+		}
+		if (dataset == nullptr && cacheFile != nullptr) {
+			cache = randomx_load_cache(flags, &seed, sizeof(seed), cacheFile);
+			if (cache != nullptr) {
+				std::cout << " - cache loaded from " << cacheFile << std::endl;
+			}
+		}
+		if (dataset == nullptr && cache == nullptr) {
+			cache = randomx_alloc_cache(flags);
+			if (cache == nullptr) {
+				throw CacheAllocException();
+			}
+			Stopwatch cacheSw(true);
+			randomx_init_cache(cache, &seed, sizeof(seed));
+			std::cout << " - cache initialized in " << cacheSw.getElapsed() << " s" << std::endl;
+			if (cacheFile != nullptr && !randomx_save_cache(cache, cacheFile)) {
+				std::cout << "WARNING: Failed to save the cache to " << cacheFile << std::endl;
+			}
 		}
-		randomx_init_cache(cache, &seed, sizeof(seed));
-		if (miningMode) {
-			dataset = randomx_alloc_dataset(flags);
+		if (miningMode && dataset == nullptr) {
+			dataset = numa ? randomx_alloc_dataset_numa(flags, numaNodes[0]) : randomx_alloc_dataset(flags);
 			if (dataset == nullptr) {
 				throw DatasetAllocException();
 			}
-			uint32_t datasetItemCount = randomx_dataset_item_count();
-			if (initThreadCount > 1) {
-				auto perThread = datasetItemCount / initThreadCount;
-				auto remainder = datasetItemCount % initThreadCount;
-				uint32_t startItem = 0;
-				for (int i = 0; i < initThreadCount; ++i) {
-					auto count = perThread + (i == initThreadCount - 1 ? remainder : 0);
-					threads.push_back(std::thread(&randomx_init_dataset, dataset, cache, startItem, count));
-					startItem += count;
-				}
-				for (unsigned i = 0; i < threads.size(); ++i) {
-					threads[i].join();
+			if (lazy) {
+				if (!randomx_init_dataset_lazy(dataset, cache)) {
+					throw DatasetAllocException();
 				}
+				//light virtual machines calculate the items they read
+				flags = (randomx_flags)(flags & ~RANDOMX_FLAG_FULL_MEM);
 			}
 			else {
-				randomx_init_dataset(dataset, cache, 0, datasetItemCount);
+				randomx_init_dataset_parallel(dataset, cache, initThreadCount, threadAffinity);
+				if (datasetFile != nullptr && !randomx_save_dataset(dataset, &seed, sizeof(seed), datasetFile)) {
+					std::cout << "WARNING: Failed to save the dataset to " << datasetFile << std::endl;
+				}
+				randomx_release_cache(cache);
+				cache = nullptr;
+			}
+		}
+		if (miningMode && numa) {
+			datasets.assign(randomx_numa_node_count(), dataset);
+			for (unsigned i = 1; i < numaNodes.size(); ++i) {
+				randomx_dataset* replica = randomx_alloc_dataset_numa(flags, numaNodes[i]);
+				if (replica == nullptr) {
+					throw DatasetAllocException();
+				}
+				datasets[numaNodes[i]] = replica;
+				memcpy(randomx_get_dataset_memory(replica), randomx_get_dataset_memory(dataset), randomx_dataset_item_count() * RANDOMX_DATASET_ITEM_SIZE);
 			}
-			randomx_release_cache(cache);
-			cache = nullptr;
-			threads.clear();
 		}
 		std::cout << "Memory initialized in " << sw.getElapsed() << " s" << std::endl;
 		std::cout << "Initializing " << threadCount << " virtual machine(s) ..." << std::endl;
 		for (int i = 0; i < threadCount; ++i) {
-			randomx_vm *vm = randomx_create_vm(flags, cache, dataset);
+			randomx_dataset* vmDataset = dataset;
+			if (miningMode && numa) {
+				unsigned cpu = threadAffinity ? randomx::cpuid_from_mask(threadAffinity, i) : i;
+				unsigned node = randomx_numa_node_of_cpu(cpu);
+				if (node < datasets.size()) {
+					vmDataset = datasets[node];
+				}
+			}
+			randomx_vm *vm = randomx_create_vm(flags, cache, vmDataset);
 			if (vm == nullptr) {
 				if ((flags & RANDOMX_FLAG_HARD_AES)) {
 					throw std::runtime_error("Cannot create VM with the selected options. Try using --softAes");
@@ -374,29 +703,62 @@ int main(int argc, char** argv) {
 			}
 			vms.push_back(vm);
 		}
+		std::cout << " - page size:";
+		if (cache != nullptr) {
+			std::cout << " cache " << pageSizeToString(randomx_get_cache_page_size(cache)) << ",";
+		}
+		if (dataset != nullptr) {
+			std::cout << " dataset " << pageSizeToString(randomx_get_dataset_page_size(dataset)) << ",";
+		}
+		std::cout << " scratchpad " << pageSizeToString(randomx_get_scratchpad_page_size(vms[0])) << std::endl;
 		std::cout << "Running benchmark (" << noncesCount << " nonces) ..." << std::endl;
 		sw.restart();
+		std::vector<std::thread> fillers;
+		std::atomic<bool> fillersStop(false);
+		if (miningMode && lazy) {
+			auto filler = [dataset, &fillersStop](unsigned thread, unsigned threads) {
+				const unsigned long chunk = 4096;
+				const unsigned long itemCount = randomx_dataset_item_count();
+				for (unsigned long item = thread * chunk; item < itemCount && !fillersStop.load(); item += threads * chunk) {
+					randomx_fill_dataset_lazy(dataset, item, std::min(chunk, itemCount - item));
+				}
+			};
+			for (int i = 0; i < initThreadCount; ++i) {
+				fillers.push_back(std::thread(filler, i, initThreadCount));
+			}
+		}
 		if (threadCount > 1) {
 			for (unsigned i = 0; i < vms.size(); ++i) {
 				int cpuid = -1;
 				if (threadAffinity)
-					cpuid = cpuid_from_mask(threadAffinity, i);
-				threads.push_back(std::thread(func, vms[i], std::ref(atomicNonce), std::ref(result), noncesCount, i, cpuid));
+					cpuid = randomx::cpuid_from_mask(threadAffinity, i);
+				threads.push_back(std::thread(func, vms[i], std::ref(atomicNonce), std::ref(result), noncesCount, batchSize, i, cpuid));
 			}
 			for (unsigned i = 0; i < threads.size(); ++i) {
 				threads[i].join();
 			}
 		}
 		else {
-			func(vms[0], std::ref(atomicNonce), std::ref(result), noncesCount, 0, -1);
+			func(vms[0], std::ref(atomicNonce), std::ref(result), noncesCount, batchSize, 0, -1);
 		}
 
 		double elapsed = sw.getElapsed();
+		fillersStop.store(true);
+		for (unsigned i = 0; i < fillers.size(); ++i) {
+			fillers[i].join();
+		}
+		if (miningMode && lazy) {
+			std::cout << "Dataset items ready: " << 100.0 * randomx_dataset_lazy_ready_count(dataset) / randomx_dataset_item_count() << "%" << std::endl;
+		}
 		for (unsigned i = 0; i < vms.size(); ++i)
 			randomx_destroy_vm(vms[i]);
-		if (miningMode)
+		if (miningMode && numa) {
+			for (unsigned i = 0; i < numaNodes.size(); ++i)
+				randomx_release_dataset(datasets[numaNodes[i]]);
+		}
+		else if (miningMode)
 			randomx_release_dataset(dataset);
-		else
+		if (cache != nullptr)
 			randomx_release_cache(cache);
 		std::cout << "Calculated result: ";
 		result.print(std::cout);
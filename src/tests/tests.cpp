@@ -4,6 +4,9 @@
 
 #include <cassert>
 #include <iomanip>
+#include <cstdio>
+#include <chrono>
+#include <thread>
 #include "utility.hpp"
 #include "../bytecode_machine.hpp"
 #include "../dataset.hpp"
@@ -15,7 +18,14 @@
 #include "../intrin_portable.h"
 #include "../jit_compiler.hpp"
 #include "../aes_hash.hpp"
+#include "../aes_hash_vaes.hpp"
+#include "../soft_aes.h"
+#include "../cpu.hpp"
+#include "../dispatch.hpp"
 #include "../virtual_machine.hpp"
+#include "../virtual_memory.h"
+#include "../dataset_file.hpp"
+#include "../verify_service.hpp"
 
 randomx_cache* cache;
 randomx_vm* vm = nullptr;
@@ -52,6 +62,40 @@ void calcHexHash(const char(&key)[K], const char(&hex)[H], void* output) {
 	randomx_calculate_hash(vm, input, sizeof(input), output);
 }
 
+static std::string tempFilePath(const char* name) {
+#ifdef _WIN32
+	const char* dir = getenv("TEMP");
+#else
+	const char* dir = getenv("TMPDIR");
+#endif
+	if (dir == nullptr || *dir == '\0')
+		dir = "/tmp";
+	return std::string(dir) + "/" + name;
+}
+
+struct CountingAllocator {
+	size_t allocated[4] = {};
+	size_t live = 0;
+};
+
+static void* countingAlloc(void* userData, size_t size, size_t alignment, randomx_memory_kind kind) {
+	CountingAllocator* counter = (CountingAllocator*)userData;
+	void* ptr = kind == RANDOMX_MEMORY_JIT ? allocMemoryPages(size) : rx_aligned_alloc(size, alignment);
+	assert(ptr != nullptr && (uintptr_t)ptr % alignment == 0);
+	counter->allocated[kind] += size;
+	counter->live++;
+	return ptr;
+}
+
+static void countingFree(void* userData, void* ptr, size_t size, randomx_memory_kind kind) {
+	CountingAllocator* counter = (CountingAllocator*)userData;
+	if (kind == RANDOMX_MEMORY_JIT)
+		freePagedMemory(ptr, size);
+	else
+		rx_aligned_free(ptr);
+	counter->live--;
+}
+
 int testNo = 0;
 int skipped = 0;
 
@@ -87,6 +131,80 @@ int main() {
 		assert(cacheMemory[33554431] == 0x1f47f056d05cd99b);
 	});
 
+	runTest("Kernel dispatch", true, []() {
+		const randomx::DispatchTable& table = randomx::getDispatchTable();
+		assert(&table == &randomx::getDispatchTable());
+		for (int i = 0; i < RANDOMX_KERNEL_COUNT; ++i) {
+			assert(randomx_get_kernel_name((randomx_kernel)i, randomx_get_flags()) != nullptr);
+		}
+		assert(randomx_get_kernel_name(RANDOMX_KERNEL_COUNT, randomx_get_flags()) == nullptr);
+		assert(stringsEqual(randomx_get_kernel_name(RANDOMX_KERNEL_SUPERSCALAR, RANDOMX_FLAG_DEFAULT), "interpreter"));
+		assert(stringsEqual(randomx_get_kernel_name(RANDOMX_KERNEL_ARGON2, RANDOMX_FLAG_DEFAULT), "reference"));
+		for (randomx_flags argon2Flag : { RANDOMX_FLAG_ARGON2_SSSE3, RANDOMX_FLAG_ARGON2_AVX2, RANDOMX_FLAG_ARGON2_AVX512 }) {
+			bool unsupported = strcmp(randomx_get_kernel_name(RANDOMX_KERNEL_ARGON2, argon2Flag), "unsupported") == 0;
+			assert(unsupported == !(table.argon2Flags & argon2Flag));
+		}
+		assert(table.argon2 == randomx::selectArgonImpl(randomx_get_flags()));
+		assert(table.blake2bCompress == randomx_blake2b_select_compress());
+		assert((table.hardAes.hashAes1Rx4 != nullptr) == randomx::cpu.hasVaes());
+		assert(strcmp(randomx_get_kernel_name(RANDOMX_KERNEL_AES, RANDOMX_FLAG_HARD_AES), "VAES") != 0);
+		assert((strcmp(randomx_get_kernel_name(RANDOMX_KERNEL_AES, RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_VAES), "VAES") == 0) == randomx::cpu.hasVaes());
+		assert(!randomx::cpu.hasAvx512() || randomx::cpu.hasAvx512F());
+	});
+
+	runTest("Blake2b compression (SIMD)", (randomx::cpu.hasSse41() && randomx_blake2b_compress_sse41() != nullptr) || (randomx::cpu.hasAvx2() && randomx_blake2b_compress_avx2() != nullptr), []() {
+		randomx_blake2b_compress_fn* compress[2] = {
+			randomx::cpu.hasSse41() ? randomx_blake2b_compress_sse41() : nullptr,
+			randomx::cpu.hasAvx2() ? randomx_blake2b_compress_avx2() : nullptr,
+		};
+		blake2b_state states[2];
+		uint8_t block[BLAKE2B_BLOCKBYTES] = { 'a', 'b', 'c' };
+		for (int i = 0; i < 2; ++i) {
+			if (compress[i] == nullptr)
+				continue;
+			blake2b_state& S = states[i];
+			blake2b_init(&S, BLAKE2B_OUTBYTES);
+			S.t[0] = 3;
+			S.f[0] = (uint64_t)-1;
+			compress[i](&S, block);
+			assert(equalsHex(S.h, "ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d17d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923"));
+		}
+		if (compress[0] == nullptr || compress[1] == nullptr)
+			return;
+		randomx::Blake2Generator gen("test key 000", 12);
+		for (int i = 0; i < 1000; ++i) {
+			uint64_t* words = (uint64_t*)&states[0];
+			for (unsigned j = 0; j < 12; ++j)
+				words[j] = gen.getUInt32() | (uint64_t)gen.getUInt32() << 32;
+			for (unsigned j = 0; j < sizeof(block); ++j)
+				block[j] = gen.getByte();
+			states[1] = states[0];
+			compress[0](&states[0], block);
+			compress[1](&states[1], block);
+			assert(memcmp(states[0].h, states[1].h, sizeof(states[0].h)) == 0);
+		}
+	});
+
+	runTest("Blake2b 4-way", true, []() {
+		uint8_t input[4][300];
+		uint8_t hash4[4][64], hash[64];
+		randomx::Blake2Generator gen("test key 000", 12);
+		for (unsigned i = 0; i < 4; ++i)
+			for (unsigned j = 0; j < sizeof(input[i]); ++j)
+				input[i][j] = gen.getByte();
+		void* const out[4] = { hash4[0], hash4[1], hash4[2], hash4[3] };
+		const void* const in[4] = { input[0], input[1], input[2], input[3] };
+		for (size_t inlen = 0; inlen <= sizeof(input[0]); inlen += 7) {
+			for (size_t outlen : { 32, 64 }) {
+				assert(blake2b_4way(out, outlen, in, inlen) == 0);
+				for (unsigned i = 0; i < 4; ++i) {
+					blake2b(hash, outlen, input[i], inlen, nullptr, 0);
+					assert(memcmp(hash, hash4[i], outlen) == 0);
+				}
+			}
+		}
+	});
+
 	runTest("SuperscalarHash generator", RANDOMX_SUPERSCALAR_LATENCY == 170, []() {
 		alignas(16) char sprogHash[32];
 		randomx::SuperscalarProgram sprog;
@@ -147,6 +265,18 @@ int main() {
 		assert(datasetItem[0] == 0x145a5091f7853099);
 	});
 
+	runTest("Dataset initialization (interpreter, interleaved)", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		initCache("test key 000");
+		alignas(16) uint64_t items[8 * 5];
+		alignas(16) uint64_t reference[8];
+		randomx::initDataset(cache, (uint8_t*)items, 9999999, 10000004);
+		for (unsigned i = 0; i < 5; ++i) {
+			randomx::initDatasetItem(cache, (uint8_t*)reference, 9999999 + i);
+			assert(memcmp(items + 8 * i, reference, sizeof(reference)) == 0);
+		}
+		assert(items[8] == 0x7943a1f6186ffb72);
+	});
+
 	runTest("Dataset initialization (compiler)", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
 		initCache("test key 000");
 		randomx::JitCompiler jit;
@@ -168,6 +298,264 @@ int main() {
 		assert(datasetItem[0] == 0x145a5091f7853099);
 	});
 
+	runTest("Dataset initialization (compiler, ranges)", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		initCache("test key 000");
+		randomx::JitCompiler jit;
+		jit.generateSuperscalarHash(cache->programs, cache->reciprocalCache);
+		jit.generateDatasetInitCode();
+#ifdef RANDOMX_FORCE_SECURE
+		jit.enableExecution();
+#else
+		jit.enableAll();
+#endif
+		constexpr uint32_t maxCount = 19;
+		alignas(64) uint64_t items[8 * (maxCount + 1)];
+		alignas(64) uint64_t reference[8];
+		for (uint32_t startItem : { 0u, 13u, 33554420u }) {
+			for (uint32_t count = 1; count <= maxCount; ++count) {
+				memset(items, 0xcc, sizeof(items));
+				jit.getDatasetInitFunc()(cache, (uint8_t*)items, startItem, startItem + count);
+				for (uint32_t i = 0; i < count; ++i) {
+					randomx::initDatasetItem(cache, (uint8_t*)reference, startItem + i);
+					assert(memcmp(items + 8 * i, reference, sizeof(reference)) == 0);
+				}
+				assert(items[8 * count] == 0xccccccccccccccccULL);
+			}
+		}
+	});
+
+	runTest("NUMA dataset allocation", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		initCache("test key 000");
+		unsigned nodeCount = randomx_numa_node_count();
+		assert(nodeCount >= 1);
+		assert(randomx_numa_node_of_cpu(0) < nodeCount);
+		assert(randomx_alloc_dataset_numa(RANDOMX_FLAG_DEFAULT, nodeCount) == nullptr);
+		assert(!randomx_numa_node_has_memory(nodeCount));
+		unsigned node = nodeCount - 1;
+		while (node > 0 && !randomx_numa_node_has_memory(node))
+			--node;
+		assert(randomx_numa_node_has_memory(node));
+		randomx_dataset* dataset = randomx_alloc_dataset_numa(RANDOMX_FLAG_DEFAULT, node);
+		assert(dataset != nullptr);
+		randomx_init_dataset(dataset, cache, 0, 1);
+		assert(*(uint64_t*)randomx_get_dataset_memory(dataset) == 0x680588a85ae222db);
+		randomx_release_dataset(dataset);
+	});
+
+	runTest("Epoch manager (abort)", true, []() {
+		randomx_epoch_manager* manager = randomx_create_epoch_manager(RANDOMX_FLAG_DEFAULT, 1, 0);
+		assert(manager != nullptr);
+		assert(randomx_epoch_manager_get_dataset(manager) == nullptr);
+		assert(!randomx_epoch_manager_switch(manager));
+		assert(randomx_epoch_manager_prepare(manager, "test key 000", 12));
+		assert(randomx_epoch_manager_prepare(manager, "test key 001", 12));
+		randomx_destroy_epoch_manager(manager);
+	});
+
+	runTest("Epoch manager", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const randomx_flags flags = randomx_get_flags();
+		randomx_epoch_manager* manager = randomx_create_epoch_manager(flags, 0, 0);
+		assert(manager != nullptr);
+		assert(randomx_epoch_manager_prepare(manager, "test key 000", 12));
+		assert(randomx_epoch_manager_switch(manager));
+		randomx_dataset* dataset0 = randomx_epoch_manager_get_dataset(manager);
+		assert(dataset0 != nullptr);
+		randomx_vm* fastVm = randomx_create_vm(flags | RANDOMX_FLAG_FULL_MEM, nullptr, dataset0);
+		assert(fastVm != nullptr);
+		randomx_epoch_manager_register_vm(manager, fastVm);
+		alignas(16) char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(fastVm, "This is a test", 14, hash);
+		assert(equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+
+		assert(randomx_epoch_manager_prepare(manager, "test key 001", 12));
+		while (!randomx_epoch_manager_is_ready(manager)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		assert(randomx_epoch_manager_switch(manager));
+		randomx_dataset* dataset1 = randomx_epoch_manager_get_dataset(manager);
+		assert(dataset1 != nullptr && dataset1 != dataset0);
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		randomx_calculate_hash(fastVm, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "e9ff4503201c0c2cca26d285c93ae883f9b1d30c9eb240b820756f2d5a7905fc"));
+
+		randomx_epoch_manager_unregister_vm(manager, fastVm);
+		randomx_destroy_vm(fastVm);
+		randomx_destroy_epoch_manager(manager);
+	});
+
+	runTest("Cache manager", RANDOMX_ARGON_MEMORY == 262144 && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx_cache_manager* manager = randomx_create_cache_manager(RANDOMX_FLAG_DEFAULT, 2);
+		assert(manager != nullptr);
+		assert(randomx_cache_manager_try_acquire(manager, "test key 000", 12) == nullptr);
+		randomx_cache* cache0 = randomx_cache_manager_acquire(manager, "test key 000", 12);
+		assert(cache0 != nullptr);
+		assert(((uint64_t*)randomx_get_cache_memory(cache0))[1568413] == 0xf1b62fe6210bf8b1);
+		assert(randomx_cache_manager_try_acquire(manager, "test key 000", 12) == cache0);
+		randomx_cache_manager_release(manager, cache0);
+		randomx_cache_manager_release(manager, cache0);
+
+		randomx_cache_manager_prefetch(manager, "test key 001", 12);
+		randomx_cache* cache1 = randomx_cache_manager_acquire(manager, "test key 001", 12);
+		assert(cache1 != nullptr && cache1 != cache0);
+		assert(randomx_cache_manager_try_acquire(manager, "test key 000", 12) == cache0);
+		randomx_cache_manager_release(manager, cache0);
+
+		//"test key 000" is the least recently used cache
+		randomx_cache* cache2 = randomx_cache_manager_acquire(manager, "test key 002", 12);
+		assert(cache2 != nullptr);
+		assert(randomx_cache_manager_try_acquire(manager, "test key 000", 12) == nullptr);
+		randomx_cache_manager_release(manager, cache1);
+		randomx_cache_manager_release(manager, cache2);
+		randomx_destroy_cache_manager(manager);
+	});
+
+	runTest("Cache save and load", RANDOMX_ARGON_ITERATIONS == 3 && RANDOMX_ARGON_LANES == 1 && RANDOMX_ARGON_MEMORY == 262144 && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char key[] = "test key 000";
+		const std::string file = tempFilePath("randomx-test-cache.bin");
+		const char* path = file.c_str();
+		initCache("test key 000");
+		assert(randomx_save_cache(cache, path));
+
+		assert(randomx_load_cache(RANDOMX_FLAG_DEFAULT, "test key 001", sizeof(key) - 1, path) == nullptr);
+		randomx_cache* loaded = randomx_load_cache(RANDOMX_FLAG_DEFAULT, key, sizeof(key) - 1, path);
+		assert(loaded != nullptr);
+		uint64_t* cacheMemory = (uint64_t*)randomx_get_cache_memory(loaded);
+		assert(cacheMemory[0] == 0x191e0e1d23c02186);
+		assert(cacheMemory[1568413] == 0xf1b62fe6210bf8b1);
+		assert(cacheMemory[33554431] == 0x1f47f056d05cd99b);
+		alignas(16) uint64_t datasetItem[8];
+		randomx::initDatasetItem(loaded, (uint8_t*)&datasetItem, 0);
+		assert(datasetItem[0] == 0x680588a85ae222db);
+		randomx::initDatasetItem(loaded, (uint8_t*)&datasetItem, 30000000);
+		assert(datasetItem[0] == 0x145a5091f7853099);
+		randomx_release_cache(loaded);
+
+		if (RANDOMX_HAVE_COMPILER) {
+#ifdef RANDOMX_FORCE_SECURE
+			loaded = randomx_load_cache(RANDOMX_FLAG_JIT | RANDOMX_FLAG_SECURE, key, sizeof(key) - 1, path);
+#else
+			loaded = randomx_load_cache(RANDOMX_FLAG_JIT, key, sizeof(key) - 1, path);
+#endif
+			assert(loaded != nullptr);
+			alignas(16) uint64_t datasetItems[32] = {};
+			loaded->datasetInit(loaded, (uint8_t*)&datasetItems, 10000000, 10000001);
+			assert(datasetItems[0] == 0x7943a1f6186ffb72);
+			randomx_release_cache(loaded);
+		}
+		remove(path);
+	});
+
+	runTest("Shared cache", RANDOMX_ARGON_ITERATIONS == 3 && RANDOMX_ARGON_LANES == 1 && RANDOMX_ARGON_MEMORY == 262144 && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char key[] = "test key 000";
+		const char* name = "/randomx-test-cache";
+		randomx_remove_shared(name);
+		assert(randomx_attach_shared_cache(RANDOMX_FLAG_DEFAULT, name, key, sizeof(key) - 1, 0) == nullptr);
+		randomx_cache* created = randomx_create_shared_cache(RANDOMX_FLAG_DEFAULT, name, key, sizeof(key) - 1);
+		assert(created != nullptr);
+		assert(randomx_create_shared_cache(RANDOMX_FLAG_DEFAULT, name, key, sizeof(key) - 1) == nullptr);
+
+		assert(randomx_attach_shared_cache(RANDOMX_FLAG_DEFAULT, name, "test key 001", sizeof(key) - 1, 0) == nullptr);
+		randomx_cache* attached = randomx_attach_shared_cache(RANDOMX_FLAG_DEFAULT, name, key, sizeof(key) - 1, 0);
+		assert(attached != nullptr);
+		assert(randomx_get_cache_memory(attached) != randomx_get_cache_memory(created));
+		uint64_t* cacheMemory = (uint64_t*)randomx_get_cache_memory(attached);
+		assert(cacheMemory[0] == 0x191e0e1d23c02186);
+		assert(cacheMemory[33554431] == 0x1f47f056d05cd99b);
+		alignas(16) uint64_t datasetItem[8];
+		randomx::initDatasetItem(attached, (uint8_t*)&datasetItem, 30000000);
+		assert(datasetItem[0] == 0x145a5091f7853099);
+
+		randomx_vm* sharedVm = randomx_create_vm(RANDOMX_FLAG_DEFAULT, attached, nullptr);
+		assert(sharedVm != nullptr);
+		alignas(16) char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(sharedVm, "This is a test", 14, hash);
+		assert(equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+		randomx_destroy_vm(sharedVm);
+		randomx_release_cache(attached);
+		randomx_release_cache(created);
+
+		assert(randomx_remove_shared(name));
+		assert(!randomx_remove_shared(name));
+		assert(randomx_attach_shared_cache(RANDOMX_FLAG_DEFAULT, name, key, sizeof(key) - 1, 0) == nullptr);
+	});
+
+	runTest("Shared dataset", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char key[] = "test key 000";
+		const char* name = "/randomx-test-dataset";
+		randomx_remove_shared(name);
+		assert(randomx_attach_shared_dataset(name, key, sizeof(key) - 1, 0) == nullptr);
+
+		//publish a segment with a single dataset item instead of initializing the whole dataset
+		initCache("test key 000");
+		uint8_t* segment = randomx::createSharedSegment(name, randomx::DatasetSize);
+		assert(segment != nullptr);
+		assert(randomx_attach_shared_dataset(name, key, sizeof(key) - 1, 10) == nullptr);
+		randomx::initDatasetItem(cache, segment + randomx::FileDataOffset + 10000000 * randomx::CacheLineSize, 10000000);
+		randomx::publishSharedSegment(segment, randomx::FileKind::Dataset, key, sizeof(key) - 1, randomx::DatasetSize);
+
+		assert(randomx_attach_shared_dataset(name, "test key 001", sizeof(key) - 1, 0) == nullptr);
+		randomx_dataset* attached = randomx_attach_shared_dataset(name, key, sizeof(key) - 1, 0);
+		assert(attached != nullptr);
+		uint64_t* datasetMemory = (uint64_t*)randomx_get_dataset_memory(attached);
+		assert(datasetMemory[10000000 * 8] == 0x7943a1f6186ffb72);
+		randomx_release_dataset(attached);
+		randomx::releaseSharedSegment(segment, randomx::DatasetSize);
+		assert(randomx_remove_shared(name));
+	});
+
+	runTest("Dataset initialization (parallel)", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx_cache* jitCache = randomx_alloc_cache(randomx_get_flags());
+		assert(jitCache != nullptr);
+		randomx_init_cache(jitCache, "test key 000", 12);
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		//3 threads share the chunks unevenly and the last chunk is partial
+		randomx_init_dataset_parallel(dataset, jitCache, 3, 0);
+		const uint8_t* datasetMemory = (const uint8_t*)randomx_get_dataset_memory(dataset);
+		assert(*(const uint64_t*)datasetMemory == 0x680588a85ae222db);
+
+		//items on both sides of chunk boundaries (DatasetInitChunkItems in dataset.cpp)
+		constexpr unsigned long chunkItems = 4096;
+		const unsigned long itemCount = randomx_dataset_item_count();
+		assert(itemCount % chunkItems != 0);
+		std::vector<unsigned long> items = { 0, 1, itemCount - 1 };
+		for (unsigned long edge = chunkItems; edge < itemCount; edge += 1009 * chunkItems) {
+			items.push_back(edge - 1);
+			items.push_back(edge);
+		}
+		items.push_back(itemCount / chunkItems * chunkItems - 1);
+		items.push_back(itemCount / chunkItems * chunkItems);
+		for (unsigned long item : items) {
+			uint8_t expected[RANDOMX_DATASET_ITEM_SIZE];
+			randomx::initDatasetItem(jitCache, expected, item);
+			assert(memcmp(datasetMemory + item * RANDOMX_DATASET_ITEM_SIZE, expected, sizeof(expected)) == 0);
+		}
+		randomx_release_dataset(dataset);
+		randomx_release_cache(jitCache);
+	});
+
+	runTest("Dataset save and load", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char key[] = "test key 000";
+		const std::string file = tempFilePath("randomx-test-dataset.bin");
+		const char* path = file.c_str();
+		initCache("test key 000");
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		randomx_init_dataset(dataset, cache, 10000000, 1);
+		randomx_init_dataset(dataset, cache, 30000000, 1);
+		assert(randomx_save_dataset(dataset, key, sizeof(key) - 1, path));
+		randomx_release_dataset(dataset);
+
+		assert(randomx_load_dataset(RANDOMX_FLAG_DEFAULT, "test key 001", sizeof(key) - 1, path) == nullptr);
+		dataset = randomx_load_dataset(RANDOMX_FLAG_DEFAULT, key, sizeof(key) - 1, path);
+		assert(dataset != nullptr);
+		uint64_t* datasetMemory = (uint64_t*)randomx_get_dataset_memory(dataset);
+		assert(datasetMemory[10000000 * RANDOMX_DATASET_ITEM_SIZE / sizeof(uint64_t)] == 0x7943a1f6186ffb72);
+		assert(datasetMemory[30000000 * RANDOMX_DATASET_ITEM_SIZE / sizeof(uint64_t)] == 0x145a5091f7853099);
+		randomx_release_dataset(dataset);
+		remove(path);
+	});
+
 	runTest("AesGenerator1R", true, []() {
 		alignas(16) char state[64] = { 0 };
 		hex2bin("6c19536eb2de31b6c0065f7f116e86f960d8af0c57210a6584c3237b9d064dc7", 64, state);
@@ -175,6 +563,92 @@ int main() {
 		assert(equalsHex(state, "fa89397dd6ca422513aeadba3f124b5540324c4ad4b6db434394307a17c833ab"));
 	});
 
+#ifdef RANDOMX_HAVE_VAES
+	runTest("AES hash and fill (VAES)", randomx::cpu.hasVaes(), []() {
+		constexpr size_t size = 64 * 1024;
+		std::vector<uint8_t> buffer1(size), buffer2(size);
+		alignas(16) uint8_t state1[64], state2[64], hash1[64], hash2[64];
+		for (size_t i = 0; i < size; ++i) {
+			buffer1[i] = (uint8_t)(i * 131 + 7);
+		}
+		buffer2 = buffer1;
+		for (unsigned i = 0; i < sizeof(state1); ++i) {
+			state1[i] = state2[i] = (uint8_t)(i * 17 + 1);
+		}
+		hashAes1Rx4Vec128<false>(buffer1.data(), size, hash1);
+		hashAes1Rx4_vaes(buffer2.data(), size, hash2);
+		assert(memcmp(hash1, hash2, sizeof(hash1)) == 0);
+		fillAes1Rx4Vec128<false>(state1, size, buffer1.data());
+		fillAes1Rx4_vaes(state2, size, buffer2.data());
+		assert(buffer1 == buffer2 && memcmp(state1, state2, sizeof(state1)) == 0);
+		fillAes4Rx4Vec128<false>(state1, size, buffer1.data());
+		fillAes4Rx4_vaes(state2, size, buffer2.data());
+		assert(buffer1 == buffer2);
+		hashAndFillAes1Rx4Vec128<false>(buffer1.data(), size, hash1, state1);
+		hashAndFillAes1Rx4_vaes(buffer2.data(), size, hash2, state2);
+		assert(buffer1 == buffer2);
+		assert(memcmp(hash1, hash2, sizeof(hash1)) == 0 && memcmp(state1, state2, sizeof(state1)) == 0);
+	});
+
+	runTest("Hash test (VAES)", randomx::cpu.hasVaes() && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		initCache("test key 000");
+		randomx_vm* vaesVm = randomx_create_vm(RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_VAES, cache, nullptr);
+		assert(vaesVm != nullptr);
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(vaesVm, "This is a test", 14, hash);
+		assert(equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+		randomx_destroy_vm(vaesVm);
+	});
+#endif
+
+#ifdef RANDOMX_HAVE_SOFT_AES_VPERM
+	runTest("Soft AES (vperm)", soft_aes_vperm_supported(), []() {
+		randomx::Blake2Generator gen("test key 000", 12);
+		alignas(16) uint8_t bytes[32];
+		alignas(16) uint8_t out[4][16];
+		for (int i = 0; i < 1000; ++i) {
+			for (unsigned j = 0; j < sizeof(bytes); ++j)
+				bytes[j] = gen.getByte();
+			rx_vec_i128 in = rx_load_vec_i128((rx_vec_i128*)bytes + 0);
+			rx_vec_i128 key = rx_load_vec_i128((rx_vec_i128*)bytes + 1);
+			rx_store_vec_i128((rx_vec_i128*)out[0], soft_aesenc_table(in, key));
+			rx_store_vec_i128((rx_vec_i128*)out[1], soft_aesenc_vperm(in, key));
+			rx_store_vec_i128((rx_vec_i128*)out[2], soft_aesdec_table(in, key));
+			rx_store_vec_i128((rx_vec_i128*)out[3], soft_aesdec_vperm(in, key));
+			assert(memcmp(out[0], out[1], 16) == 0);
+			assert(memcmp(out[2], out[3], 16) == 0);
+		}
+		if (!randomx::cpu.hasAvx2())
+			return;
+		constexpr size_t size = 64 * 1024;
+		std::vector<uint8_t> buffer1(size), buffer2(size);
+		alignas(16) uint8_t state1[64], state2[64], hash1[64], hash2[64];
+		for (size_t i = 0; i < size; ++i) {
+			buffer1[i] = gen.getByte();
+		}
+		buffer2 = buffer1;
+		for (unsigned i = 0; i < sizeof(state1); ++i) {
+			state1[i] = state2[i] = gen.getByte();
+		}
+		randomx::SoftAesImpl impl = randomx::getSoftAesImpl();
+		randomx::setSoftAesImpl(randomx::SoftAesImpl::Table);
+		hashAes1Rx4Vec128<true>(buffer1.data(), size, hash1);
+		hashAes1Rx4_soft_avx2(buffer2.data(), size, hash2);
+		assert(memcmp(hash1, hash2, sizeof(hash1)) == 0);
+		fillAes1Rx4Vec128<true>(state1, size, buffer1.data());
+		fillAes1Rx4_soft_avx2(state2, size, buffer2.data());
+		assert(buffer1 == buffer2 && memcmp(state1, state2, sizeof(state1)) == 0);
+		fillAes4Rx4Vec128<true>(state1, size, buffer1.data());
+		fillAes4Rx4_soft_avx2(state2, size, buffer2.data());
+		assert(buffer1 == buffer2);
+		hashAndFillAes1Rx4Vec128<true>(buffer1.data(), size, hash1, state1);
+		hashAndFillAes1Rx4_soft_avx2(buffer2.data(), size, hash2, state2);
+		assert(buffer1 == buffer2);
+		assert(memcmp(hash1, hash2, sizeof(hash1)) == 0 && memcmp(state1, state2, sizeof(state1)) == 0);
+		randomx::setSoftAesImpl(impl);
+	});
+#endif
+
 	randomx::NativeRegisterFile reg;
 	randomx::BytecodeMachine decoder;
 	randomx::InstructionByteCode ibc;
@@ -1008,6 +1482,93 @@ int main() {
 	runTest("Hash test 1d (interpreter)", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), test_d);
 	runTest("Hash test 1e (interpreter)", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), test_e);
 
+	runTest("Page size", true, []() {
+		assert(randomx_get_cache_page_size(cache) == getPageSize());
+		assert(randomx_get_scratchpad_page_size(vm) == getPageSize());
+		randomx_cache* largePageCache = randomx_alloc_cache(RANDOMX_FLAG_LARGE_PAGES);
+		assert(largePageCache != nullptr);
+		assert(randomx_get_cache_page_size(largePageCache) % getPageSize() == 0);
+		randomx_release_cache(largePageCache);
+		randomx_vm* largePageVm = randomx_create_vm(vm->getFlags() | RANDOMX_FLAG_LARGE_PAGES, cache, nullptr);
+		assert(largePageVm != nullptr);
+		assert(randomx_get_scratchpad_page_size(largePageVm) % getPageSize() == 0);
+		randomx_destroy_vm(largePageVm);
+	});
+
+	runTest("Transparent huge pages", true, []() {
+		size_t pageSize;
+		const size_t size = randomx::ScratchpadSize + 4096;
+		uint8_t* mem = (uint8_t*)allocTransparentHugePagesMemory(size, &pageSize, 1);
+		if (mem == nullptr)
+			return;
+		//the kernel may not find free huge pages, the reported size is the one backing the memory
+		assert(pageSize == getPageSize() || pageSize >= 2 * 1024 * 1024);
+		assert((uintptr_t)mem % pageSize == 0);
+		for (size_t i = 0; i < size; i += 4096) {
+			assert(mem[i] == 0);
+			mem[i] = 1;
+		}
+		freePagedMemory(mem, size);
+	});
+
+	runTest("User allocator", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		CountingAllocator counter;
+		randomx_allocator allocator = { &countingAlloc, &countingFree, &counter };
+		randomx_flags flags = randomx_get_flags();
+		randomx_cache* userCache = randomx_alloc_cache_ex(flags, &allocator);
+		assert(userCache != nullptr);
+		assert(randomx_get_cache_page_size(userCache) == 0);
+		randomx_init_cache(userCache, "test key 000", 12);
+		randomx_vm* userVm = randomx_create_vm_ex(flags, userCache, nullptr, &allocator);
+		assert(userVm != nullptr);
+		assert(randomx_get_scratchpad_page_size(userVm) == 0);
+		alignas(16) char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(userVm, "This is a test", 14, hash);
+		assert(equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+		assert(counter.allocated[RANDOMX_MEMORY_CACHE] == randomx::CacheSize);
+		assert(counter.allocated[RANDOMX_MEMORY_SCRATCHPAD] == randomx::ScratchpadSize);
+		assert((counter.allocated[RANDOMX_MEMORY_JIT] != 0) == ((flags & RANDOMX_FLAG_JIT) != 0));
+		randomx_destroy_vm(userVm);
+		randomx_release_cache(userCache);
+		randomx_dataset* userDataset = randomx_alloc_dataset_ex(RANDOMX_FLAG_DEFAULT, &allocator);
+		assert(userDataset != nullptr);
+		assert(counter.allocated[RANDOMX_MEMORY_DATASET] == randomx::DatasetSize);
+		randomx_release_dataset(userDataset);
+		assert(counter.live == 0);
+	});
+
+	runTest("VM pool", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		initCache("test key 000");
+		randomx_vm_pool* pool = randomx_create_vm_pool(randomx_get_flags(), cache, nullptr, 2);
+		assert(pool != nullptr);
+		randomx_vm* vm0 = randomx_vm_pool_acquire(pool);
+		randomx_vm* vm1 = randomx_vm_pool_try_acquire(pool);
+		assert(vm0 != nullptr && vm1 != nullptr && vm0 != vm1);
+		assert(randomx_vm_pool_try_acquire(pool) == nullptr);
+		//the scratchpads are adjacent in the slab
+		const uint8_t* scratchpad0 = (const uint8_t*)vm0->getScratchpad();
+		const uint8_t* scratchpad1 = (const uint8_t*)vm1->getScratchpad();
+		assert(scratchpad0 - scratchpad1 == randomx::ScratchpadSize || scratchpad1 - scratchpad0 == randomx::ScratchpadSize);
+
+		randomx_vm_pool_release(pool, vm1);
+		randomx_vm* vm2 = randomx_vm_pool_acquire(pool);
+		assert(vm2 == vm1);
+		alignas(16) char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(vm2, "This is a test", 14, hash);
+		assert(equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+		randomx_vm_pool_release(pool, vm0);
+		randomx_vm_pool_release(pool, vm2);
+
+		randomx_vm_pool_stats stats;
+		randomx_vm_pool_get_stats(pool, &stats);
+		assert(stats.hits == 3);
+		assert(stats.misses == 1);
+		assert(stats.size == 2);
+		assert(stats.available == 2);
+		assert(stats.pageSize >= getPageSize());
+		randomx_destroy_vm_pool(pool);
+	});
+
 	randomx_destroy_vm(vm);
 
 #ifdef RANDOMX_FORCE_SECURE
@@ -1041,6 +1602,64 @@ int main() {
 	runTest("Hash test 2d (compiler)", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), test_d);
 	runTest("Hash test 2e (compiler)", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), test_e);
 
+	runTest("Hash test 2f (compiler, shared)", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		alignas(16) char hash[RANDOMX_HASH_SIZE];
+		initCache("test key 000");
+#ifdef RANDOMX_FORCE_SECURE
+		randomx_vm* vm2 = randomx_create_vm(RANDOMX_FLAG_JIT | RANDOMX_FLAG_SECURE, cache, nullptr);
+#else
+		randomx_vm* vm2 = randomx_create_vm(RANDOMX_FLAG_JIT, cache, nullptr);
+#endif
+		assert(vm2 != nullptr);
+		const char input[] = "This is a test";
+		randomx_calculate_hash(vm, input, sizeof(input) - 1, &hash);
+		assert(equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+		randomx_calculate_hash(vm2, input, sizeof(input) - 1, &hash);
+		assert(equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+		randomx_destroy_vm(vm2);
+	});
+
+	runTest("Lazy dataset", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		alignas(16) char hash[RANDOMX_HASH_SIZE];
+		alignas(16) char reference[RANDOMX_HASH_SIZE];
+		const char input[] = "This is a test";
+		initCache("test key 000");
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		assert(randomx_init_dataset_lazy(dataset, cache));
+		randomx_fill_dataset_lazy(dataset, 0, 1000);
+		assert(randomx_dataset_lazy_ready_count(dataset) == 1000);
+		assert(((uint64_t*)randomx_get_dataset_memory(dataset))[0] == 0x680588a85ae222db);
+
+		randomx_flags flags[] = { RANDOMX_FLAG_DEFAULT, RANDOMX_FLAG_JIT };
+		for (randomx_flags vmFlags : flags) {
+#ifdef RANDOMX_FORCE_SECURE
+			vmFlags |= RANDOMX_FLAG_SECURE;
+#endif
+			randomx_vm* lazyVm = randomx_create_vm(vmFlags, cache, dataset);
+			assert(lazyVm != nullptr);
+			//the second hash reads the items calculated by the first one
+			for (int i = 0; i < 2; ++i) {
+				randomx_calculate_hash(lazyVm, input, sizeof(input) - 1, &hash);
+				assert(equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+			}
+			randomx_destroy_vm(lazyVm);
+		}
+		unsigned long readyCount = randomx_dataset_lazy_ready_count(dataset);
+		assert(readyCount > 1000);
+
+		//the dataset is ignored after the cache is initialized with another key
+		initCache("test key 001");
+		randomx_vm* lazyVm = randomx_create_vm(flags[1], cache, dataset);
+		assert(lazyVm != nullptr);
+		randomx_calculate_hash(lazyVm, input, sizeof(input) - 1, &hash);
+		randomx_calculate_hash(vm, input, sizeof(input) - 1, &reference);
+		assert(memcmp(hash, reference, sizeof(hash)) == 0);
+		assert(randomx_dataset_lazy_ready_count(dataset) == readyCount);
+		randomx_destroy_vm(lazyVm);
+		randomx_release_dataset(dataset);
+	});
+
 	if (RANDOMX_HAVE_COMPILER) {
 		randomx_destroy_vm(vm);
 
@@ -1057,6 +1676,14 @@ int main() {
 	runTest("Hash test 2d (compiler v2)", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), test_d);
 	runTest("Hash test 2e (compiler v2)", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), test_e);
 
+	runTest("Hash test 2g (compiler v2, table soft AES)", RANDOMX_HAVE_COMPILER && randomx::getSoftAesImpl() != randomx::SoftAesImpl::Table && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), [&] {
+		randomx::SoftAesImpl impl = randomx::getSoftAesImpl();
+		randomx::setSoftAesImpl(randomx::SoftAesImpl::Table);
+		test_a();
+		test_b();
+		randomx::setSoftAesImpl(impl);
+	});
+
 	auto flags = randomx_get_flags();
 
 	randomx_release_cache(cache);
@@ -1082,6 +1709,18 @@ int main() {
 		assert(cacheMemory[33554431] == 0x1f47f056d05cd99b);
 	});
 
+	if (cache != nullptr)
+		randomx_release_cache(cache);
+	cache = randomx_alloc_cache(RANDOMX_FLAG_ARGON2_AVX512);
+
+	runTest("Cache initialization: AVX512", (flags & RANDOMX_FLAG_ARGON2_AVX512) && RANDOMX_ARGON_ITERATIONS == 3 && RANDOMX_ARGON_LANES == 1 && RANDOMX_ARGON_MEMORY == 262144 && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		initCache("test key 000");
+		uint64_t* cacheMemory = (uint64_t*)cache->memory;
+		assert(cacheMemory[0] == 0x191e0e1d23c02186);
+		assert(cacheMemory[1568413] == 0xf1b62fe6210bf8b1);
+		assert(cacheMemory[33554431] == 0x1f47f056d05cd99b);
+	});
+
 	if (cache != nullptr)
 		randomx_release_cache(cache);
 	cache = randomx_alloc_cache(RANDOMX_FLAG_DEFAULT);
@@ -1134,6 +1773,138 @@ int main() {
 		assert(equalsHex(hash3, "4d6b063a1a603751d525f18a171336a4002f2f06df6c17e4b25fe17e17796e42"));
 	});
 
+	runTest("Hash batch test (array)", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		alignas(16) char hashes[3 * RANDOMX_HASH_SIZE];
+
+		initCache("test key 000");
+
+		char input1[] = "This is a test";
+		char input2[] = "Lorem ipsum dolor sit amet";
+		char input3[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		const void* inputs[] = { input1, input2, input3 };
+		const size_t inputSizes[] = { sizeof(input1) - 1, sizeof(input2) - 1, sizeof(input3) - 1 };
+
+		randomx_destroy_vm(vm);
+#ifdef RANDOMX_FORCE_SECURE
+		vm = randomx_create_vm(RANDOMX_FLAG_JIT | RANDOMX_FLAG_SECURE, cache, nullptr);
+#else
+		vm = randomx_create_vm(RANDOMX_FLAG_JIT, cache, nullptr);
+#endif
+
+		randomx_calculate_hash_batch(vm, inputs, inputSizes, 3, hashes);
+
+		assert(equalsHex(hashes + 0 * RANDOMX_HASH_SIZE, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+		assert(equalsHex(hashes + 1 * RANDOMX_HASH_SIZE, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		assert(equalsHex(hashes + 2 * RANDOMX_HASH_SIZE, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+
+		randomx_calculate_hash_batch(vm, inputs + 2, inputSizes + 2, 1, hashes);
+		assert(equalsHex(hashes, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+
+		//equal-sized inputs share the multi-buffer input hash
+		char blobs[6][76] = {};
+		const void* blobInputs[6];
+		size_t blobSizes[6];
+		alignas(16) char blobHashes[6 * RANDOMX_HASH_SIZE];
+		for (int i = 0; i < 6; ++i) {
+			blobs[i][39] = (char)i;
+			blobInputs[i] = blobs[i];
+			blobSizes[i] = sizeof(blobs[i]);
+		}
+		randomx_calculate_hash_batch(vm, blobInputs, blobSizes, 6, blobHashes);
+		for (int i = 0; i < 6; ++i) {
+			randomx_calculate_hash(vm, blobs[i], sizeof(blobs[i]), hashes);
+			assert(memcmp(hashes, blobHashes + i * RANDOMX_HASH_SIZE, RANDOMX_HASH_SIZE) == 0);
+		}
+
+		randomx_destroy_vm(vm);
+#ifdef RANDOMX_FORCE_SECURE
+		vm = randomx_create_vm(RANDOMX_FLAG_V2 | RANDOMX_FLAG_JIT | RANDOMX_FLAG_SECURE, cache, nullptr);
+#else
+		vm = randomx_create_vm(RANDOMX_FLAG_V2 | RANDOMX_FLAG_JIT, cache, nullptr);
+#endif
+
+		randomx_calculate_hash_batch(vm, inputs, inputSizes, 3, hashes);
+
+		assert(equalsHex(hashes + 0 * RANDOMX_HASH_SIZE, "22ec6b861b3eb23686b2efbad69513c967ecfce80983df66c9c5b4fbfb4cdb6f"));
+		assert(equalsHex(hashes + 1 * RANDOMX_HASH_SIZE, "9e2c772c12fd48f93c14c97fdc89d556264d9100597023f44d9163e279012ecf"));
+		assert(equalsHex(hashes + 2 * RANDOMX_HASH_SIZE, "4d6b063a1a603751d525f18a171336a4002f2f06df6c17e4b25fe17e17796e42"));
+	});
+
+	runTest("Verification service", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		struct Result {
+			const char* expected;
+			bool matched;
+		};
+		Result results[] = {
+			{ "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f", false },
+			{ "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969", false },
+			{ "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8", false },
+		};
+		const char* inputs[] = {
+			"This is a test",
+			"Lorem ipsum dolor sit amet",
+			"sed do eiusmod tempor incididunt ut labore et dolore magna aliqua",
+		};
+		auto callback = [](void* userData, const void* hash) {
+			Result* result = (Result*)userData;
+			result->matched = hash != nullptr && equalsHex(hash, result->expected);
+		};
+
+		randomx_verify_service* service = randomx_create_verify_service(RANDOMX_FLAG_DEFAULT, 2, 1);
+		assert(service != nullptr);
+		for (int i = 0; i < 3; ++i) {
+			randomx_verify_service_submit(service, "test key 000", 12, inputs[i], strlen(inputs[i]), callback, &results[i]);
+		}
+		randomx_verify_service_wait(service);
+		assert(results[0].matched && results[1].matched && results[2].matched);
+
+		results[1].matched = false;
+		randomx_verify_service_submit(service, "test key 000", 12, inputs[1], strlen(inputs[1]), callback, &results[1]);
+		randomx_destroy_verify_service(service);
+		assert(results[1].matched);
+	});
+
+	runTest("Verification service VM creation failure", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		struct Result {
+			bool called;
+			bool matched;
+		};
+		//fails the first scratchpad allocation, so the first VM cannot be created
+		auto failingAlloc = [](void* userData, size_t size, size_t alignment, randomx_memory_kind kind) -> void* {
+			int* failures = (int*)userData;
+			if (kind == RANDOMX_MEMORY_SCRATCHPAD && *failures > 0) {
+				--*failures;
+				return nullptr;
+			}
+			return kind == RANDOMX_MEMORY_JIT ? allocMemoryPages(size) : rx_aligned_alloc(size, alignment);
+		};
+		auto failingFree = [](void*, void* ptr, size_t size, randomx_memory_kind kind) {
+			if (kind == RANDOMX_MEMORY_JIT)
+				freePagedMemory(ptr, size);
+			else
+				rx_aligned_free(ptr);
+		};
+		auto callback = [](void* userData, const void* hash) {
+			Result* result = (Result*)userData;
+			result->called = true;
+			result->matched = hash != nullptr && equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f");
+		};
+		int failures = 1;
+		const randomx_allocator allocator = { failingAlloc, failingFree, &failures };
+		Result results[2] = {};
+
+		randomx_verify_service* service = new randomx_verify_service(RANDOMX_FLAG_DEFAULT, 1, 1, &allocator);
+		randomx_verify_service_submit(service, "test key 000", 12, "This is a test", 14, callback, &results[0]);
+		randomx_verify_service_wait(service);
+		assert(results[0].called && !results[0].matched);
+		assert(failures == 0);
+
+		//the next job with the same key creates the VM again
+		randomx_verify_service_submit(service, "test key 000", 12, "This is a test", 14, callback, &results[1]);
+		randomx_destroy_verify_service(service);
+		assert(results[1].called && results[1].matched);
+	});
+
 	randomx_destroy_vm(vm);
 #ifdef RANDOMX_FORCE_SECURE
 	vm = randomx_create_vm(RANDOMX_FLAG_DEFAULT | RANDOMX_FLAG_SECURE, cache, nullptr);
@@ -1198,6 +1969,29 @@ int main() {
 
 	runTest("Hash test (compiler switch v1 <-> v2)", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), test_switch);
 
+	runTest("Interpreter matches compiler", RANDOMX_HAVE_COMPILER, []() {
+		const randomx_flags variants[] = { RANDOMX_FLAG_DEFAULT, RANDOMX_FLAG_V2 };
+		const randomx_flags aes = randomx_get_flags() & RANDOMX_FLAG_HARD_AES;
+		for (randomx_flags variant : variants) {
+#ifdef RANDOMX_FORCE_SECURE
+			variant |= RANDOMX_FLAG_SECURE;
+#endif
+			randomx_vm* interpreted = randomx_create_vm(variant | aes, cache, nullptr);
+			randomx_vm* compiled = randomx_create_vm(variant | aes | RANDOMX_FLAG_JIT, cache, nullptr);
+			assert(interpreted != nullptr && compiled != nullptr);
+			for (uint32_t nonce = 0; nonce < 16; ++nonce) {
+				char input[76] = { 0 };
+				store32(input + 39, nonce);
+				char hash1[RANDOMX_HASH_SIZE], hash2[RANDOMX_HASH_SIZE];
+				randomx_calculate_hash(interpreted, input, sizeof(input), hash1);
+				randomx_calculate_hash(compiled, input, sizeof(input), hash2);
+				assert(memcmp(hash1, hash2, sizeof(hash1)) == 0);
+			}
+			randomx_destroy_vm(interpreted);
+			randomx_destroy_vm(compiled);
+		}
+	});
+
 	if (cache != nullptr)
 		randomx_release_cache(cache);
 
@@ -116,6 +116,16 @@ inline void readFloatOption(const char* option, int argc, char** argv, double& o
 	out = defaultValue;
 }
 
+inline void readStringOption(const char* option, int argc, char** argv, const char*& out, const char* defaultValue) {
+	for (int i = 0; i < argc - 1; ++i) {
+		if (strcmp(argv[i], option) == 0) {
+			out = argv[i + 1];
+			return;
+		}
+	}
+	out = defaultValue;
+}
+
 inline void readInt(int argc, char** argv, int& out, int defaultValue) {
 	for (int i = 0; i < argc; ++i) {
 		if (*argv[i] != '-' && (out = atoi(argv[i])) > 0) {
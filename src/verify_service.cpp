@@ -0,0 +1,126 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include "verify_service.hpp"
+
+randomx_verify_service::randomx_verify_service(randomx_flags flags, unsigned threadCount, unsigned cacheCapacity, const randomx_allocator* vmAllocator)
+	: vmFlags((randomx_flags)(flags & ~RANDOMX_FLAG_FULL_MEM)), vmAllocator(vmAllocator), caches(flags, cacheCapacity) {
+	if (threadCount == 0) {
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	try {
+		for (unsigned i = 0; i < threadCount; ++i) {
+			workers.emplace_back(&randomx_verify_service::work, this);
+		}
+	}
+	catch (...) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		jobCondition.notify_all();
+		for (auto& worker : workers)
+			worker.join();
+		throw;
+	}
+}
+
+randomx_verify_service::~randomx_verify_service() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	jobCondition.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+void randomx_verify_service::submit(const void* key, size_t keySize, const void* input, size_t inputSize, randomx_verify_callback* callback, void* userData) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(Job{ std::string((const char*)key, keySize), std::string((const char*)input, inputSize), callback, userData });
+		pending++;
+	}
+	jobCondition.notify_one();
+}
+
+void randomx_verify_service::wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	doneCondition.wait(lock, [this]() { return pending == 0; });
+}
+
+void randomx_verify_service::work() {
+	randomx_vm* vm = nullptr;
+	randomx_cache* cache = nullptr;
+	std::string cacheKey;
+	alignas(16) uint8_t hash[RANDOMX_HASH_SIZE];
+
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		//pending jobs are finished before the service stops
+		jobCondition.wait(lock, [this]() { return stop || !jobs.empty(); });
+		if (jobs.empty())
+			break;
+		Job job = std::move(jobs.front());
+		jobs.pop_front();
+		lock.unlock();
+
+		//a failed VM creation is retried by the next job, even if it has the same key
+		if (vm == nullptr || cache == nullptr || cacheKey != job.key) {
+			randomx_cache* newCache = caches.acquire(job.key.data(), job.key.size());
+			if (newCache != nullptr) {
+				if (vm == nullptr)
+					vm = randomx_create_vm_ex(vmFlags, newCache, nullptr, vmAllocator);
+				else
+					randomx_vm_set_cache(vm, newCache);
+			}
+			if (cache != nullptr)
+				caches.release(cache);
+			cache = newCache;
+			cacheKey = job.key;
+		}
+		if (vm != nullptr && cache != nullptr) {
+			randomx_calculate_hash(vm, job.input.data(), job.input.size(), hash);
+			job.callback(job.userData, hash);
+		}
+		else {
+			job.callback(job.userData, nullptr);
+		}
+
+		lock.lock();
+		if (--pending == 0)
+			doneCondition.notify_all();
+	}
+	lock.unlock();
+
+	if (vm != nullptr)
+		randomx_destroy_vm(vm);
+	if (cache != nullptr)
+		caches.release(cache);
+}
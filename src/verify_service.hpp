@@ -0,0 +1,67 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "randomx.h"
+#include "cache_manager.hpp"
+
+/* Global namespace for C binding */
+class randomx_verify_service {
+public:
+	randomx_verify_service(randomx_flags flags, unsigned threadCount, unsigned cacheCapacity, const randomx_allocator* vmAllocator = nullptr);
+	~randomx_verify_service();
+	void submit(const void* key, size_t keySize, const void* input, size_t inputSize, randomx_verify_callback* callback, void* userData);
+	void wait();
+private:
+	struct Job {
+		std::string key;
+		std::string input;
+		randomx_verify_callback* callback;
+		void* userData;
+	};
+	void work();
+
+	const randomx_flags vmFlags;
+	const randomx_allocator* const vmAllocator;
+	randomx_cache_manager caches;
+	std::mutex mutex;
+	std::condition_variable jobCondition;
+	std::condition_variable doneCondition;
+	std::deque<Job> jobs;
+	size_t pending = 0;
+	bool stop = false;
+	std::vector<std::thread> workers;
+};
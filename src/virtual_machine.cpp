@@ -35,6 +35,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "blake2/blake2.h"
 #include "intrin_portable.h"
 #include "allocator.hpp"
+#include "dispatch.hpp"
 
 randomx_vm::~randomx_vm() {
 
@@ -97,9 +98,25 @@ namespace randomx {
 
 	alignas(16) volatile static rx_vec_i128 aesDummy;
 
+	template<class Allocator, bool softAes>
+	VmBase<Allocator, softAes>::VmBase(randomx_flags flags, const randomx_allocator* alloc) {
+		vmFlags = flags;
+		if (alloc != nullptr) {
+			allocator = *alloc;
+		}
+		if (!softAes && (flags & RANDOMX_FLAG_VAES)) {
+			vaes = &getDispatchTable().hardAes;
+		}
+	}
+
 	template<class Allocator, bool softAes>
 	VmBase<Allocator, softAes>::~VmBase() {
-		Allocator::freeMemory(scratchpad, ScratchpadSize);
+		if (allocator.alloc != nullptr) {
+			UserAllocator::freeMemory(allocator, scratchpad, ScratchpadSize, RANDOMX_MEMORY_SCRATCHPAD);
+		}
+		else {
+			Allocator::freeMemory(scratchpad, ScratchpadSize);
+		}
 	}
 
 	template<class Allocator, bool softAes>
@@ -113,29 +130,48 @@ namespace randomx {
 			rx_store_vec_i128((rx_vec_i128*)&aesDummy, tmp);
 		}
 #endif
-		scratchpad = (uint8_t*)Allocator::allocMemory(ScratchpadSize);
+		if (vaes != nullptr && vaes->hashAes1Rx4 == nullptr)
+			throw std::invalid_argument("VAES is not supported");
+		if (allocator.alloc != nullptr) {
+			scratchpad = (uint8_t*)UserAllocator::allocMemory(allocator, ScratchpadSize, CacheLineSize, RANDOMX_MEMORY_SCRATCHPAD);
+		}
+		else {
+			scratchpad = (uint8_t*)Allocator::allocMemory(ScratchpadSize, &scratchpadPageSize);
+		}
 	}
 
 	template<class Allocator, bool softAes>
 	void VmBase<Allocator, softAes>::getFinalResult(void* out, size_t outSize) {
-		hashAes1Rx4<softAes>(scratchpad, ScratchpadSize, &reg.a);
+		if (vaes != nullptr)
+			vaes->hashAes1Rx4(scratchpad, ScratchpadSize, &reg.a);
+		else
+			hashAes1Rx4<softAes>(scratchpad, ScratchpadSize, &reg.a);
 		blake2b(out, outSize, &reg, sizeof(RegisterFile), nullptr, 0);
 	}
 
 	template<class Allocator, bool softAes>
 	void VmBase<Allocator, softAes>::hashAndFill(void* out, size_t outSize, uint64_t *fill_state) {
-		hashAndFillAes1Rx4<softAes>((void*) getScratchpad(), ScratchpadSize, &reg.a, fill_state);
+		if (vaes != nullptr)
+			vaes->hashAndFillAes1Rx4((void*) getScratchpad(), ScratchpadSize, &reg.a, fill_state);
+		else
+			hashAndFillAes1Rx4<softAes>((void*) getScratchpad(), ScratchpadSize, &reg.a, fill_state);
 		blake2b(out, outSize, &reg, sizeof(RegisterFile), nullptr, 0);
 	}
 
 	template<class Allocator, bool softAes>
 	void VmBase<Allocator, softAes>::initScratchpad(void* seed) {
-		fillAes1Rx4<softAes>(seed, ScratchpadSize, scratchpad);
+		if (vaes != nullptr)
+			vaes->fillAes1Rx4(seed, ScratchpadSize, scratchpad);
+		else
+			fillAes1Rx4<softAes>(seed, ScratchpadSize, scratchpad);
 	}
 
 	template<class Allocator, bool softAes>
 	void VmBase<Allocator, softAes>::generateProgram(void* seed) {
-		fillAes4Rx4<softAes>(seed, sizeof(program), &program);
+		if (vaes != nullptr)
+			vaes->fillAes4Rx4(seed, sizeof(program), &program);
+		else
+			fillAes4Rx4<softAes>(seed, sizeof(program), &program);
 	}
 
 	template class VmBase<AlignedAllocator<CacheLineSize>, false>;
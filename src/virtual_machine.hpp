@@ -50,6 +50,9 @@ public:
 	const void* getScratchpad() {
 		return scratchpad;
 	}
+	size_t getScratchpadPageSize() const {
+		return scratchpadPageSize;
+	}
 	const randomx::Program& getProgram()
 	{
 		return program;
@@ -73,6 +76,8 @@ protected:
 	alignas(16) randomx::ProgramConfiguration config;
 	randomx::MemoryRegisters mem;
 	uint8_t* scratchpad = nullptr;
+	size_t scratchpadPageSize = 0;
+	randomx_allocator allocator = {};
 	union {
 		randomx_cache* cachePtr = nullptr;
 		randomx_dataset* datasetPtr;
@@ -86,10 +91,13 @@ public:
 
 namespace randomx {
 
+	struct AesKernels;
+
 	template<class Allocator, bool softAes>
 	class VmBase : public randomx_vm {
 	public:
-		explicit VmBase(randomx_flags flags) { vmFlags = flags; }
+		//the scratchpad is allocated from 'allocator' (if not null) instead of Allocator
+		explicit VmBase(randomx_flags flags, const randomx_allocator* allocator = nullptr);
 		~VmBase() override;
 		void allocate() override;
 		void initScratchpad(void* seed) override;
@@ -97,6 +105,8 @@ namespace randomx {
 		void hashAndFill(void* out, size_t outSize, uint64_t *fill_state) override;
 	protected:
 		void generateProgram(void* seed);
+		//VAES kernels with RANDOMX_FLAG_VAES, nullptr otherwise
+		const AesKernels* vaes = nullptr;
 	};
 
 }
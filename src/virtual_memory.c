@@ -43,7 +43,13 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 #ifndef MAP_ANONYMOUS
 #define MAP_ANONYMOUS MAP_ANON
 #endif
@@ -53,6 +59,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define PAGE_EXECUTE_READWRITE (PROT_READ | PROT_WRITE | PROT_EXEC)
 #endif
 
+#include <stdlib.h>
+#include <string.h>
 #include "virtual_memory.h"
 
 #if defined(USE_PTHREAD_JIT_WP) && defined(MAC_OS_VERSION_11_0) \
@@ -203,19 +211,224 @@ void setPagesRWX(void* ptr, size_t bytes) {
 	pageProtect(ptr, bytes, PAGE_EXECUTE_READWRITE, &errfunc);
 }
 
-void* allocLargePagesMemory(size_t bytes) {
-	void* mem;
-	char *errfunc;
+size_t getPageSize(void) {
 #if defined(_WIN32) || defined(__CYGWIN__)
-	if (setPrivilege("SeLockMemoryPrivilege", 1, &errfunc))
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+#else
+	return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+#if defined(__linux__)
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+#define HUGE_1GB ((size_t)1 << 30)
+
+static size_t defaultHugePageSize(void) {
+	static size_t size = 0;
+	if (size == 0) {
+		unsigned long kb = 0;
+		char line[128];
+		FILE* meminfo = fopen("/proc/meminfo", "r");
+		if (meminfo != NULL) {
+			while (fgets(line, sizeof(line), meminfo) != NULL) {
+				if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1)
+					break;
+			}
+			fclose(meminfo);
+		}
+		size = kb != 0 ? (size_t)kb * 1024 : 2 * 1024 * 1024;
+	}
+	return size;
+}
+
+static void* mapHugePages(void* addr, size_t bytes, int flags) {
+	void* mem = mmap(addr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE | flags, -1, 0);
+	return mem == MAP_FAILED ? NULL : mem;
+}
+
+/* The whole 1 GiB pages of the allocation are mapped at a 1 GiB aligned address,
+ * the remainder (e.g. the last 32 MiB of the dataset) uses the default huge pages
+ * or, if there are none left, normal pages.
+ */
+static void* alloc1GPagesMemory(size_t bytes, size_t* pageSize) {
+	size_t size = alignSize(bytes, getPageSize());
+	size_t bulk = size & ~(HUGE_1GB - 1);
+	size_t tail = size - bulk;
+	uint8_t* reserved;
+	uint8_t* mem;
+	void* tailMem;
+	reserved = (uint8_t*)mmap(NULL, size + HUGE_1GB, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (reserved == MAP_FAILED)
+		return NULL;
+	mem = (uint8_t*)(((uintptr_t)reserved + HUGE_1GB - 1) & ~(uintptr_t)(HUGE_1GB - 1));
+	if (mem != reserved)
+		munmap(reserved, mem - reserved);
+	munmap(mem + size, reserved + HUGE_1GB - mem);
+	if (mapHugePages(mem, bulk, MAP_FIXED | MAP_HUGE_1GB) == NULL) {
+		munmap(mem, size);
+		return NULL;
+	}
+	if (tail != 0) {
+		tailMem = NULL;
+		//freePagedMemory must not split a huge page of the tail
+		if (tail % defaultHugePageSize() == 0)
+			tailMem = mapHugePages(mem + bulk, tail, MAP_FIXED);
+		if (tailMem == NULL) {
+			tailMem = mmap(mem + bulk, tail, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+		}
+		if (tailMem == MAP_FAILED) {
+			munmap(mem, size);
+			return NULL;
+		}
+	}
+	*pageSize = HUGE_1GB;
+	return mem;
+}
+
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 14
+#endif
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+/* Returns 0 if transparent huge pages are disabled. */
+static size_t transparentHugePageSize(void) {
+	static size_t size = (size_t)-1;
+	if (size == (size_t)-1) {
+		char mode[64] = { 0 };
+		unsigned long pmdSize = 0;
+		FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+		if (file != NULL) {
+			if (fgets(mode, sizeof(mode), file) == NULL)
+				mode[0] = '\0';
+			fclose(file);
+		}
+		file = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+		if (file != NULL) {
+			if (fscanf(file, "%lu", &pmdSize) != 1)
+				pmdSize = 0;
+			fclose(file);
+		}
+		if (mode[0] == '\0' || strstr(mode, "[never]") != NULL)
+			size = 0;
+		else
+			size = pmdSize != 0 ? (size_t)pmdSize : 2 * 1024 * 1024;
+	}
+	return size;
+}
+
+/* Returns 1 if all huge page sized blocks of the mapping that contains 'mem' are
+ * backed by transparent huge pages (AnonHugePages in /proc/self/smaps). */
+static int backedByTransparentHugePages(const void* mem, size_t hugePageSize) {
+	char line[256];
+	unsigned long start = 0, end = 0, lo, hi, kb;
+	int lineStart = 1, found = 0, backed = 0;
+	FILE* file = fopen("/proc/self/smaps", "r");
+	if (file == NULL)
+		return 0;
+	while (fgets(line, sizeof(line), file) != NULL) {
+		//a long path is split by fgets, only the beginning of a line is parsed
+		int parse = lineStart;
+		lineStart = strchr(line, '\n') != NULL;
+		if (!parse)
+			continue;
+		//field names such as "Anonymous:" also match a partial "%lx"
+		if (sscanf(line, "%lx-%lx", &lo, &hi) == 2) {
+			if (found)
+				break;
+			start = lo;
+			end = hi;
+			found = start <= (uintptr_t)mem && (uintptr_t)mem < end;
+		}
+		else if (found && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+			unsigned long first = (start + hugePageSize - 1) & ~(unsigned long)(hugePageSize - 1);
+			unsigned long last = end & ~(unsigned long)(hugePageSize - 1);
+			backed = last > first && kb * 1024 >= last - first;
+			break;
+		}
+	}
+	fclose(file);
+	return backed;
+}
+#endif
+
+/* Allocates anonymous memory aligned to the transparent huge page size and asks
+ * the kernel to back it with huge pages. This needs no reserved hugetlb pages, but
+ * the kernel only uses huge pages while it can find free contiguous memory.
+ * If 'populate' is set, the memory is prefaulted (MADV_POPULATE_WRITE, Linux 5.14+)
+ * and 'pageSize' is set to the huge page size only if the kernel actually backed
+ * the memory with huge pages. Otherwise, 'pageSize' is the normal page size.
+ * Returns NULL if transparent huge pages are not available.
+ */
+void* allocTransparentHugePagesMemory(size_t bytes, size_t* pageSize, int populate) {
+#if defined(__linux__)
+	size_t hugePageSize = transparentHugePageSize();
+	size_t size = alignSize(bytes, getPageSize());
+	uint8_t* reserved;
+	uint8_t* mem;
+	size_t i;
+	if (hugePageSize == 0)
 		return NULL;
-	size_t pageMinimum = GetLargePageMinimum();
-	if (!pageMinimum) {
-		errfunc = "No large pages";
+	reserved = (uint8_t*)mmap(NULL, size + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (reserved == MAP_FAILED)
 		return NULL;
+	mem = (uint8_t*)(((uintptr_t)reserved + hugePageSize - 1) & ~(uintptr_t)(hugePageSize - 1));
+	if (mem != reserved)
+		munmap(reserved, mem - reserved);
+	munmap(mem + size, reserved + hugePageSize - mem);
+	if (madvise(mem, size, MADV_HUGEPAGE) != 0) {
+		munmap(mem, size);
+		return NULL;
+	}
+	//the kernel may still fall back to normal pages when the memory is faulted in,
+	//so the huge page size is only reported after checking the populated memory
+	*pageSize = getPageSize();
+	if (populate) {
+		//older kernels don't support MADV_POPULATE_WRITE
+		if (madvise(mem, size, MADV_POPULATE_WRITE) != 0) {
+			for (i = 0; i < size; i += getPageSize())
+				((volatile uint8_t*)mem)[i] = 0;
+		}
+		if (backedByTransparentHugePages(mem, hugePageSize))
+			*pageSize = hugePageSize;
 	}
-	mem = VirtualAlloc(NULL, alignSize(bytes, pageMinimum), MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+	return mem;
 #else
+	return NULL;
+#endif
+}
+
+/* Tries the largest pages first (on Linux: 1 GiB, the default hugetlb page size,
+ * transparent huge pages) and falls back to normal pages, so the allocation
+ * only fails if the system is out of memory. The page size that was actually
+ * obtained is stored in 'pageSize'.
+ */
+void* allocLargePagesMemory(size_t bytes, size_t* pageSize) {
+	void* mem;
+#if defined(_WIN32) || defined(__CYGWIN__)
+	char *errfunc;
+	size_t pageMinimum = 0;
+	mem = NULL;
+	if (!setPrivilege("SeLockMemoryPrivilege", 1, &errfunc))
+		pageMinimum = GetLargePageMinimum();
+	if (pageMinimum) {
+		mem = VirtualAlloc(NULL, alignSize(bytes, pageMinimum), MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+		*pageSize = pageMinimum;
+	}
+	if (mem == NULL) {
+		mem = VirtualAlloc(NULL, bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		*pageSize = getPageSize();
+	}
+#else
+	*pageSize = 2 * 1024 * 1024;
 #ifdef __APPLE__
 	mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
 #elif defined(__FreeBSD__)
@@ -223,8 +436,22 @@ void* allocLargePagesMemory(size_t bytes) {
 #elif defined(__OpenBSD__) || defined(__NetBSD__)
 	mem = MAP_FAILED; // OpenBSD does not support huge pages
 #else
-	mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+	mem = NULL;
+	if (bytes >= HUGE_1GB)
+		mem = alloc1GPagesMemory(bytes, pageSize);
+	if (mem == NULL) {
+		mem = mapHugePages(NULL, bytes, 0);
+		*pageSize = defaultHugePageSize();
+	}
+	if (mem == NULL)
+		mem = allocTransparentHugePagesMemory(bytes, pageSize, 1);
+	if (mem == NULL)
+		mem = MAP_FAILED;
 #endif
+	if (mem == MAP_FAILED) {
+		mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		*pageSize = getPageSize();
+	}
 	if (mem == MAP_FAILED)
 		mem = NULL;
 #endif
@@ -241,3 +468,244 @@ void freePagedMemory(void* ptr, size_t bytes) {
 	}
 #endif
 }
+
+/* Maps 'bytes' bytes of an existing file starting at 'offset' (must be a multiple
+ * of the allocation granularity). The mapping is private (copy-on-write), so writes
+ * are never propagated back to the file. Returns NULL if the file is too short.
+ */
+void* mapFileMemory(const char* path, size_t offset, size_t bytes) {
+	void* mem;
+#if defined(_WIN32) || defined(__CYGWIN__)
+	HANDLE file, mapping;
+	LARGE_INTEGER size;
+	unsigned long long off = offset;
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+	if (!GetFileSizeEx(file, &size) || (unsigned long long)size.QuadPart < off + bytes) {
+		CloseHandle(file);
+		return NULL;
+	}
+	mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL)
+		return NULL;
+	mem = MapViewOfFile(mapping, FILE_MAP_COPY, (DWORD)(off >> 32), (DWORD)off, bytes);
+	CloseHandle(mapping);
+#else
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) != 0 || (unsigned long long)st.st_size < (unsigned long long)offset + bytes) {
+		close(fd);
+		return NULL;
+	}
+	mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)offset);
+	close(fd);
+	if (mem == MAP_FAILED)
+		mem = NULL;
+#endif
+	return mem;
+}
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+static int writeFileBytes(HANDLE file, const void* buf, size_t size) {
+	const char* p = (const char*)buf;
+	while (size > 0) {
+		DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+		DWORD written;
+		if (!WriteFile(file, p, chunk, &written, NULL) || written == 0)
+			return 0;
+		p += written;
+		size -= written;
+	}
+	return 1;
+}
+#else
+static int writeFileBytes(int fd, const void* buf, size_t size) {
+	const char* p = (const char*)buf;
+	while (size > 0) {
+		ssize_t written = write(fd, p, size);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return 0;
+		p += written;
+		size -= (size_t)written;
+	}
+	return 1;
+}
+#endif
+
+/* Writes a file of 'fileSize' bytes with 'header' at the start and 'data' at 'dataOffset';
+ * the rest is zero. The file is written to path + ".tmp", flushed to disk and then renamed
+ * to 'path', so the file is either the previous version or the complete new one, and
+ * processes that have the previous version mapped are not affected.
+ * Returns 0 on failure; the temporary file is removed.
+ */
+int saveFileAtomic(const char* path, const void* header, size_t headerSize, size_t dataOffset, const void* data, size_t dataSize, size_t fileSize) {
+	static const char zeros[4096] = { 0 };
+	size_t pathSize = strlen(path);
+	size_t pos = 0;
+	int ok = 1;
+	char* tmpPath = (char*)malloc(pathSize + 5);
+	if (tmpPath == NULL)
+		return 0;
+	memcpy(tmpPath, path, pathSize);
+	memcpy(tmpPath + pathSize, ".tmp", 5);
+#if defined(_WIN32) || defined(__CYGWIN__)
+	HANDLE file = CreateFileA(tmpPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		free(tmpPath);
+		return 0;
+	}
+#define WRITE_BYTES(buf, size) writeFileBytes(file, buf, size)
+#else
+	int file = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (file < 0) {
+		free(tmpPath);
+		return 0;
+	}
+#define WRITE_BYTES(buf, size) writeFileBytes(file, buf, size)
+#endif
+	ok = WRITE_BYTES(header, headerSize);
+	pos = headerSize;
+	while (ok && pos < dataOffset) {
+		size_t chunk = dataOffset - pos < sizeof(zeros) ? dataOffset - pos : sizeof(zeros);
+		ok = WRITE_BYTES(zeros, chunk);
+		pos += chunk;
+	}
+	ok = ok && WRITE_BYTES(data, dataSize);
+	pos += dataSize;
+	while (ok && pos < fileSize) {
+		size_t chunk = fileSize - pos < sizeof(zeros) ? fileSize - pos : sizeof(zeros);
+		ok = WRITE_BYTES(zeros, chunk);
+		pos += chunk;
+	}
+#undef WRITE_BYTES
+#if defined(_WIN32) || defined(__CYGWIN__)
+	ok = ok && FlushFileBuffers(file);
+	ok = CloseHandle(file) && ok;
+	ok = ok && MoveFileExA(tmpPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+	if (!ok)
+		DeleteFileA(tmpPath);
+#else
+	ok = ok && fsync(file) == 0;
+	ok = close(file) == 0 && ok;
+	ok = ok && rename(tmpPath, path) == 0;
+	if (!ok)
+		unlink(tmpPath);
+#endif
+	free(tmpPath);
+	return ok;
+}
+
+void unmapFileMemory(void* ptr, size_t bytes) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+	UnmapViewOfFile(ptr);
+#else
+	if (ptr) {
+		munmap(ptr, bytes);
+	}
+#endif
+}
+
+/* Creates a named shared memory segment of 'bytes' bytes and maps it shared and writable.
+   Fails if a segment with the same name already exists. */
+void* createSharedMemory(const char* name, size_t bytes) {
+	void* mem;
+#if defined(_WIN32) || defined(__CYGWIN__)
+	HANDLE mapping;
+	unsigned long long size = bytes;
+	mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, name);
+	if (mapping == NULL)
+		return NULL;
+	if (GetLastError() == ERROR_ALREADY_EXISTS) {
+		CloseHandle(mapping);
+		return NULL;
+	}
+	/* the view keeps the named section alive */
+	mem = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, bytes);
+	CloseHandle(mapping);
+#elif defined(__ANDROID__)
+	(void)name;
+	(void)bytes;
+	mem = NULL;
+#else
+	int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0)
+		return NULL;
+	if (ftruncate(fd, (off_t)bytes) != 0) {
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+#if defined(__linux__)
+	/* ftruncate only sets the size: reserve the pages now, so a full /dev/shm fails here
+	   instead of raising SIGBUS when the segment is written */
+	int err = posix_fallocate(fd, 0, (off_t)bytes);
+	if (err != 0 && err != EINVAL && err != EOPNOTSUPP) {
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+#endif
+	mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED) {
+		shm_unlink(name);
+		return NULL;
+	}
+#if defined(__linux__)
+	/* effective if /sys/kernel/mm/transparent_hugepage/shmem_enabled is "advise" */
+	madvise(mem, bytes, MADV_HUGEPAGE);
+#endif
+#endif
+	return mem;
+}
+
+/* Maps an existing named shared memory segment read-only. Fails if the segment
+   does not exist or is smaller than 'bytes' bytes. */
+void* openSharedMemory(const char* name, size_t bytes) {
+	void* mem;
+#if defined(_WIN32) || defined(__CYGWIN__)
+	HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+	if (mapping == NULL)
+		return NULL;
+	mem = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, bytes);
+	CloseHandle(mapping);
+#elif defined(__ANDROID__)
+	(void)name;
+	(void)bytes;
+	mem = NULL;
+#else
+	struct stat st;
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) != 0 || (unsigned long long)st.st_size < (unsigned long long)bytes) {
+		close(fd);
+		return NULL;
+	}
+	mem = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED)
+		mem = NULL;
+#endif
+	return mem;
+}
+
+/* Removes the name of a shared memory segment. Existing mappings stay valid.
+   On Windows, the segment is removed when the last mapping is released. */
+int removeSharedMemory(const char* name) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+	(void)name;
+	return 1;
+#elif defined(__ANDROID__)
+	(void)name;
+	return 0;
+#else
+	return shm_unlink(name) == 0;
+#endif
+}
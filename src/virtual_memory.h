@@ -40,8 +40,16 @@ void* allocMemoryPages(size_t);
 void setPagesRW(void*, size_t);
 void setPagesRX(void*, size_t);
 void setPagesRWX(void*, size_t);
-void* allocLargePagesMemory(size_t);
+void* allocLargePagesMemory(size_t, size_t*);
+void* allocTransparentHugePagesMemory(size_t, size_t*, int);
+size_t getPageSize(void);
 void freePagedMemory(void*, size_t);
+void* mapFileMemory(const char*, size_t, size_t);
+void unmapFileMemory(void*, size_t);
+int saveFileAtomic(const char*, const void*, size_t, size_t, const void*, size_t, size_t);
+void* createSharedMemory(const char*, size_t);
+void* openSharedMemory(const char*, size_t);
+int removeSharedMemory(const char*);
 
 #ifdef __cplusplus
 }
@@ -35,7 +35,7 @@ namespace randomx {
 	static_assert(sizeof(RegisterFile) == 256, "Invalid alignment of struct randomx::RegisterFile");
 
 	template<class Allocator, bool softAes, bool secureJit>
-	CompiledVm<Allocator, softAes, secureJit>::CompiledVm(randomx_flags flags) : VmBase<Allocator, softAes>(flags) {
+	CompiledVm<Allocator, softAes, secureJit>::CompiledVm(randomx_flags flags, const randomx_allocator* allocator) : VmBase<Allocator, softAes>(flags, allocator), compiler(allocator) {
 		if (!secureJit) {
 			compiler.enableAll(); //make JIT buffer both writable and executable
 		}
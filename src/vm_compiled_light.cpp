@@ -36,6 +36,10 @@ namespace randomx {
 	void CompiledLightVm<Allocator, softAes, secureJit>::setCache(randomx_cache* cache) {
 		cachePtr = cache;
 		mem.memory = cache->memory;
+		//call the SuperscalarHash code compiled for the cache instead of compiling a private copy
+		if (cache->jit != nullptr && compiler.shareSuperscalarHash(*cache->jit)) {
+			return;
+		}
 		if (secureJit) {
 			compiler.enableWriting();
 		}
@@ -49,14 +53,32 @@ namespace randomx {
 	void CompiledLightVm<Allocator, softAes, secureJit>::run(void* seed) {
 		VmBase<Allocator, softAes>::generateProgram(seed);
 		randomx_vm::initialize();
+		LazyDataset* lazy = getLazyDataset(lazyDatasetPtr, cachePtr);
+		bool complete = lazy != nullptr && lazy->readyCount.load(std::memory_order_acquire) == DatasetSize / CacheLineSize;
 		if (secureJit) {
 			compiler.enableWriting();
 		}
-		compiler.generateProgramLight(program, config, datasetOffset);
+		if (complete) {
+			compiler.generateProgram(program, config);
+		}
+		else if (lazy != nullptr) {
+			compiler.generateProgramLazy(program, config, datasetOffset, lazyDatasetPtr->memory, lazy->bitmap.data(), &lazy->readyCount);
+		}
+		else {
+			compiler.generateProgramLight(program, config, datasetOffset);
+		}
 		if (secureJit) {
 			compiler.enableExecution();
 		}
-		CompiledVm<Allocator, softAes, secureJit>::execute();
+		if (complete) {
+			//all items are valid, so the program runs in the fast mode
+			mem.memory = lazyDatasetPtr->memory + datasetOffset;
+			CompiledVm<Allocator, softAes, secureJit>::execute();
+			mem.memory = cachePtr->memory;
+		}
+		else {
+			CompiledVm<Allocator, softAes, secureJit>::execute();
+		}
 	}
 
 	template class CompiledLightVm<AlignedAllocator<CacheLineSize>, false, false>;
@@ -45,9 +45,9 @@ namespace randomx {
 		void operator delete(void* ptr) {
 			AlignedAllocator<CacheLineSize>::freeMemory(ptr, sizeof(CompiledLightVm));
 		}
-		explicit CompiledLightVm(randomx_flags flags) : CompiledVm<Allocator, softAes, secureJit>(flags) {}
+		explicit CompiledLightVm(randomx_flags flags, const randomx_allocator* allocator = nullptr) : CompiledVm<Allocator, softAes, secureJit>(flags, allocator) {}
 		void setCache(randomx_cache* cache) override;
-		void setDataset(randomx_dataset* dataset) override { }
+		void setDataset(randomx_dataset* dataset) override { lazyDatasetPtr = dataset; }
 		void run(void* seed) override;
 
 		using CompiledVm<Allocator, softAes, secureJit>::mem;
@@ -56,6 +56,8 @@ namespace randomx {
 		using CompiledVm<Allocator, softAes, secureJit>::config;
 		using CompiledVm<Allocator, softAes, secureJit>::cachePtr;
 		using CompiledVm<Allocator, softAes, secureJit>::datasetOffset;
+	private:
+		randomx_dataset* lazyDatasetPtr = nullptr;
 	};
 
 	using CompiledLightVmDefault = CompiledLightVm<AlignedAllocator<CacheLineSize>, true, false>;
@@ -37,9 +37,21 @@ namespace randomx {
 		mem.memory = cache->memory;
 	}
 
+	template<class Allocator, bool softAes>
+	void InterpretedLightVm<Allocator, softAes>::run(void* seed) {
+		lazyDataset = getLazyDataset(lazyDatasetPtr, cachePtr) != nullptr ? lazyDatasetPtr : nullptr;
+		InterpretedVm<Allocator, softAes>::run(seed);
+	}
+
 	template<class Allocator, bool softAes>
 	void InterpretedLightVm<Allocator, softAes>::datasetRead(uint64_t address, int_reg_t(&r)[8]) {
 		uint32_t itemNumber = address / CacheLineSize;
+		if (lazyDataset != nullptr) {
+			const uint64_t* datasetLine = (const uint64_t*)getDatasetItemLazy(lazyDataset, itemNumber);
+			for (unsigned q = 0; q < 8; ++q)
+				r[q] ^= datasetLine[q];
+			return;
+		}
 		int_reg_t rl[8];
 		
 		initDatasetItem(cachePtr, (uint8_t*)rl, itemNumber);
@@ -47,12 +47,16 @@ namespace randomx {
 		void operator delete(void* ptr) {
 			AlignedAllocator<CacheLineSize>::freeMemory(ptr, sizeof(InterpretedLightVm));
 		}
-		explicit InterpretedLightVm(randomx_flags flags) : InterpretedVm<Allocator, softAes>(flags) {}
-		void setDataset(randomx_dataset* dataset) override { }
+		explicit InterpretedLightVm(randomx_flags flags, const randomx_allocator* allocator = nullptr) : InterpretedVm<Allocator, softAes>(flags, allocator) {}
+		void setDataset(randomx_dataset* dataset) override { lazyDatasetPtr = dataset; }
 		void setCache(randomx_cache* cache) override;
+		void run(void* seed) override;
 	protected:
 		void datasetRead(uint64_t address, int_reg_t(&r)[8]) override;
 		void datasetPrefetch(uint64_t address) override { }
+	private:
+		randomx_dataset* lazyDatasetPtr = nullptr;
+		randomx_dataset* lazyDataset = nullptr;
 	};
 
 	using InterpretedLightVmDefault = InterpretedLightVm<AlignedAllocator<CacheLineSize>, true>;
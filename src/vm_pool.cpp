@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include "vm_pool.hpp"
+#include "allocator.hpp"
+#include "common.hpp"
+#include "virtual_memory.h"
+
+randomx_vm_pool::randomx_vm_pool(randomx_flags flags, randomx_cache* cache, randomx_dataset* dataset, unsigned size)
+	: size(std::max(size, 1u)) {
+	try {
+		slab = (uint8_t*)randomx::LargePageAllocator::allocMemory(this->size * randomx::ScratchpadSize, &pageSize);
+		const randomx_allocator allocator = { &allocMemory, &freeMemory, this };
+		machines.reserve(this->size);
+		for (unsigned i = 0; i < this->size; ++i) {
+			randomx_vm* machine = randomx_create_vm_ex(flags, cache, dataset, &allocator);
+			if (machine == nullptr)
+				throw std::bad_alloc();
+			machines.push_back(machine);
+		}
+	}
+	catch (std::exception &ex) {
+		destroy();
+		throw;
+	}
+	available = machines;
+}
+
+randomx_vm_pool::~randomx_vm_pool() {
+	assert(available.size() == machines.size());
+	destroy();
+}
+
+void randomx_vm_pool::destroy() {
+	for (randomx_vm* machine : machines) {
+		randomx_destroy_vm(machine);
+	}
+	machines.clear();
+	if (slab != nullptr) {
+		randomx::LargePageAllocator::freeMemory(slab, size * randomx::ScratchpadSize);
+		slab = nullptr;
+	}
+}
+
+randomx_vm* randomx_vm_pool::acquire() {
+	std::unique_lock<std::mutex> lock(mutex);
+	if (available.empty()) {
+		misses++;
+		availableCondition.wait(lock, [this]() { return !available.empty(); });
+	}
+	else {
+		hits++;
+	}
+	//the most recently released machine is the most likely to be in the CPU caches
+	randomx_vm* machine = available.back();
+	available.pop_back();
+	return machine;
+}
+
+randomx_vm* randomx_vm_pool::tryAcquire() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (available.empty()) {
+		misses++;
+		return nullptr;
+	}
+	hits++;
+	randomx_vm* machine = available.back();
+	available.pop_back();
+	return machine;
+}
+
+void randomx_vm_pool::release(randomx_vm* machine) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		assert(std::find(machines.begin(), machines.end(), machine) != machines.end());
+		assert(std::find(available.begin(), available.end(), machine) == available.end());
+		available.push_back(machine);
+	}
+	availableCondition.notify_one();
+}
+
+void randomx_vm_pool::getStats(randomx_vm_pool_stats* stats) {
+	std::lock_guard<std::mutex> lock(mutex);
+	stats->hits = hits;
+	stats->misses = misses;
+	stats->size = size;
+	stats->available = (unsigned)available.size();
+	stats->pageSize = pageSize;
+}
+
+//The virtual machines are created by the constructor, so the scratchpads
+//are handed out in order and never returned to the slab.
+void* randomx_vm_pool::allocMemory(void* userData, size_t size, size_t alignment, randomx_memory_kind kind) {
+	randomx_vm_pool* pool = (randomx_vm_pool*)userData;
+	if (kind == RANDOMX_MEMORY_JIT)
+		return allocMemoryPages(size);
+	assert(kind == RANDOMX_MEMORY_SCRATCHPAD && size == randomx::ScratchpadSize);
+	assert(randomx::ScratchpadSize % alignment == 0);
+	(void)alignment;
+	if (pool->nextScratchpad >= pool->size)
+		return nullptr;
+	return pool->slab + (size_t)pool->nextScratchpad++ * randomx::ScratchpadSize;
+}
+
+void randomx_vm_pool::freeMemory(void*, void* ptr, size_t size, randomx_memory_kind kind) {
+	if (kind == RANDOMX_MEMORY_JIT)
+		freePagedMemory(ptr, size);
+}
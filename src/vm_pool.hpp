@@ -0,0 +1,61 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "randomx.h"
+
+/* Global namespace for C binding */
+class randomx_vm_pool {
+public:
+	randomx_vm_pool(randomx_flags flags, randomx_cache* cache, randomx_dataset* dataset, unsigned size);
+	~randomx_vm_pool();
+	randomx_vm* acquire();
+	randomx_vm* tryAcquire();
+	void release(randomx_vm* machine);
+	void getStats(randomx_vm_pool_stats* stats);
+private:
+	//allocator callbacks of the virtual machines; the scratchpads are carved out of the slab
+	static void* allocMemory(void* userData, size_t size, size_t alignment, randomx_memory_kind kind);
+	static void freeMemory(void* userData, void* ptr, size_t size, randomx_memory_kind kind);
+	void destroy();
+
+	const unsigned size;
+	uint8_t* slab = nullptr;
+	size_t pageSize = 0;
+	unsigned nextScratchpad = 0;
+	std::vector<randomx_vm*> machines;
+	std::vector<randomx_vm*> available;
+	std::mutex mutex;
+	std::condition_variable availableCondition;
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+};